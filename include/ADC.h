@@ -14,6 +14,8 @@
 #define ADC_H
 
 #include "MKL25Z4.h"
+#include "fft.h"
+#include "timer.h"
 
 /****************************************************************************** 
  * Global definitions
@@ -55,6 +57,44 @@
 #define AVGS_16           0x02
 #define AVGS_32           0x03
 
+/* 1 - conversions are moved to a raw buffer by DMA0 channel 0, CPU is 
+       interrupted once per ADC_DMA_BLOCK samples (DMA0_IRQHandler),
+   0 - ADC0 interrupt for every sample */
+#ifndef ADC_USE_DMA
+#define ADC_USE_DMA              (0)
+#endif
+
+/* samples moved by DMA between two interrupts (two blocks are used) */
+#ifndef ADC_DMA_BLOCK
+#define ADC_DMA_BLOCK            (FFT_HOP_SIZE)
+#endif
+
+/* DMAMUX request source of ADC0 */
+#define ADC_DMAMUX_SOURCE        (40)
+
+/* time constant of the DC offset tracker: 2^ADC_DC_SHIFT samples, 12 gives 
+   about 0.1 s (-3 dB at 1.6 Hz) at 40 kHz, far below the lowest bin */
+#ifndef ADC_DC_SHIFT
+#define ADC_DC_SHIFT             (12)
+#endif
+
+/* duration of every ADC0 (or DMA0) interrupt is measured with SysTick and
+   counted by diag.h; 1 - all modes are run at boot and the longest interrupt
+   is printed against the budget */
+#ifndef ADC_MEASURE_CYCLES
+#define ADC_MEASURE_CYCLES       (0)
+#endif
+
+/* core clock cycles available for one interrupt: one sample period, with 
+   ADC_USE_DMA the interrupt comes once per block of ADC_DMA_BLOCK samples */
+#if ADC_USE_DMA
+#define ADC_CYCLE_BUDGET         (TIMER_CLOCK_HZ/FFT_SAMPLE_RATE*ADC_DMA_BLOCK)
+#else
+#define ADC_CYCLE_BUDGET         (TIMER_CLOCK_HZ/FFT_SAMPLE_RATE)
+#endif
+/* exception entry and exit not seen by the measurement (Cortex-M0+) */
+#define ADC_IRQ_OVERHEAD         (32)
+
 /****************************************************************************** 
  * Function declarations
  ******************************************************************************/
@@ -65,4 +105,16 @@
  */
 uint8_t ADC_Init(void);
 
+/**
+ * @brief Start conversions on channel 8, triggered by PIT0 (and DMA transfers
+ *        with ADC_USE_DMA).
+ */
+void ADC_Start(void);
+
+/**
+ * @brief  Current estimate of the constant value of the sampled signal.
+ * @return DC offset in ADC units
+ */
+uint16_t ADC_GetDcEstimate(void);
+
 #endif /* ADC_H */
\ No newline at end of file
@@ -25,6 +25,7 @@
  * @note  R1 on keyboard is R4 here etc.
  */
 typedef enum { 
+    BUT_R3A13 = 13, 
     BUT_R2A12 = 12, 
     BUT_R1A5  = 5, 
     BUT_C4C0  = 0,
@@ -42,4 +43,12 @@ typedef enum {
  */
 void buttons_Initialize(void);
 
+/**
+ * @brief  Check if a key has been pressed since the last call. Keypad 
+ *         interrupt only sets a flag, the main loop drops frames of the old
+ *         mode and resets the FFT history, levels and the display.
+ * @return 1 if the mode screen (or diagnostics) has been shown, 0 otherwise
+ */
+uint8_t buttons_ModeChanged(void);
+
 #endif /* BUTTONS_H */
@@ -0,0 +1,78 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   dft.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for sample-by-sample DFT of the 16 bins
+ *         displayed in modes 2-8 (modes with one bin per column).
+ * @ver    0.1
+ */
+
+#ifndef DFT_H
+#define DFT_H
+
+#include "fft.h"
+
+/******************************************************************************
+ * Global definitions
+ ******************************************************************************/
+
+/* number of bins calculated by the engine (one per LCD column) */
+#define DFT_BINS                 (16)
+/* number of frames accumulated at the same time (overlap) */
+#define DFT_FRAMES               (FFT_SIZE/FFT_HOP_SIZE)
+
+/* DFT_Push takes about 25 core cycles per bin of every frame (instructions
+   of dft_accumulate on Cortex-M0+), i.e. ~440 cycles per frame; with the 
+   rest of ADC0 interrupt two frames fit in the sample period of 1200 cycles
+   (ADC_CYCLE_BUDGET), four frames of 75% overlap do not */
+#if FFT_DFT_BINS && DFT_FRAMES > 2
+#error "FFT_DFT_BINS needs FFT_HOP_SIZE of FFT_SIZE or FFT_SIZE/2, set FFT_DFT_BINS to 0 for more overlap"
+#endif
+
+/******************************************************************************
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief     Accumulate one sample into all DFT bins of all overlapping frames.
+ *            Called from ADC0 interrupt for every stored sample. A new frame
+ *            for bins of the current mode starts every FFT_HOP_SIZE samples.
+ * @param[in] Sample with removed constant value (ADC units)
+ */
+void DFT_Push(int16_t sample);
+
+/**
+ * @brief     Store frame finished with the last sample as a result for given
+ *            buffer.
+ * @param[in] Buffer number: 0 to FFT_BUFFERS-1
+ */
+void DFT_Latch(uint8_t bufferNumber);
+
+/**
+ * @brief     Check if latched result can be used instead of FFT.
+ * @param[in] Buffer number: 0 to FFT_BUFFERS-1
+ * @param[in] Current mode
+ * @return    1 if result was calculated for bins of given mode, 0 otherwise
+ */
+uint8_t DFT_IsValid(uint8_t bufferNumber, uint8_t mode);
+
+/**
+ * @brief     Binary logarithm of the power of a latched bin.
+ * @param[in] Buffer number: 0 to FFT_BUFFERS-1
+ * @param[in] Column number: 0 to DFT_BINS-1
+ * @return    log2(re^2+im^2) in Q8 format, float16_t pipeline scale
+ */
+int32_t DFT_BinLog2Power(uint8_t bufferNumber, uint8_t col);
+
+/**
+ * @brief Drop frames being accumulated and latched results, e.g. after the
+ *        window function was changed; a new frame starts every FFT_HOP_SIZE
+ *        samples as usual.
+ */
+void DFT_Reset(void);
+
+#endif /* DFT_H */
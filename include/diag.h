@@ -0,0 +1,76 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   diag.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for always-on diagnostic counters of
+ *         the sampling and processing path.
+ * @ver    0.1
+ */
+
+#ifndef DIAG_H
+#define DIAG_H
+
+#include "MKL25Z4.h"
+
+/****************************************************************************** 
+ * Global definitions
+ ******************************************************************************/
+
+/* average interrupt duration is an exponential average of 2^DIAG_AVG_SHIFT
+   interrupts */
+#define DIAG_AVG_SHIFT           (6)
+
+/****************************************************************************** 
+ * Global structs
+ ******************************************************************************/
+
+/**
+ * @brief snapshot of diagnostic counters
+ */
+typedef struct {
+    uint32_t framesProcessed;  /* frames processed by the main loop */
+    uint32_t droppedFrames;    /* frames overwritten before processing */
+    uint32_t droppedSamples;   /* samples dropped with all buffers occupied */
+    uint32_t isrCyclesMax;     /* longest sampling interrupt */
+    uint32_t isrCyclesAvg;     /* average sampling interrupt */
+    uint32_t isrOverBudget;    /* interrupts longer than ADC_CYCLE_BUDGET */
+    uint32_t i2cErrors;        /* background I2C transactions which failed */
+} DiagCounters;
+
+/****************************************************************************** 
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief     Count duration of a sampling interrupt (ADC0 or DMA0).
+ * @param[in] Core clock cycles, including entry and exit
+ */
+void DIAG_IsrCycles(uint32_t cycles);
+
+/**
+ * @brief Count frame processed by the main loop.
+ */
+void DIAG_FrameProcessed(void);
+
+/**
+ * @brief      Read all counters.
+ * @param[out] Snapshot of the counters
+ */
+void DIAG_Get(DiagCounters *counters);
+
+/**
+ * @brief Start all counters from zero.
+ */
+void DIAG_Reset(void);
+
+/**
+ * @brief Print counters on the LCD: frames on the first screen, interrupt
+ *        duration on the second one, I2C errors on the third one.
+ */
+void DIAG_Print(void);
+
+#endif /* DIAG_H */
@@ -0,0 +1,110 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   display.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for the queue of frames waiting for
+ *         the LCD. A frame is printed when the previous one has been sent
+ *         (in the background), so the next frame can be calculated meanwhile.
+ * @ver    0.1
+ */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <stdint.h>
+
+/****************************************************************************** 
+ * Global definitions
+ ******************************************************************************/
+
+/* number of columns in a frame (one level per column) */
+#define DISPLAY_COLUMNS          (16)
+
+/* number of frames waiting for the LCD */
+#ifndef DISPLAY_FRAMES
+#define DISPLAY_FRAMES           (2)
+#endif
+
+/* what happens with frames waiting when the LCD is free */
+#define DISPLAY_SHOW_ALL         (0)    /* printed in order */
+#define DISPLAY_SHOW_NEWEST      (1)    /* older frames are dropped */
+#ifndef DISPLAY_POLICY
+#define DISPLAY_POLICY           DISPLAY_SHOW_NEWEST
+#endif
+
+/* times below are in milliseconds, they are converted to frames for the 
+   frame rate of the current mode (DISPLAY_SetFrameRate) */
+
+/* 1 - levels are smoothed before they are drawn: a bar rises at once and 
+       falls one level every DISPLAY_DECAY_MS, so a level flickering between
+       two values does not rewrite the column every frame */
+#ifndef DISPLAY_SMOOTH
+#define DISPLAY_SMOOTH           (1)
+#endif
+#ifndef DISPLAY_DECAY_MS
+#define DISPLAY_DECAY_MS         (13)
+#endif
+/* 1 - a drop by one level is shown only if it lasts DISPLAY_HYSTERESIS_MS
+       (one-level hysteresis band) */
+#ifndef DISPLAY_HYSTERESIS
+#define DISPLAY_HYSTERESIS       (1)
+#endif
+#ifndef DISPLAY_HYSTERESIS_MS
+#define DISPLAY_HYSTERESIS_MS    (100)
+#endif
+
+/* 1 - peak of each column is marked above the bar, it is held for 
+   DISPLAY_PEAK_HOLD_MS and then falls one level every DISPLAY_PEAK_FALL_MS */
+#ifndef DISPLAY_PEAK_HOLD
+#define DISPLAY_PEAK_HOLD        (1)
+#endif
+#ifndef DISPLAY_PEAK_HOLD_MS
+#define DISPLAY_PEAK_HOLD_MS     (500)
+#endif
+#ifndef DISPLAY_PEAK_FALL_MS
+#define DISPLAY_PEAK_FALL_MS     (50)
+#endif
+
+/****************************************************************************** 
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief     Smooth levels of a calculated frame and put it in the queue. If 
+ *            the queue is full, the newest waiting frame is replaced 
+ *            (coalesced).
+ * @param[in] Column levels: 0-16
+ */
+void DISPLAY_Submit(const uint8_t *levels);
+
+/**
+ * @brief  Print the next frame if the LCD is not busy with the previous one,
+ *         characters are sent in the background.
+ * @return 1 if a frame has been printed, 0 otherwise
+ */
+uint8_t DISPLAY_Service(void);
+
+/**
+ * @brief Drop all waiting frames, smoothed levels and peaks (display has been
+ *        cleared).
+ */
+void DISPLAY_Reset(void);
+
+/**
+ * @brief     Convert smoothing and peak times to frames for the frame rate of
+ *            the current mode.
+ * @param[in] Frames per second (FFT_MODE_FRAME_RATE)
+ */
+void DISPLAY_SetFrameRate(uint16_t framesPerSecond);
+
+/**
+ * @brief  Number of frames dropped because a newer one was waiting.
+ * @return Coalesced frames
+ */
+uint32_t DISPLAY_GetCoalesced(void);
+
+#endif /* DISPLAY_H */
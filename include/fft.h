@@ -13,8 +13,8 @@
 #ifndef FFT_H
 #define FFT_H
 
+#include "arm_math.h"
 #include "arm_math_types_f16.h"
-#include "math.h"
 
 /******************************************************************************
  * Global definitions
@@ -23,63 +23,160 @@
 /* size of a FFT, must be 2^N, where N is a positive integer */
 #define FFT_SIZE                 (256)
 
-#define BUFFER_0                 (0)
-#define BUFFER_1                 (1)
+/* spectrum pipeline: 1 - fixed-point Q15 (integer only, fast on Cortex-M0+),
+                      0 - float16_t (software emulated floating point) */
+#ifndef FFT_FIXED_POINT
+#define FFT_FIXED_POINT          (1)
+#endif
+
+/* 1 - bins of modes 4-8 are calculated by DFT while sampling (dft.h), 
+       FFT is calculated only in modes 1-3 */
+#ifndef FFT_DFT_BINS
+#define FFT_DFT_BINS             (1)
+#endif
+
+/* sample rate set by PIT_Initialize in main.c */
+#define FFT_SAMPLE_RATE          (40000)
+
+/* number of new samples between two FFTs (buffer size), older samples are
+   reused from history: FFT_SIZE - no overlap, FFT_SIZE/2 - 50% overlap,
+   FFT_SIZE/4 - 75% overlap (only with FFT_DFT_BINS 0, see dft.h); must 
+   divide FFT_SIZE */
+#ifndef FFT_HOP_SIZE
+#define FFT_HOP_SIZE             (FFT_SIZE/2)
+#endif
+
+/* calculated frames per second at the full sample rate (mode 1, modes 4-8)
+   and in a mode with lower sample rate (FFT_Modes) */
+#define FFT_FRAME_RATE           (FFT_SAMPLE_RATE/FFT_HOP_SIZE)
+#define FFT_MODE_FRAME_RATE(m)   (FFT_FRAME_RATE >> FFT_Modes[m].decimationShift)
+
+/* 1 - window function is applied in ADC0 interrupt while a sample is stored,
+       so a full buffer is ready for FFT without a separate pass; possible
+       only without overlap (every sample has one position in a frame), so 
+       it is 0 in the default build (50% overlap): FFT_ProcessBuffer windows
+       the frame of modes 1-3, modes 4-8 get windowed bins from the DFT 
+       engine in the interrupt (FFT_DFT_BINS) */
+#ifndef FFT_WINDOW_IN_ISR
+#define FFT_WINDOW_IN_ISR        (FFT_HOP_SIZE == FFT_SIZE)
+#endif
+
+/* number of sample buffers (slots of the queue between ADC and main loop, 
+   see QUEUE_POLICY in queue.h); while the main loop prints the columns, 
+   FFT_BUFFERS-1 buffers can be filled without losing samples */
+#ifndef FFT_BUFFERS
+#define FFT_BUFFERS              (3)
+#endif
 
 /* simple delay */
 #define FFT_DELAY(x)             for(volatile uint32_t i=0;i<(x*10000);i++)
 
-/* typical max value of a sample, used to normalize frequency bins */
-#define FFT_AVG_MAX_VALUE        (3.5)
-/* average value of a sampled signal, used to delete constant value of a signal */
+/* average value of a sampled signal, starting point of the DC offset tracker
+   in ADC0 interrupt (ADC_DC_SHIFT) which follows the amplifier bias drift */
 #define FFT_AVG_VALUE            (2681)  
+
+/* 12-bit samples are shifted left to use the Q15 range with some headroom */
+#define FFT_Q15_SHIFT            (3)
+
+/* samples are captured as packed Q15 in both pipelines, conversion to 
+   float16_t (if any) is done for a whole frame in FFT_ProcessBuffer */
+typedef q15_t fft_capture_t;
+/* convert sample with removed constant value (ADC units) to a captured one */
+#define FFT_TO_SAMPLE(x)         ((q15_t)((x)*(1<<FFT_Q15_SHIFT)))
+/* multiply captured sample by a Q15 window coefficient */
+#define FFT_WINDOW_SAMPLE(x, w)  ((q15_t)(((int32_t)(x)*(w)) >> 15))
+
+#if FFT_FIXED_POINT
+/* Q15 FFT output multiplied by this value is equal to the float16_t one
+   (rfft_q15 scales by 1/FFT_SIZE, input is scaled by 2^FFT_Q15_SHIFT) */
+#define FFT_Q15_BIN_SCALE        (FFT_SIZE/(1<<FFT_Q15_SHIFT))
+
+typedef q15_t fft_sample_t;
+/* convert captured sample to a FFT sample */
+#define FFT_FROM_CAPTURE(x)      (x)
+#else
+typedef float16_t fft_sample_t;
+/* convert captured sample to a FFT sample (ADC units) */
+#define FFT_FROM_CAPTURE(x)      ((float16_t)(x)*(float16_t)(1.0f/(1<<FFT_Q15_SHIFT)))
+#endif
+
+/* RAM taken by the sample buffers and the DFT results latched for each of 
+   them (KL25Z128 has 16 KB of SRAM), e.g. Q15 with 50% overlap: 
+   2 buffers - 770 B, 3 buffers - 1155 B, 4 buffers - 1540 B */
+#define FFT_BUFFERS_RAM          (FFT_BUFFERS*(FFT_HOP_SIZE*sizeof(fft_capture_t) \
+                                  + 2*16*sizeof(int32_t) + 1))
+
+/* number of modes (keys SW1-SW8) */
+#define FFT_MODES                (8)
  
 /******************************************************************************
  * Global variable declarations
  ******************************************************************************/
 
-/* struct with necessary FFT status flags */
+/* struct with necessary FFT status flags, buffers are passed from ADC to the
+   main loop by the queue (queue.h) */
 typedef struct {
-    uint8_t readToBuffer0:1;
-    uint8_t readToBuffer1:1; 
-    uint8_t isBuffer0Ready:1; 
-    uint8_t isBuffer1Ready:1; 
     uint8_t mode:4;
 } FFT_Flags;
 
 extern FFT_Flags FFTstatus;
 
+/* struct describing frequency range of a mode */
+typedef struct {
+    uint8_t  decimationShift;  /* sample rate = 40 kHz >> decimationShift */
+    uint8_t  binsPerColumn;    /* bins summed into one LCD column */
+    uint16_t firstBin;         /* lowest bin of the first column */
+} FFT_ModeInfo;
+
+/* indexed by mode number (1-8), entry 0 is not used; columns of mode 1 are
+   described in FFT_CalculateColumns_256 */
+extern const FFT_ModeInfo FFT_Modes[FFT_MODES+1];
+
 /* FFT buffers */
-extern float16_t FFT_Buffer[2][FFT_SIZE];
-extern float16_t FFT_Output[2*FFT_SIZE];
+extern fft_capture_t FFT_Buffer[FFT_BUFFERS][FFT_HOP_SIZE];
+extern fft_sample_t FFT_Output[2*FFT_SIZE];
 extern uint8_t FrequencyBins[16];
-extern uint8_t oldBins[16];
-
-/* FFT window ceofficients */ 
-extern const float16_t Hann_Window[FFT_SIZE];
-extern const float16_t Blackman_Harris_Window[FFT_SIZE];
 
 /******************************************************************************
  * Function declarations
  ******************************************************************************/
 
 /**
- * @brief       Calculate column length for choosen frequencies.
- * @param[in]   Buffer number (0 or 1)
+ * @brief  Initialize FFT instance for the selected pipeline.
+ * @return ARM_MATH_SUCCESS or error status.
+ */
+arm_status FFT_Init(void);
+
+/**
+ * @brief Forget the sample history, e.g. after frames were lost by the queue.
+ *        With overlap no FFT is calculated until FFT_SIZE new samples have 
+ *        been collected.
+ */
+void FFT_ResetHistory(void);
+
+/**
+ * @brief     Append buffer to the sample history, apply window on the last 
+ *            FFT_SIZE samples, calculate FFT and column lengths. With 
+ *            FFT_WINDOW_IN_ISR the buffer is already windowed and is used 
+ *            directly as FFT input (its content is destroyed).
+ * @param[in] Buffer number: 0 to FFT_BUFFERS-1
+ * @return    1 if FrequencyBins were calculated, 0 if the history is not
+ *            filled yet (see FFT_ResetHistory)
+ */
+uint8_t FFT_ProcessBuffer(uint8_t bufferNumber);
+
+/**
+ * @brief       Calculate column length for choosen frequencies from FFT_Output.
  * @descritpion Frequencies on given columns are respectively:
  * 
  * For Mode 1:
- *  [1] [2] [3] [4] [5] [6]  [7]  [8]  [9] [10] [11] [12] [13] [14]  [15]  [16] 
- * |156|312|469|625|781|938|1094|1250|1407|2500|3750|5000|7031|9062|12031|14844|
+ * half-octave bands from 80 Hz to 20 kHz, each column sums power of all bins 
+ * in its band (bands narrower than a bin get one bin)
  *   
  * For Mode 2-8:
- * ((Mode-2)*16+N+1)*156, where N is integer in range 0-15 
- */
-void FFT_CalculateColumns_256(uint8_t bufferNumber);
-
-/**
- * @brief Print frequency bin columns on LCD
+ * ((Mode-2)*16+N+1)*156, where N is integer in range 0-15, each column sums
+ * FFT_Modes[Mode].binsPerColumn bins 
  */
-void FFT_PrintColumns(void);
+void FFT_CalculateColumns_256(void);
 
 #endif /* FFT_H */
\ No newline at end of file
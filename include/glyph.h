@@ -0,0 +1,72 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   glyph.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for the manager of LCD custom 
+ *         characters. Bar glyphs (fill and peak marker) are composed on 
+ *         demand and kept in the eight CGRAM slots, least recently used slot
+ *         is rewritten when a frame needs a glyph which is not loaded.
+ * @ver    0.1
+ */
+
+#ifndef GLYPH_H
+#define GLYPH_H
+
+#include <stdint.h>
+
+/****************************************************************************** 
+ * Global definitions
+ ******************************************************************************/
+
+/* number of custom characters of HD44780 */
+#define GLYPH_SLOTS              (8)
+/* strips (pixel rows) in one character */
+#define GLYPH_STRIPS             (8)
+
+/* 1 - character 0xFF of the LCD ROM (A00) is a full block and does not 
+   take a slot, 0 - full block is a custom character too */
+#ifndef GLYPH_ROM_BLOCK
+#define GLYPH_ROM_BLOCK          (1)
+#endif
+
+/* glyphs with peak marker loaded in one frame at most (bars are always 
+   loaded), limits I2C traffic when there are more glyphs than slots */
+#ifndef GLYPH_PEAK_UPLOADS
+#define GLYPH_PEAK_UPLOADS       (2)
+#endif
+
+/****************************************************************************** 
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief Forget loaded characters, slots 0-7 hold bars of 1-8 strips (loaded
+ *        by LCD1602_LVL_CH).
+ */
+void GLYPH_Reset(void);
+
+/**
+ * @brief Start a new frame, slots used in this frame are not rewritten until
+ *        the next one.
+ */
+void GLYPH_BeginFrame(void);
+
+/**
+ * @brief     Character of a bar cell, glyph is loaded to CGRAM if needed.
+ * @param[in] Filled strips from the bottom: 0-8
+ * @param[in] Strip with peak marker: 1-8, 0 - no marker
+ * @return    Character code for the display
+ */
+char GLYPH_Get(uint8_t fill, uint8_t peak);
+
+/**
+ * @brief  Number of characters loaded to CGRAM since reset.
+ * @return Uploads
+ */
+uint32_t GLYPH_GetUploads(void);
+
+#endif /* GLYPH_H */
@@ -22,6 +22,25 @@
 
 #define I2C_ERR_TIMEOUT          0x01         /* error = timeout */
 #define I2C_ERR_NOACK            0x02         /* error = no ACK from slave  */
+#define I2C_ERR_ARBLOST          0x04         /* error = arbitration lost */
+
+/* 1 - I2C_WriteBlockAsync transmits in the background (I2C0 interrupt), 
+   0 - it transmits at once like I2C_WriteBlock */
+#ifndef I2C_ASYNC
+#define I2C_ASYNC                (1)
+#endif
+/* transactions and bytes waiting for background transmission, must be 2^N */
+#ifndef I2C_TX_QUEUE
+#define I2C_TX_QUEUE             (8)
+#endif
+#ifndef I2C_TX_BUFFER
+#define I2C_TX_BUFFER            (256)
+#endif
+
+/**
+ * @brief function called when background transaction is finished, gets errors
+ */
+typedef void (*I2C_Callback)(uint8_t errors);
 
 /**
  * @brief I2C initialization.
@@ -53,6 +72,53 @@ uint8_t I2C_Write(uint8_t address, uint8_t data);
  */
 uint8_t I2C_Read(uint8_t address, uint8_t* data);
 
+/**
+ * @brief     I2C burst write. Write block of bytes to specified device address
+ *            in one transmission (one start, address and stop). Works best 
+ *            with I/O expanders, every byte is a new state of the outputs.
+ * @param[in] Address of slave.
+ * @param[in] Count of bytes to write.
+ * @param[in] Data to write.
+ * @return    Errors.
+ */
+uint8_t I2C_WriteBlock(uint8_t address, uint8_t size, uint8_t* data);
+
+/**
+ * @brief     I2C burst write in the background. Data is copied to the transmit
+ *            queue, function waits only if the queue is full.
+ * @param[in] Address of slave.
+ * @param[in] Count of bytes to write.
+ * @param[in] Data to write.
+ * @param[in] Function called when transaction is finished (or 0), it may be 
+ *            called from I2C0 interrupt.
+ * @return    Errors (I2C_ASYNC 0 only, otherwise they are passed to callback).
+ */
+uint8_t I2C_WriteBlockAsync(uint8_t address, uint8_t size, uint8_t* data, I2C_Callback done);
+
+/**
+ * @brief Wait until all background transactions are finished.
+ */
+void I2C_Wait(void);
+
+/**
+ * @brief  Check if background transactions are in progress.
+ * @return 1 if transmitting, 0 otherwise
+ */
+uint8_t I2C_IsBusy(void);
+
+/**
+ * @brief  Errors of background transactions since the last call.
+ * @return Errors.
+ */
+uint8_t I2C_GetAsyncErrors(void);
+
+/**
+ * @brief  Number of background transactions which ended with an error, the
+ *         counter is never cleared.
+ * @return Failed transactions.
+ */
+uint32_t I2C_GetFailedTransfers(void);
+
 /**
  * @brief     I2C write to register.  
  * @param[in] Address of slave.
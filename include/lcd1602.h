@@ -15,6 +15,18 @@
 
 #include "i2c.h"
 
+/****************************************************************************** 
+ * Global definitions
+ ******************************************************************************/
+
+/* size of the display (shadow frame in memory), up to 4x20 */
+#ifndef LCD1602_ROWS
+#define LCD1602_ROWS             (2)
+#endif
+#ifndef LCD1602_COLS
+#define LCD1602_COLS             (16)
+#endif
+
 /****************************************************************************** 
  * Function declarations
  ******************************************************************************/
@@ -43,32 +55,35 @@ void LCD1602_ClearAll(void);
 void LCD1602_SetCursor(uint8_t col, uint8_t row);
 
 /**
- * @brief Load custom characters to LCD
+ * @brief Load custom characters to LCD (bars of 1-8 strips in slots 0-7, as
+ *        GLYPH_Reset expects), in a few transmissions. Bars are drawn only
+ *        with GLYPH_Get, which may load other glyphs to the slots later.
  */
 void LCD1602_LVL_CH(void);
 
 /**
- * @brief     Write normalized 8 level amplitude bar to LCD
- * @param[in] Normalized amplitude level: 1-8
+ * @brief     Write a character to the frame in memory, the display is not
+ *            changed until LCD1602_Flush.
+ * @param[in] Column number
+ * @param[in] Row number
+ * @param[in] Character (0-7 for custom characters)
  */
-void LCD1602_PrintLVL(char *str);
+void LCD1602_PutChar(uint8_t col, uint8_t row, char ch);
 
 /**
- * @brief     Write normalized 16-levels amplitude bar to LCD
- * @param[in] Normalized amplitude level: 1-16
- * @param[in] Column number
+ * @brief     Load custom character, in one transmission.
+ * @param[in] Character number: 0-7
+ * @param[in] Eight rows of pixels, top row first (5 lower bits)
  */
-void LCD1602_PrintLVL_16(uint8_t, uint8_t);
+void LCD1602_LoadChar(uint8_t slot, const uint8_t *rows);
 
 /**
- * @brief     Write normalized 16-levels amplitude bar to LCD. Function dedicated
- *            for a spectrum analyzer, does not do any unnecessary prints and 
- *            works faster
- * @param[in] Normalized amplitude level: 0-16
- * @param[in] Previous normalized amplitude level: 0-16
- * @param[in] Column number
+ * @brief  Send changed characters of the frame in memory to the display. 
+ *         Adjacent changed characters are sent after one set cursor command.
+ *         Function returns while characters are transmitted in the background.
+ * @return Number of bytes written to the LCD (commands and characters)
  */
-void LCD1602_PrintLVL_16_FFT(uint8_t lvl, uint8_t oldLvl, uint8_t col);
+uint8_t LCD1602_Flush(void);
 
 /**
  * @brief     Read busy flag and address counter
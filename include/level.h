@@ -0,0 +1,171 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   level.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for magnitude to bar level mapping.
+ * @ver    0.1
+ */
+
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stdint.h>
+
+/******************************************************************************
+ * Global definitions
+ ******************************************************************************/
+
+/* highest bar level which can be printed on the LCD */
+#define LEVEL_MAX                (16)
+
+/* convert dB value to Q8 format used by LEVEL_SetRange */
+#define LEVEL_DB(x)              ((int32_t)((x)*256))
+
+/* magnitude (20*log10) below which the bar is empty, default value is the
+   same as for the old formula: log10(mag)*16/3.5-9 */
+#ifndef LEVEL_DB_FLOOR
+#define LEVEL_DB_FLOOR           LEVEL_DB(39.375)
+#endif
+/* dB range covered by all LEVEL_MAX levels */
+#ifndef LEVEL_DB_RANGE
+#define LEVEL_DB_RANGE           LEVEL_DB(70.0)
+#endif
+
+/* dB per octave (20*log10(2)) in Q8 format */
+#define LEVEL_DB_PER_OCTAVE      (1541)
+
+/* 1 - automatic gain: bars span the live range between the noise floor of a
+       column and the running peak of all columns (LEVEL_MapColumns),
+   0 - fixed range set by LEVEL_SetRange */
+#ifndef LEVEL_AGC
+#define LEVEL_AGC                (1)
+#endif
+
+/* number of columns tracked by the automatic gain */
+#define LEVEL_COLUMNS            (16)
+
+/* rates below are converted to steps per frame for FFT_FRAME_RATE, modes
+   with lower frame rate set their own one with LEVEL_SetFrameRate */
+/* peak attack: peak moves by 1/2^shift of the distance to a louder frame */
+#ifndef LEVEL_AGC_ATTACK_SHIFT
+#define LEVEL_AGC_ATTACK_SHIFT   (1)
+#endif
+/* peak release, dB per second */
+#ifndef LEVEL_AGC_RELEASE_DB
+#define LEVEL_AGC_RELEASE_DB     (10)
+#endif
+/* noise floor follows a quieter column by 1/2^shift of the distance ... */
+#ifndef LEVEL_NOISE_FALL_SHIFT
+#define LEVEL_NOISE_FALL_SHIFT   (5)
+#endif
+/* ... and rises slowly, dB per second */
+#ifndef LEVEL_NOISE_RISE_DB
+#define LEVEL_NOISE_RISE_DB      (3)
+#endif
+/* highest noise floor above the lowest one (dB in Q8 format), a steady tone
+   would otherwise become the noise floor of its column */
+#ifndef LEVEL_NOISE_SPREAD
+#define LEVEL_NOISE_SPREAD       LEVEL_DB(20.0)
+#endif
+/* empty bar up to this distance above the noise floor (dB in Q8 format) */
+#ifndef LEVEL_AGC_MARGIN
+#define LEVEL_AGC_MARGIN         LEVEL_DB(10.0)
+#endif
+/* smallest range covered by the bars, keeps pure noise from filling them */
+#ifndef LEVEL_AGC_MIN_RANGE
+#define LEVEL_AGC_MIN_RANGE      LEVEL_DB(30.0)
+#endif
+
+/******************************************************************************
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief     Set dB range mapped on the bar levels.
+ * @param[in] Magnitude for empty bar, dB in Q8 format (use LEVEL_DB macro)
+ * @param[in] Range of all LEVEL_MAX levels, dB in Q8 format
+ */
+void LEVEL_SetRange(int32_t floorDb, int32_t rangeDb);
+
+/**
+ * @brief     Binary logarithm calculated with leading zero count and lookup
+ *            table, no libm calls.
+ * @param[in] Argument, 0 is treated as 1
+ * @return    log2(x) in Q8 format
+ */
+int32_t LEVEL_Log2(uint32_t x);
+
+/**
+ * @brief     Binary logarithm of a 64-bit value (sums of powers).
+ * @param[in] Argument, 0 is treated as 1
+ * @return    log2(x) in Q8 format
+ */
+int32_t LEVEL_Log2Long(uint64_t x);
+
+/**
+ * @brief     Binary logarithm of a floating point value taken from its exponent
+ *            and mantissa bits, no libm calls.
+ * @param[in] Argument, values below 1 are treated as 1
+ * @return    log2(x) in Q8 format
+ */
+int32_t LEVEL_Log2Float(float x);
+
+/**
+ * @brief     Binary logarithm of the power of a complex value with 32-bit
+ *            components; both are scaled down to avoid overflow.
+ * @param[in] Real part
+ * @param[in] Imaginary part
+ * @return    log2(re^2+im^2) in Q8 format
+ */
+int32_t LEVEL_Log2Power(int32_t re, int32_t im);
+
+/**
+ * @brief     Map binary logarithm of a magnitude to the bar level.
+ * @param[in] log2(magnitude) in Q8 format
+ * @return    Bar level: 0-LEVEL_MAX
+ */
+uint8_t LEVEL_FromLog2(int32_t log2Mag);
+
+/**
+ * @brief     Map binary logarithm of a power (squared magnitude) to the bar 
+ *            level, square root is folded into the mapping.
+ * @param[in] log2(re^2+im^2) in Q8 format
+ * @return    Bar level: 0-LEVEL_MAX
+ */
+uint8_t LEVEL_FromLog2Power(int32_t log2Pow);
+
+/**
+ * @brief      Map binary logarithms of column powers of one frame to the bar 
+ *             levels. With LEVEL_AGC the running peak and noise floors are 
+ *             updated first, otherwise LEVEL_FromLog2Power is used.
+ * @param[in]  log2(power) of the columns in Q8 format
+ * @param[out] Bar levels: 0-LEVEL_MAX
+ * @param[in]  Number of columns, up to LEVEL_COLUMNS
+ */
+void LEVEL_MapColumns(const int32_t *log2Pow, uint8_t *levels, uint8_t count);
+
+/**
+ * @brief     Convert rates of the automatic gain to steps per frame for the 
+ *            frame rate of the current mode.
+ * @param[in] Frames per second (FFT_MODE_FRAME_RATE)
+ */
+void LEVEL_SetFrameRate(uint16_t framesPerSecond);
+
+/**
+ * @brief Start the automatic gain from the next frame (e.g. after a change of
+ *        displayed frequencies).
+ */
+void LEVEL_AgcReset(void);
+
+/**
+ * @brief     Map magnitude of a frequency bin to the bar level.
+ * @param[in] Magnitude (same scale as arm_cmplx_mag_f16 output)
+ * @return    Bar level: 0-LEVEL_MAX
+ */
+uint8_t LEVEL_FromMagnitude(uint32_t mag);
+
+#endif /* LEVEL_H */
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   prof.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for the cycle profiler of the main
+ *         loop stages. Durations are kept in a ring buffer and as min, max
+ *         and mean per stage.
+ * @ver    0.1
+ */
+
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+
+/******************************************************************************
+ * Global definitions
+ ******************************************************************************/
+
+/* 1 - stages are measured (PROF_START/PROF_STOP), 0 - macros are empty */
+#ifndef PROF_ENABLE
+#define PROF_ENABLE              (0)
+#endif
+
+/* number of last measurements kept in the ring buffer, must be 2^N */
+#ifndef PROF_RING_SIZE
+#define PROF_RING_SIZE           (64)
+#endif
+
+/* clock backend: current time and time elapsed since the given one, SysTick
+   cycle counter by default (other clock can be defined for a host build) */
+#ifndef PROF_CLOCK
+#include "timer.h"
+#define PROF_CLOCK()             TIMER_Now()
+#define PROF_ELAPSED(t)          TIMER_Elapsed(t)
+#endif
+
+#if PROF_ENABLE
+#define PROF_START(t)            uint32_t t = PROF_CLOCK()
+#define PROF_STOP(stage, t)      PROF_Record((stage), PROF_ELAPSED(t))
+#else
+#define PROF_START(t)
+#define PROF_STOP(stage, t)
+#endif
+
+/******************************************************************************
+ * Global enums
+ ******************************************************************************/
+
+/**
+ * @brief measured stages of the main loop
+ */
+typedef enum {
+    PROF_WINDOW = 0,           /* sample history and window function */
+    PROF_FFT,                  /* real FFT */
+    PROF_COLUMNS,              /* power of columns and bar levels */
+    PROF_PRINT,                /* printing columns on the LCD */
+    PROF_STAGES
+} ProfStage;
+
+/******************************************************************************
+ * Global structs
+ ******************************************************************************/
+
+/**
+ * @brief one measurement in the ring buffer
+ */
+typedef struct {
+    uint8_t  stage;
+    uint32_t cycles;
+} ProfSample;
+
+/**
+ * @brief function printing one line of the report (16 characters)
+ */
+typedef void (*ProfPrinter)(const char *line);
+
+/******************************************************************************
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief     Store duration of a stage.
+ * @param[in] Stage
+ * @param[in] Duration in clock cycles
+ */
+void PROF_Record(ProfStage stage, uint32_t cycles);
+
+/**
+ * @brief Clear statistics and the ring buffer.
+ */
+void PROF_Reset(void);
+
+/**
+ * @brief      Last measurements, oldest first.
+ * @param[out] Buffer for up to PROF_RING_SIZE measurements
+ * @return     Number of measurements copied
+ */
+uint16_t PROF_GetRing(ProfSample *samples);
+
+/**
+ * @brief     Report min, max and mean duration of every stage, two lines per
+ *            stage.
+ * @param[in] Function printing a line
+ */
+void PROF_Report(ProfPrinter print);
+
+/**
+ * @brief Show the report on the LCD, one stage per screen.
+ */
+void PROF_Print(void);
+
+#endif /* PROF_H */
@@ -0,0 +1,98 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   queue.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for the queue of sample buffers 
+ *         between the sampling interrupt (producer) and the main loop 
+ *         (consumer). Each side writes only its own variables, so no 
+ *         interrupt has to be disabled.
+ * @ver    0.1
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "MKL25Z4.h"
+#include "fft.h"
+
+/****************************************************************************** 
+ * Global definitions
+ ******************************************************************************/
+
+/* number of slots, one per sample buffer (FFT_Buffer) */
+#define QUEUE_SLOTS              (FFT_BUFFERS)
+
+/* what happens when samples come and all slots are occupied */
+#define QUEUE_DROP_NEWEST        (0)    /* new samples are dropped */
+#define QUEUE_DROP_OLDEST        (1)    /* oldest waiting frame is overwritten */
+#ifndef QUEUE_POLICY
+#define QUEUE_POLICY             QUEUE_DROP_OLDEST
+#endif
+
+/* no slot available */
+#define QUEUE_NONE               (-1)
+
+/****************************************************************************** 
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief  Producer: slot which can be filled with samples. The same slot is 
+ *         returned until it is published. With QUEUE_DROP_OLDEST the oldest
+ *         frame not taken by the consumer is overwritten when all slots are
+ *         occupied; otherwise every call with the queue full is counted as
+ *         an overrun (one call per dropped sample).
+ * @return Slot (buffer) number or QUEUE_NONE if all slots are occupied
+ */
+int8_t QUEUE_WriteSlot(void);
+
+/**
+ * @brief Producer: pass the filled slot to the consumer.
+ */
+void QUEUE_Publish(void);
+
+/**
+ * @brief  Consumer: take the oldest published slot, it is not overwritten 
+ *         until released. The same slot is returned until it is released.
+ * @return Slot (buffer) number or QUEUE_NONE if there is no new frame
+ */
+int8_t QUEUE_ReadSlot(void);
+
+/**
+ * @brief Consumer: return the taken slot to the producer.
+ */
+void QUEUE_Release(void);
+
+/**
+ * @brief  Consumer: check if the taken frame directly follows the last 
+ *         released one, i.e. no frame was overwritten (QUEUE_DROP_OLDEST) 
+ *         and no samples were dropped (QUEUE_DROP_NEWEST) in between.
+ * @return 1 if samples are continuous, 0 otherwise or if no slot is taken
+ */
+uint8_t QUEUE_IsContinuous(void);
+
+/**
+ * @brief  Number of published frames waiting for the consumer.
+ * @return Number of frames: 0 to QUEUE_SLOTS
+ */
+uint8_t QUEUE_Count(void);
+
+/**
+ * @brief  Number of producer requests refused because all slots were 
+ *         occupied.
+ * @return Number of overruns (dropped samples)
+ */
+uint32_t QUEUE_GetOverruns(void);
+
+/**
+ * @brief  Number of published frames overwritten before the consumer took 
+ *         them (QUEUE_DROP_OLDEST).
+ * @return Number of dropped frames
+ */
+uint32_t QUEUE_GetDroppedFrames(void);
+
+#endif /* QUEUE_H */
@@ -0,0 +1,54 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   timer.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for SysTick based cycle counter.
+ * @ver    0.1
+ */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "MKL25Z4.h"
+
+/****************************************************************************** 
+ * Global definitions
+ ******************************************************************************/
+
+/* core clock (CLOCK_SETUP 1), SysTick counts core clock cycles */
+#define TIMER_CLOCK_HZ           (48000000)
+
+/* SysTick is a 24-bit counter, longest measured time is about 349 ms */
+#define TIMER_MASK               (0x00FFFFFF)
+
+/* convert microseconds to cycles */
+#define TIMER_US(x)              ((uint32_t)(x)*(TIMER_CLOCK_HZ/1000000))
+
+/****************************************************************************** 
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief Start SysTick as a free running counter of core clock cycles, 
+ *        without interrupts.
+ */
+void TIMER_Init(void);
+
+/**
+ * @brief  Current value of the cycle counter.
+ * @return Counter value, counts up from 0 to TIMER_MASK
+ */
+uint32_t TIMER_Now(void);
+
+/**
+ * @brief     Number of cycles since the given point in time.
+ * @param[in] Counter value returned by TIMER_Now
+ * @return    Elapsed cycles (valid below TIMER_MASK)
+ */
+uint32_t TIMER_Elapsed(uint32_t start);
+
+#endif /* TIMER_H */
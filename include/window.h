@@ -0,0 +1,120 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   window.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing declarations for FFT window functions. Tables are
+ *         calculated by the compiler for any FFT_SIZE.
+ * @ver    0.1
+ */
+
+#ifndef WINDOW_H
+#define WINDOW_H
+
+#include "fft.h"
+
+/******************************************************************************
+ * Global definitions
+ ******************************************************************************/
+
+#define WIN_PI                   (3.14159265358979323846)
+
+/* cos(x) for x in [0, pi/2], Taylor series up to x^14 (error < 1e-8) */
+#define WIN_COS_Q(x)             (1-(x)*(x)/2*(1-(x)*(x)/12*(1-(x)*(x)/30*   \
+                                  (1-(x)*(x)/56*(1-(x)*(x)/90*(1-(x)*(x)/132*\
+                                  (1-(x)*(x)/182)))))))
+/* cos(x) for x in [0, pi] */
+#define WIN_COS_H(x)             ((x) <= WIN_PI/2 ? WIN_COS_Q(x)             \
+                                                  : -WIN_COS_Q(WIN_PI-(x)))
+/* cos(x) for x in [0, 2*pi], constant expression */
+#define WIN_COS(x)               ((x) <= WIN_PI ? WIN_COS_H(x)               \
+                                                : WIN_COS_H(2*WIN_PI-(x)))
+
+/* real value to Q15 with rounding and saturation */
+#define WIN_Q15(x)               ((x) >= 1.0 ? 32767 : (int16_t)((x)*32768 + \
+                                  ((x) >= 0 ? 0.5 : -0.5)))
+
+/* f(n) for n in 0 to FFT_SIZE/2-1 (half of a symmetric table) and
+   n in 0 to FFT_SIZE-1 (whole table), separated with commas */
+#define WIN_R2(f, n)             f(n), f((n)+1)
+#define WIN_R4(f, n)             WIN_R2(f, n), WIN_R2(f, (n)+2)
+#define WIN_R8(f, n)             WIN_R4(f, n), WIN_R4(f, (n)+4)
+#define WIN_R16(f, n)            WIN_R8(f, n), WIN_R8(f, (n)+8)
+#define WIN_R32(f, n)            WIN_R16(f, n), WIN_R16(f, (n)+16)
+#define WIN_R64(f, n)            WIN_R32(f, n), WIN_R32(f, (n)+32)
+#define WIN_R128(f, n)           WIN_R64(f, n), WIN_R64(f, (n)+64)
+#define WIN_R256(f, n)           WIN_R128(f, n), WIN_R128(f, (n)+128)
+#define WIN_R512(f, n)           WIN_R256(f, n), WIN_R256(f, (n)+256)
+#define WIN_R1024(f, n)          WIN_R512(f, n), WIN_R512(f, (n)+512)
+
+#if FFT_SIZE == 64
+#define WIN_HALF(f)              WIN_R32(f, 0)
+#define WIN_FULL(f)              WIN_R64(f, 0)
+#elif FFT_SIZE == 128
+#define WIN_HALF(f)              WIN_R64(f, 0)
+#define WIN_FULL(f)              WIN_R128(f, 0)
+#elif FFT_SIZE == 256
+#define WIN_HALF(f)              WIN_R128(f, 0)
+#define WIN_FULL(f)              WIN_R256(f, 0)
+#elif FFT_SIZE == 512
+#define WIN_HALF(f)              WIN_R256(f, 0)
+#define WIN_FULL(f)              WIN_R512(f, 0)
+#elif FFT_SIZE == 1024
+#define WIN_HALF(f)              WIN_R512(f, 0)
+#define WIN_FULL(f)              WIN_R1024(f, 0)
+#else
+#error "Unsupported FFT_SIZE"
+#endif
+
+/* bytes of flash taken by window tables (three half-length Q15 tables) */
+#define WINDOW_FLASH_SIZE        (3*FFT_SIZE/2*sizeof(q15_t))
+
+/******************************************************************************
+ * Global enums
+ ******************************************************************************/
+
+/**
+ * @brief available window functions
+ */
+typedef enum {
+    WINDOW_HANN = 0,
+    WINDOW_BLACKMAN_HARRIS,
+    WINDOW_FLAT_TOP,
+    WINDOW_RECTANGULAR,
+    WINDOW_COUNT
+} WindowType;
+
+/******************************************************************************
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief     Select window function, can be changed at any time.
+ * @param[in] Window type
+ */
+void WINDOW_Select(WindowType type);
+
+/**
+ * @brief  Get selected window function.
+ * @return Window type
+ */
+WindowType WINDOW_Get(void);
+
+/**
+ * @brief     Coefficient of the selected window.
+ * @param[in] Sample number: 0 to FFT_SIZE-1
+ * @return    Coefficient in Q15 format
+ */
+q15_t WINDOW_Coeff(uint16_t n);
+
+/**
+ * @brief  Power correction of the selected window, equalizes levels of a tone
+ *         with levels calculated for the Hann window.
+ * @return Correction added to log2(power), Q8 format
+ */
+int32_t WINDOW_PowerCorrection(void);
+
+#endif /* WINDOW_H */
@@ -12,13 +12,51 @@
 
 #include "ADC.h"
 #include "fft.h"
+#include "dft.h"
+#include "window.h"
+#include "timer.h"
+#include "queue.h"
+#include "diag.h"
 
 /******************************************************************************
  * Private memory declarations
  ******************************************************************************/
 
-static float16_t ADC_Read = 0;
+#if !ADC_USE_DMA
+static uint16_t ADC_Read = 0;
+#endif
 static uint16_t SampleCounter = 0;
+/* mode of the samples in the current buffer */
+static uint8_t SampleMode = 0;
+/* buffer being filled or QUEUE_NONE */
+static int8_t WriteSlot = QUEUE_NONE;
+
+/* DC offset estimate with ADC_DC_SHIFT fractional bits */
+static int32_t dc_estimate = (int32_t)FFT_AVG_VALUE << ADC_DC_SHIFT;
+
+/* second order CIC decimator state */
+static uint32_t cic_integrator[2] = {0, 0};
+static uint32_t cic_comb[2] = {0, 0};
+static uint8_t cic_counter = 0;
+static uint8_t cic_shift = 0;
+
+#if ADC_USE_DMA
+/* raw conversions, DMA fills one block while the other one is processed */
+static uint16_t ADC_DmaBuffer[2][ADC_DMA_BLOCK];
+static uint8_t dma_block = 0;
+#endif
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static int16_t ADC_RemoveDc(uint16_t in);
+static uint8_t ADC_Decimate(int16_t in, int16_t *out);
+static void ADC_Store(int16_t sample);
+#if ADC_USE_DMA
+static void ADC_DmaStart(uint8_t block);
+#endif
+static void ADC_CountCycles(uint32_t start);
 
 /******************************************************************************
  * Function definitions
@@ -80,38 +118,220 @@ uint8_t ADC_Init(void) {
     /* Trigger ADC0 through PIT0 */   
     SIM->SOPT7 |= SIM_SOPT7_ADC0ALTTRGEN_MASK | SIM_SOPT7_ADC0TRGSEL(4);
     
+#if ADC_USE_DMA
+    /* Connect clock to DMA and DMAMUX */
+    SIM->SCGC6 |= SIM_SCGC6_DMAMUX_MASK;
+    SIM->SCGC7 |= SIM_SCGC7_DMA_MASK;
+    DMAMUX0->CHCFG[0] = 0;
+    
+    /* 16-bit result register to incremented buffer, one transfer per 
+       request, request is disabled at the end of a block */
+    DMA0->DMA[0].SAR = (uint32_t)(uintptr_t)&ADC0->R[0];
+    DMA0->DMA[0].DCR = DMA_DCR_EINT_MASK | DMA_DCR_CS_MASK | DMA_DCR_SSIZE(2) 
+                     | DMA_DCR_DSIZE(2) | DMA_DCR_DINC_MASK | DMA_DCR_D_REQ_MASK;
+    DMAMUX0->CHCFG[0] = DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_SOURCE(ADC_DMAMUX_SOURCE);
+    
+    /* Conversion complete requests DMA instead of interrupt */
+    ADC0->SC2 |= ADC_SC2_DMAEN_MASK;
+    
+    /* Enable interrupts */
+    NVIC_ClearPendingIRQ(DMA0_IRQn);
+    NVIC_EnableIRQ(DMA0_IRQn);
+#else
     /* Enable interrupts */
     NVIC_ClearPendingIRQ(ADC0_IRQn);
     NVIC_EnableIRQ(ADC0_IRQn);
+#endif
     
     return(0);
 }
 
+/**-----------------------------------------------------------------------------
+ * @brief Start conversions on channel 8, triggered by PIT0 (and DMA transfers
+ *        with ADC_USE_DMA).
+ */
+void ADC_Start(void) {
+#if ADC_USE_DMA
+    dma_block = 0;
+    ADC_DmaStart(dma_block);
+    ADC0->SC1[0] = ADC_SC1_ADCH(8);
+#else
+    ADC0->SC1[0] = ADC_SC1_AIEN_MASK | ADC_SC1_ADCH(8);
+#endif
+}
+
+#if ADC_USE_DMA
+/**-----------------------------------------------------------------------------
+ * @brief Interrupt hanlder for DMA0 channel 0. Called when a block of raw 
+ *        samples is complete: DMA is restarted on the other block and samples
+ *        of the completed one are processed in order.
+ */
+void DMA0_IRQHandler(void) {
+    const uint16_t *raw = ADC_DmaBuffer[dma_block];
+    int16_t sample;
+    uint32_t start = TIMER_Now();
+    
+    /* next conversion is 25 us away, restart before processing */
+    dma_block ^= 1;
+    ADC_DmaStart(dma_block);
+    
+    for( uint16_t i=0; i<ADC_DMA_BLOCK; i++ ) {
+        /* lower sample rate of zoomed modes */
+        if( ADC_Decimate(ADC_RemoveDc(raw[i]), &sample) )
+            ADC_Store(sample);
+    }
+    
+    ADC_CountCycles(start);
+}
+#else
 /**-----------------------------------------------------------------------------
  * @brief Interrupt hanlder for ADC0. Collects samples from converter and sets 
  *        necessary flags.
  */
 void ADC0_IRQHandler() {    
+    int16_t sample;
+    uint32_t start = TIMER_Now();
+    
     ADC_Read = ADC0->R[0];    // read ADC0, clear COCO flag
-    if( FFTstatus.readToBuffer0 ) {
-        if( SampleCounter != FFT_SIZE )
-            FFT_Buffer[0][SampleCounter++] = ADC_Read-FFT_AVG_VALUE;
-        if( SampleCounter == FFT_SIZE && !FFTstatus.isBuffer1Ready ) { 
-            SampleCounter = 0;
-            FFTstatus.isBuffer0Ready = 1;
-            FFTstatus.readToBuffer0 = 0;
-            FFTstatus.readToBuffer1 = 1; 
-        }        
+    
+    /* lower sample rate of zoomed modes */
+    if( ADC_Decimate(ADC_RemoveDc(ADC_Read), &sample) )
+        ADC_Store(sample);
+    
+    ADC_CountCycles(start);
+    NVIC_EnableIRQ(ADC0_IRQn);
+}
+#endif
+
+/**-----------------------------------------------------------------------------
+ * @brief  Current estimate of the constant value of the sampled signal.
+ * @return DC offset in ADC units
+ */
+uint16_t ADC_GetDcEstimate(void) {
+    return (uint16_t)(dc_estimate >> ADC_DC_SHIFT);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Store sample in the current buffer and publish the buffer when it
+ *            is full. Samples are dropped while all buffers are occupied and
+ *            the buffer is started again when the mode changes. With
+ *            FFT_WINDOW_IN_ISR window function is applied here, so a full
+ *            buffer is ready for FFT.
+ * @param[in] Sample with removed constant value (ADC units)
+ */
+static void ADC_Store(int16_t sample) {
+    fft_capture_t value;
+    
+    /* mode changed, samples of the old one are overwritten */
+    if( FFTstatus.mode != SampleMode ) {
+        SampleMode = FFTstatus.mode;
+        SampleCounter = 0;
     }
-    else {
-        if( SampleCounter != FFT_SIZE )
-            FFT_Buffer[1][SampleCounter++] = ADC_Read-FFT_AVG_VALUE;
-        if( SampleCounter == FFT_SIZE && !FFTstatus.isBuffer0Ready ) {
-            SampleCounter = 0;
-            FFTstatus.isBuffer1Ready = 1;
-            FFTstatus.readToBuffer0 = 1;
-            FFTstatus.readToBuffer1 = 0;
-        }
+    
+    /* take a free buffer when the previous one has been published */
+    if( WriteSlot == QUEUE_NONE ) {
+        WriteSlot = QUEUE_WriteSlot();
+        if( WriteSlot == QUEUE_NONE )
+            return;
     }
-    NVIC_EnableIRQ(ADC0_IRQn);
-} 
+    
+    value = FFT_TO_SAMPLE(sample);
+#if FFT_WINDOW_IN_ISR
+    value = FFT_WINDOW_SAMPLE(value, WINDOW_Coeff(SampleCounter));
+#endif
+    FFT_Buffer[WriteSlot][SampleCounter] = value;
+#if FFT_DFT_BINS
+    DFT_Push(sample);
+#endif
+    
+    if( ++SampleCounter == FFT_HOP_SIZE ) {
+#if FFT_DFT_BINS
+        DFT_Latch(WriteSlot);
+#endif
+        SampleCounter = 0;
+        QUEUE_Publish();
+        WriteSlot = QUEUE_NONE;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Remove constant value of the signal. The estimate is a first 
+ *            order low-pass (exponential average) of the input, so drift of
+ *            the amplifier bias does not leak into the lowest bins.
+ * @param[in] ADC result
+ * @return    Sample with removed constant value (ADC units)
+ */
+static int16_t ADC_RemoveDc(uint16_t in) {
+    int32_t out = (int32_t)in - (dc_estimate >> ADC_DC_SHIFT);
+    
+    /* estimate += (in - estimate)/2^ADC_DC_SHIFT */
+    dc_estimate += out;
+    
+    return (int16_t)out;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Second order CIC decimator, decimation factor is taken from the
+ *             current mode (FFT_Modes). Gain is compensated, so output is in 
+ *             ADC units.
+ * @param[in]  Sample with removed constant value
+ * @param[out] Decimated sample
+ * @return     1 if decimated sample is ready, 0 otherwise
+ */
+static uint8_t ADC_Decimate(int16_t in, int16_t *out) {
+    uint8_t shift = FFT_Modes[FFTstatus.mode].decimationShift;
+    uint32_t comb0, comb1;
+    
+    if( shift == 0 ) {
+        cic_shift = 0;
+        *out = in;
+        return 1;
+    }
+    
+    /* mode changed, start from the scratch */
+    if( shift != cic_shift ) {
+        cic_shift = shift;
+        cic_counter = 0;
+        cic_integrator[0] = cic_integrator[1] = 0;
+        cic_comb[0] = cic_comb[1] = 0;
+    }
+    
+    /* integrators run at the full rate, unsigned wrap around is harmless */
+    cic_integrator[0] += (uint32_t)(int32_t)in;
+    cic_integrator[1] += cic_integrator[0];
+    if( ++cic_counter < (1 << shift) )
+        return 0;
+    cic_counter = 0;
+    
+    /* combs run at the decimated rate */
+    comb0 = cic_integrator[1] - cic_comb[0];
+    cic_comb[0] = cic_integrator[1];
+    comb1 = comb0 - cic_comb[1];
+    cic_comb[1] = comb0;
+    
+    /* gain of the second order CIC is (2^shift)^2 */
+    *out = (int16_t)((int32_t)comb1 >> (2*shift));
+    return 1;
+}
+
+#if ADC_USE_DMA
+/**-----------------------------------------------------------------------------
+ * @brief     Start DMA transfer of ADC_DMA_BLOCK conversions.
+ * @param[in] Block of ADC_DmaBuffer (0 or 1)
+ */
+static void ADC_DmaStart(uint8_t block) {
+    /* clear done and error flags */
+    DMA0->DMA[0].DSR_BCR = DMA_DSR_BCR_DONE_MASK;
+    DMA0->DMA[0].DAR = (uint32_t)(uintptr_t)ADC_DmaBuffer[block];
+    DMA0->DMA[0].DSR_BCR = DMA_DSR_BCR_BCR(ADC_DMA_BLOCK*sizeof(uint16_t));
+    DMA0->DMA[0].DCR |= DMA_DCR_ERQ_MASK;
+}
+#endif
+
+/**-----------------------------------------------------------------------------
+ * @brief     Pass interrupt duration to diagnostic counters.
+ * @param[in] Counter value (TIMER_Now) at the beginning of the interrupt
+ */
+static void ADC_CountCycles(uint32_t start) {
+    DIAG_IsrCycles(TIMER_Elapsed(start) + ADC_IRQ_OVERHEAD);
+}
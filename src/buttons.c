@@ -13,6 +13,21 @@
 #include "buttons.h"
 #include "lcd1602.h"
 #include "fft.h"
+#include "diag.h"
+#include "prof.h"
+#include "window.h"
+
+/****************************************************************************** 
+ * Private memory declarations
+ ******************************************************************************/
+
+/* set by the keypad interrupt, cleared by buttons_ModeChanged */
+static volatile uint8_t ModeChanged = 0;
+
+/* names of window functions (WindowType), second line of the LCD */
+static char * const Window_Names[WINDOW_COUNT] = {
+    "Hann", "Blackman-Harris", "Flat top", "Rectangular"
+};
 
 /****************************************************************************** 
  * Function definitions
@@ -24,14 +39,17 @@
 void buttons_Initialize(void){
     /* Enable clock for PORT_A */
     SIM->SCGC5 |=  SIM_SCGC5_PORTA_MASK;                 
+    PORTA->PCR[BUT_R3A13] |= PORT_PCR_MUX(1);          
     PORTA->PCR[BUT_R2A12] |= PORT_PCR_MUX(1);          
     PORTA->PCR[BUT_R1A5]  |= PORT_PCR_MUX(1);          
     
     /* Activate pull up for PORT_A */
+    PORTA->PCR[BUT_R3A13] |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;      
     PORTA->PCR[BUT_R2A12] |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;      
     PORTA->PCR[BUT_R1A5]  |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;             
     
     /* falling edge interrupts for PORT_A */
+    PORTA->PCR[BUT_R3A13] |= PORT_PCR_IRQC(0xa);
     PORTA->PCR[BUT_R2A12] |= PORT_PCR_IRQC(0xa);
     PORTA->PCR[BUT_R1A5]  |= PORT_PCR_IRQC(0xa);    
     
@@ -59,6 +77,55 @@ void buttons_Initialize(void){
  * @brief PORT_A interrupt hanlder, reads pressed keys from keyboard
  */
 void PORTA_IRQHandler(void){  
+    /*-----------------
+      | CHECK 3rd ROW |
+      -----------------*/
+    if( PORTA->ISFR & (1<<BUT_R3A13) ){
+        /* set columns as inputs */
+        PTC->PDDR &= ~( (1<<BUT_C4C0) | (1<<BUT_C3C3) | (1<<BUT_C2C4) | (1<<BUT_C1C5) );
+        PORTC->PCR[BUT_C4C0] |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;      
+        PORTC->PCR[BUT_C3C3] |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;             
+        PORTC->PCR[BUT_C2C4] |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;
+        PORTC->PCR[BUT_C1C5] |= PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;
+        
+        /* set R3A13 as low output */
+        PTA->PDDR |= (1<<BUT_R3A13);
+        PTA->PDOR &= ~(1<<BUT_R3A13);
+        
+        if( (PTC->PDIR & (1<<BUT_C1C5)) == 0 ) {
+            /* diagnostic counters, then back to the current mode */
+            DIAG_Print();
+        }
+#if PROF_ENABLE
+        else if( (PTC->PDIR & (1<<BUT_C2C4)) == 0 ) {
+            /* cycles of main loop stages, statistics start again */
+            PROF_Print();
+            PROF_Reset();
+        }
+#endif
+        else if( (PTC->PDIR & (1<<BUT_C3C3)) == 0 ) {
+            /* next window function, levels of a tone stay the same */
+            WINDOW_Select((WindowType)((WINDOW_Get() + 1) % WINDOW_COUNT));
+            LCD1602_ClearAll();
+            LCD1602_SetCursor(0,0);
+            LCD1602_Print("Window:");
+            LCD1602_SetCursor(0,1);
+            LCD1602_Print(Window_Names[WINDOW_Get()]);
+            FFT_DELAY(1000);
+            LCD1602_ClearAll();
+        }
+        
+        /* set R3A13 as input */
+        PTA->PDDR &= ~(1<<BUT_R3A13);
+        PORTA->PCR[BUT_R3A13]  |=  PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;    
+                              
+        /* set columns as low output */
+        PTC->PDDR |= (1<<BUT_C4C0) | (1<<BUT_C3C3) | (1<<BUT_C2C4) | (1<<BUT_C1C5);
+        PTC->PDOR &= ~( (1<<BUT_C4C0) | (1<<BUT_C3C3) | (1<<BUT_C2C4) | (1<<BUT_C1C5) );
+        
+        /* clear interrupt service flag (ISF) in Port Control Register */   
+        PORTA->PCR[BUT_R3A13] |= PORT_PCR_ISF_MASK;
+    } 
     /*-----------------
       | CHECK 2nd ROW |
       -----------------*/
@@ -194,9 +261,26 @@ void PORTA_IRQHandler(void){
         PORTA->PCR[BUT_R2A12] |= PORT_PCR_ISF_MASK;
     } 
     
-    /* reset all frequency bins */
-    for( uint8_t i=0; i<16; i++ ) {
-        FrequencyBins[i] = 0;
-        oldBins[i] = 0;
-    }
+    /* LCD was overwritten and the mode may be new, the main loop drops queued
+       frames and starts again (buttons_ModeChanged) */
+    ModeChanged = 1;
 } 
+
+/**-----------------------------------------------------------------------------
+ * @brief  Check if a key has been pressed since the last call. Called from the
+ *         main loop, which resets the FFT history, levels and the display.
+ * @return 1 if the mode screen (or diagnostics) has been shown, 0 otherwise
+ */
+uint8_t buttons_ModeChanged(void) {
+    uint8_t changed;
+    uint32_t keypad = NVIC_GetEnableIRQ(PORTA_IRQn);
+    
+    /* flag set between reading and clearing it would be lost */
+    NVIC_DisableIRQ(PORTA_IRQn);
+    changed = ModeChanged;
+    ModeChanged = 0;
+    if( keypad )
+        NVIC_EnableIRQ(PORTA_IRQn);
+    
+    return changed;
+}
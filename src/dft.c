@@ -0,0 +1,180 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   dft.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for sample-by-sample DFT of the 16 bins
+ *         displayed in modes 2-8 (modes with one bin per column).
+ * @ver    0.1
+ */
+
+#include "dft.h"
+#include "level.h"
+#include "window.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+#define DFT_MASK                 (FFT_SIZE-1)
+#define DFT_NONE                 (0xFF)
+/* cos(2*pi*n/FFT_SIZE) in Q11 format, calculated by the compiler */
+#define DFT_COS(n)               ((int16_t)(WIN_COS(2*WIN_PI*(n)/FFT_SIZE)*2048 \
+                                  + (4*(n) < FFT_SIZE || 4*(n) > 3*FFT_SIZE ? 0.5 : -0.5)))
+/* log2 (Q8) of the power scale: Cos_Table is in Q11 format */
+#define DFT_POWER_SCALE          (-2*11*256)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* cos(2*pi*n/FFT_SIZE) in Q11 format, sin is read with FFT_SIZE/4 offset;
+   Q11 keeps the sum of a whole frame within int32_t for 12-bit samples */
+static const int16_t Cos_Table[FFT_SIZE] = { WIN_FULL(DFT_COS) };
+
+/* frames being accumulated, frame j starts at sample j*FFT_HOP_SIZE */
+static int32_t dft_re[DFT_FRAMES][DFT_BINS];
+static int32_t dft_im[DFT_FRAMES][DFT_BINS];
+static uint8_t dft_mode[DFT_FRAMES];
+static uint16_t dft_first[DFT_FRAMES];
+/* sample number in frame 0 */
+static uint16_t dft_count = 0;
+/* frame finished by the last sample or DFT_NONE */
+static uint8_t dft_done = DFT_NONE;
+
+/* latched results, one set per sample buffer */
+static int32_t DFT_Re[FFT_BUFFERS][DFT_BINS];
+static int32_t DFT_Im[FFT_BUFFERS][DFT_BINS];
+static uint8_t DFT_Mode[FFT_BUFFERS];
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void dft_start(uint8_t frame);
+static void dft_accumulate(uint8_t frame, uint16_t n, int16_t sample);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Accumulate one sample into all DFT bins of all overlapping frames.
+ *            Called from ADC0 interrupt for every stored sample. A new frame
+ *            for bins of the current mode starts every FFT_HOP_SIZE samples.
+ * @param[in] Sample with removed constant value (ADC units)
+ */
+void DFT_Push(int16_t sample) {
+    uint16_t n;
+    
+    dft_done = DFT_NONE;
+    for( uint8_t j=0; j<DFT_FRAMES; j++ ) {
+        /* sample number in frame j */
+        n = (dft_count - j*FFT_HOP_SIZE) & DFT_MASK;
+        if( n == 0 )
+            dft_start(j);
+        if( dft_mode[j] )
+            dft_accumulate(j, n, sample);
+        if( n == FFT_SIZE-1 )
+            dft_done = j;
+    }
+    dft_count = (dft_count + 1) & DFT_MASK;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Store frame finished with the last sample as a result for given
+ *            buffer.
+ * @param[in] Buffer number: 0 to FFT_BUFFERS-1
+ */
+void DFT_Latch(uint8_t bufferNumber) {
+    if( dft_done == DFT_NONE ) {
+        DFT_Mode[bufferNumber] = 0;    /* first frames are not complete */
+        return;
+    }
+    
+    for( uint8_t i=0; i<DFT_BINS; i++ ) {
+        DFT_Re[bufferNumber][i] = dft_re[dft_done][i];
+        DFT_Im[bufferNumber][i] = dft_im[dft_done][i];
+    }
+    DFT_Mode[bufferNumber] = dft_mode[dft_done];
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Check if latched result can be used instead of FFT.
+ * @param[in] Buffer number: 0 to FFT_BUFFERS-1
+ * @param[in] Current mode
+ * @return    1 if result was calculated for bins of given mode, 0 otherwise
+ */
+uint8_t DFT_IsValid(uint8_t bufferNumber, uint8_t mode) {
+    return (mode != 0) && (DFT_Mode[bufferNumber] == mode);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Binary logarithm of the power of a latched bin.
+ * @param[in] Buffer number: 0 to FFT_BUFFERS-1
+ * @param[in] Column number: 0 to DFT_BINS-1
+ * @return    log2(re^2+im^2) in Q8 format, float16_t pipeline scale
+ */
+int32_t DFT_BinLog2Power(uint8_t bufferNumber, uint8_t col) {
+    return LEVEL_Log2Power(DFT_Re[bufferNumber][col], DFT_Im[bufferNumber][col])
+           + DFT_POWER_SCALE + WINDOW_PowerCorrection();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Drop frames being accumulated and latched results, e.g. after the
+ *        window function was changed; a new frame starts every FFT_HOP_SIZE
+ *        samples as usual.
+ */
+void DFT_Reset(void) {
+    for( uint8_t j=0; j<DFT_FRAMES; j++ )
+        dft_mode[j] = 0;
+    for( uint8_t b=0; b<FFT_BUFFERS; b++ )
+        DFT_Mode[b] = 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Start new frame for bins of the current mode.
+ * @param[in] Frame number
+ */
+static void dft_start(uint8_t frame) {
+    uint8_t mode = FFTstatus.mode;
+    
+    /* mode 1 needs the whole spectrum and zoomed modes sum several bins per
+       column, 0 marks a frame which is not calculated */
+    if( mode >= 2 && FFT_Modes[mode].binsPerColumn == 1 )
+        dft_mode[frame] = mode;
+    else
+        dft_mode[frame] = 0;
+    dft_first[frame] = FFT_Modes[mode].firstBin;
+    for( uint8_t i=0; i<DFT_BINS; i++ ) {
+        dft_re[frame][i] = 0;
+        dft_im[frame][i] = 0;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Accumulate windowed sample into bins of a single frame.
+ * @param[in] Frame number
+ * @param[in] Sample number in the frame
+ * @param[in] Sample with removed constant value (ADC units)
+ */
+static void dft_accumulate(uint8_t frame, uint16_t n, int16_t sample) {
+    int32_t x;
+    uint16_t idx;
+    int32_t *re = dft_re[frame];
+    int32_t *im = dft_im[frame];
+    
+    /* apply window function on the sample */
+    x = ((int32_t)sample * WINDOW_Coeff(n)) >> 15;
+    
+    /* phase of bin k for sample n is k*n, next bin adds n */
+    idx = (dft_first[frame] * n) & DFT_MASK;
+    for( uint8_t i=0; i<DFT_BINS; i++ ) {
+        re[i] += x * Cos_Table[idx];
+        im[i] -= x * Cos_Table[(idx - FFT_SIZE/4) & DFT_MASK];
+        idx = (idx + n) & DFT_MASK;
+    }
+}
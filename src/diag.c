@@ -0,0 +1,129 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   diag.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for always-on diagnostic counters of
+ *         the sampling and processing path.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include "diag.h"
+#include "ADC.h"
+#include "queue.h"
+#include "lcd1602.h"
+#include "i2c.h"
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* written by the sampling interrupt, average has DIAG_AVG_SHIFT fractional
+   bits */
+static volatile uint32_t diag_isrMax = 0;
+static volatile uint32_t diag_isrAvg = 0;
+static volatile uint32_t diag_isrOver = 0;
+
+/* written by the main loop */
+static volatile uint32_t diag_frames = 0;
+
+/* queue and I2C counters at the last reset (they are never cleared) */
+static uint32_t diag_baseOverruns = 0;
+static uint32_t diag_baseDropped = 0;
+static uint32_t diag_baseI2c = 0;
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Count duration of a sampling interrupt (ADC0 or DMA0).
+ * @param[in] Core clock cycles, including entry and exit
+ */
+void DIAG_IsrCycles(uint32_t cycles) {
+    if( cycles > diag_isrMax )
+        diag_isrMax = cycles;
+    if( cycles > ADC_CYCLE_BUDGET )
+        diag_isrOver++;
+    
+    /* avg += cycles - avg/2^DIAG_AVG_SHIFT */
+    diag_isrAvg += cycles - (diag_isrAvg >> DIAG_AVG_SHIFT);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Count frame processed by the main loop.
+ */
+void DIAG_FrameProcessed(void) {
+    diag_frames++;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Read all counters.
+ * @param[out] Snapshot of the counters
+ */
+void DIAG_Get(DiagCounters *counters) {
+    counters->framesProcessed = diag_frames;
+    counters->droppedFrames   = QUEUE_GetDroppedFrames() - diag_baseDropped;
+    counters->droppedSamples  = QUEUE_GetOverruns() - diag_baseOverruns;
+    counters->isrCyclesMax    = diag_isrMax;
+    counters->isrCyclesAvg    = diag_isrAvg >> DIAG_AVG_SHIFT;
+    counters->isrOverBudget   = diag_isrOver;
+    counters->i2cErrors       = I2C_GetFailedTransfers() - diag_baseI2c;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Start all counters from zero.
+ */
+void DIAG_Reset(void) {
+    diag_baseDropped  = QUEUE_GetDroppedFrames();
+    diag_baseOverruns = QUEUE_GetOverruns();
+    diag_baseI2c      = I2C_GetFailedTransfers();
+    diag_frames = 0;
+    
+    /* interrupt may update the values in between, the next one fixes it */
+    diag_isrMax  = 0;
+    diag_isrOver = 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Print counters on the LCD: frames on the first screen, interrupt
+ *        duration on the second one, I2C errors on the third one.
+ */
+void DIAG_Print(void) {
+    DiagCounters counters;
+    char line[17];
+    
+    DIAG_Get(&counters);
+    
+    LCD1602_ClearAll();
+    LCD1602_SetCursor(0,0);
+    snprintf(line, sizeof(line), "Frames  %8lu", (unsigned long)(counters.framesProcessed % 100000000));
+    LCD1602_Print(line);
+    LCD1602_SetCursor(0,1);
+    snprintf(line, sizeof(line), "Lost %4lu/%6lu", (unsigned long)(counters.droppedFrames % 10000), 
+                                                  (unsigned long)(counters.droppedSamples % 1000000));
+    LCD1602_Print(line);
+    FFT_DELAY(2000);
+    
+    LCD1602_ClearAll();
+    LCD1602_SetCursor(0,0);
+    snprintf(line, sizeof(line), "ISR max %4lu cy", (unsigned long)(counters.isrCyclesMax % 10000));
+    LCD1602_Print(line);
+    LCD1602_SetCursor(0,1);
+    snprintf(line, sizeof(line), "avg %4lu >%6lu", (unsigned long)(counters.isrCyclesAvg % 10000), 
+                                                  (unsigned long)(counters.isrOverBudget % 1000000));
+    LCD1602_Print(line);
+    FFT_DELAY(2000);
+    
+    LCD1602_ClearAll();
+    LCD1602_SetCursor(0,0);
+    snprintf(line, sizeof(line), "I2C errors %5lu", (unsigned long)(counters.i2cErrors % 100000));
+    LCD1602_Print(line);
+    FFT_DELAY(2000);
+    
+    LCD1602_ClearAll();
+}
@@ -0,0 +1,257 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   display.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for the queue of frames waiting for
+ *         the LCD. A frame is printed when the previous one has been sent
+ *         (in the background), so the next frame can be calculated meanwhile.
+ * @ver    0.1
+ */
+
+#include "display.h"
+#include "fft.h"
+#include "lcd1602.h"
+#include "glyph.h"
+#include "prof.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* levels of a bar in one character */
+#define DISPLAY_CELL_LEVELS      (GLYPH_STRIPS)
+
+/* time in milliseconds to frames, rounded, at least one */
+#define DISPLAY_MS_TO_FRAMES(ms, fps) (((uint32_t)(ms)*(fps) + 500)/1000 == 0 ? 1 : \
+                                       ((uint32_t)(ms)*(fps) + 500)/1000)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* frames waiting for the LCD (levels and peaks), oldest at display_read */
+static uint8_t display_frames[DISPLAY_FRAMES][DISPLAY_COLUMNS];
+static uint8_t display_peaks[DISPLAY_FRAMES][DISPLAY_COLUMNS];
+static uint8_t display_read = 0;
+static uint8_t display_count = 0;
+static uint32_t display_coalesced = 0;
+
+/* smoothed levels and frames spent below them */
+static uint8_t smooth_level[DISPLAY_COLUMNS];
+static uint16_t smooth_timer[DISPLAY_COLUMNS];
+
+/* current peaks and frames left until the next peak step */
+static uint8_t peak_level[DISPLAY_COLUMNS];
+static uint16_t peak_timer[DISPLAY_COLUMNS];
+
+/* DISPLAY_*_MS times in frames of the current mode */
+static uint16_t decay_frames      = DISPLAY_MS_TO_FRAMES(DISPLAY_DECAY_MS, FFT_FRAME_RATE);
+static uint16_t hysteresis_frames = DISPLAY_MS_TO_FRAMES(DISPLAY_HYSTERESIS_MS, FFT_FRAME_RATE);
+static uint16_t hold_frames       = DISPLAY_MS_TO_FRAMES(DISPLAY_PEAK_HOLD_MS, FFT_FRAME_RATE);
+static uint16_t fall_frames       = DISPLAY_MS_TO_FRAMES(DISPLAY_PEAK_FALL_MS, FFT_FRAME_RATE);
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+#if DISPLAY_SMOOTH
+static void DISPLAY_Smooth(const uint8_t *levels);
+#endif
+#if DISPLAY_PEAK_HOLD
+static void DISPLAY_UpdatePeaks(const uint8_t *levels);
+#endif
+static void DISPLAY_PutBar(uint8_t level, uint8_t peak, uint8_t col);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Smooth levels of a calculated frame and put it in the queue. If 
+ *            the queue is full, the newest waiting frame is replaced 
+ *            (coalesced).
+ * @param[in] Column levels: 0-16
+ */
+void DISPLAY_Submit(const uint8_t *levels) {
+    uint8_t slot;
+    
+#if DISPLAY_SMOOTH
+    DISPLAY_Smooth(levels);
+    levels = smooth_level;
+#endif
+#if DISPLAY_PEAK_HOLD
+    DISPLAY_UpdatePeaks(levels);
+#endif
+    
+    if( display_count == DISPLAY_FRAMES ) {
+        slot = (display_read + display_count - 1) % DISPLAY_FRAMES;
+        display_coalesced++;
+    }
+    else {
+        slot = (display_read + display_count) % DISPLAY_FRAMES;
+        display_count++;
+    }
+    
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        display_frames[slot][i] = levels[i];
+        display_peaks[slot][i] = peak_level[i];
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Print the next frame if the LCD is not busy with the previous one,
+ *         characters are sent in the background.
+ * @return 1 if a frame has been printed, 0 otherwise
+ */
+uint8_t DISPLAY_Service(void) {
+    uint32_t keypad;
+    
+    if( display_count == 0 || I2C_IsBusy() )
+        return 0;
+    
+    keypad = NVIC_GetEnableIRQ(PORTA_IRQn);
+    NVIC_DisableIRQ(PORTA_IRQn);
+    PROF_START(printStart);
+    
+#if DISPLAY_POLICY == DISPLAY_SHOW_NEWEST
+    /* frames calculated while the LCD was busy are stale */
+    display_coalesced += display_count - 1;
+    display_read = (display_read + display_count - 1) % DISPLAY_FRAMES;
+    display_count = 1;
+#endif
+    
+    /* draw all columns in memory, only changed characters are printed;
+       missing glyphs are loaded to CGRAM before that, bars first and peak 
+       markers in slots which are left */
+    GLYPH_BeginFrame();
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ )
+        DISPLAY_PutBar(display_frames[display_read][i], 0, i);
+#if DISPLAY_PEAK_HOLD
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        if( display_peaks[display_read][i] > display_frames[display_read][i] )
+            DISPLAY_PutBar(display_frames[display_read][i], display_peaks[display_read][i], i);
+    }
+#endif
+    display_read = (display_read + 1) % DISPLAY_FRAMES;
+    display_count--;
+    LCD1602_Flush();
+    
+    PROF_STOP(PROF_PRINT, printStart);
+    if( keypad )
+        NVIC_EnableIRQ(PORTA_IRQn);
+    
+    return 1;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Drop all waiting frames, smoothed levels and peaks (display has been
+ *        cleared).
+ */
+void DISPLAY_Reset(void) {
+    display_count = 0;
+    
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        smooth_level[i] = 0;
+        smooth_timer[i] = 0;
+        peak_level[i] = 0;
+        peak_timer[i] = 0;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Convert smoothing and peak times to frames for the frame rate of
+ *            the current mode.
+ * @param[in] Frames per second (FFT_MODE_FRAME_RATE)
+ */
+void DISPLAY_SetFrameRate(uint16_t framesPerSecond) {
+    decay_frames      = DISPLAY_MS_TO_FRAMES(DISPLAY_DECAY_MS, framesPerSecond);
+    hysteresis_frames = DISPLAY_MS_TO_FRAMES(DISPLAY_HYSTERESIS_MS, framesPerSecond);
+    hold_frames       = DISPLAY_MS_TO_FRAMES(DISPLAY_PEAK_HOLD_MS, framesPerSecond);
+    fall_frames       = DISPLAY_MS_TO_FRAMES(DISPLAY_PEAK_FALL_MS, framesPerSecond);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Number of frames dropped because a newer one was waiting.
+ * @return Coalesced frames
+ */
+uint32_t DISPLAY_GetCoalesced(void) {
+    return display_coalesced;
+}
+
+#if DISPLAY_SMOOTH
+/**-----------------------------------------------------------------------------
+ * @brief     Follow new levels at once when they rise and let the smoothed 
+ *            levels fall one step at a time.
+ * @param[in] Column levels: 0-16
+ */
+static void DISPLAY_Smooth(const uint8_t *levels) {
+    uint16_t frames;
+    
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        if( levels[i] >= smooth_level[i] ) {
+            smooth_level[i] = levels[i];
+            smooth_timer[i] = 0;
+            continue;
+        }
+        
+        frames = decay_frames;
+#if DISPLAY_HYSTERESIS
+        /* level just below the bar is treated as noise for a while */
+        if( levels[i] + 1 == smooth_level[i] )
+            frames = hysteresis_frames;
+#endif
+        if( ++smooth_timer[i] >= frames ) {
+            smooth_level[i]--;
+            smooth_timer[i] = 0;
+        }
+    }
+}
+#endif
+
+#if DISPLAY_PEAK_HOLD
+/**-----------------------------------------------------------------------------
+ * @brief     Raise peaks to new levels, hold them and let them fall.
+ * @param[in] Column levels: 0-16
+ */
+static void DISPLAY_UpdatePeaks(const uint8_t *levels) {
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        if( levels[i] >= peak_level[i] ) {
+            peak_level[i] = levels[i];
+            peak_timer[i] = hold_frames;
+        }
+        else if( peak_timer[i] )
+            peak_timer[i]--;
+        else {
+            peak_level[i]--;
+            peak_timer[i] = fall_frames;
+        }
+    }
+}
+#endif
+
+/**-----------------------------------------------------------------------------
+ * @brief     Draw bar with peak marker in two bottom rows of the frame.
+ * @param[in] Level: 0-16
+ * @param[in] Peak level: 0-16, not shown if not above the level
+ * @param[in] Column number
+ */
+static void DISPLAY_PutBar(uint8_t level, uint8_t peak, uint8_t col) {
+    uint8_t lowFill  = level > DISPLAY_CELL_LEVELS ? DISPLAY_CELL_LEVELS : level;
+    uint8_t highFill = level > DISPLAY_CELL_LEVELS ? level - DISPLAY_CELL_LEVELS : 0;
+    uint8_t lowPeak  = 0;
+    uint8_t highPeak = 0;
+    
+    if( peak > level ) {
+        if( peak > DISPLAY_CELL_LEVELS )
+            highPeak = peak - DISPLAY_CELL_LEVELS;
+        else
+            lowPeak = peak;
+    }
+    
+    LCD1602_PutChar(col, LCD1602_ROWS-1, GLYPH_Get(lowFill, lowPeak));
+    LCD1602_PutChar(col, LCD1602_ROWS-2, GLYPH_Get(highFill, highPeak));
+}
@@ -12,116 +12,279 @@
 
 #include "fft.h"
 #include "lcd1602.h"
+#include "level.h"
+#include "dft.h"
+#include "window.h"
+#include "prof.h"
+#include "dsp/transform_functions_f16.h"     /* FFT functions for float16_t */
 
 /******************************************************************************
  * Global variable definitions
  ******************************************************************************/
 
-float16_t FFT_Buffer[2][FFT_SIZE];
-float16_t FFT_Output[2*FFT_SIZE];
+fft_capture_t FFT_Buffer[FFT_BUFFERS][FFT_HOP_SIZE];
+fft_sample_t FFT_Output[2*FFT_SIZE];
 uint8_t FrequencyBins[16];
 FFT_Flags FFTstatus;
-uint8_t oldBins[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-
-/* Hann Window samples generated using MATLAB, can be used to apply window 
-   function on collected samples */
-const float16_t Hann_Window[FFT_SIZE] = {0, 0.0002, 0.0006, 0.0014, 0.0024, 0.0038, 0.0055, 0.0074, 0.0097, 0.0122, 0.0151, 0.0183, 
-    0.0217, 0.0254, 0.0295, 0.0338, 0.0384, 0.0432, 0.0484, 0.0538, 0.0595, 0.0655, 0.0717, 0.0782, 0.0849, 0.0919, 0.0991, 
-    0.1066, 0.1144, 0.1223, 0.1305, 0.1389, 0.1475, 0.1564, 0.1654, 0.1747, 0.1841, 0.1938, 0.2036, 0.2136, 0.2238, 0.2342, 
-    0.2447, 0.2554, 0.2662, 0.2771, 0.2882, 0.2994, 0.3108, 0.3223, 0.3338, 0.3455, 0.3573, 0.3691, 0.3810, 0.3930, 0.4051, 
-    0.4172, 0.4294, 0.4416, 0.4539, 0.4661, 0.4784, 0.4908, 0.5031, 0.5154, 0.5277, 0.5400, 0.5523, 0.5645, 0.5767, 0.5888, 
-    0.6009, 0.6130, 0.6249, 0.6368, 0.6486, 0.6604, 0.6720, 0.6835, 0.6949, 0.7062, 0.7173, 0.7284, 0.7393, 0.7500, 0.7606, 
-    0.7710, 0.7813, 0.7914, 0.8013, 0.8111, 0.8206, 0.8300, 0.8391, 0.8481, 0.8568, 0.8653, 0.8736, 0.8817, 0.8895, 0.8971, 
-    0.9045, 0.9116, 0.9185, 0.9251, 0.9315, 0.9376, 0.9434, 0.9489, 0.9542, 0.9592, 0.9640, 0.9684, 0.9726, 0.9765, 0.9801, 
-    0.9834, 0.9864, 0.9891, 0.9915, 0.9936, 0.9954, 0.9969, 0.9981, 0.9991, 0.9997, 1.0000, 1.0000, 0.9997, 0.9991, 0.9981, 
-    0.9969, 0.9954, 0.9936, 0.9915, 0.9891, 0.9864, 0.9834, 0.9801, 0.9765, 0.9726, 0.9684, 0.9640, 0.9592, 0.9542, 0.9489, 
-    0.9434, 0.9376, 0.9315, 0.9251, 0.9185, 0.9116, 0.9045, 0.8971, 0.8895, 0.8817, 0.8736, 0.8653, 0.8568, 0.8481, 0.8391, 
-    0.8300, 0.8206, 0.8111, 0.8013, 0.7914, 0.7813, 0.7710, 0.7606, 0.7500, 0.7393, 0.7284, 0.7173, 0.7062, 0.6949, 0.6835, 
-    0.6720, 0.6604, 0.6486, 0.6368, 0.6249, 0.6130, 0.6009, 0.5888, 0.5767, 0.5645, 0.5523, 0.5400, 0.5277, 0.5154, 0.5031, 
-    0.4908, 0.4784, 0.4661, 0.4539, 0.4416, 0.4294, 0.4172, 0.4051, 0.3930, 0.3810, 0.3691, 0.3573, 0.3455, 0.3338, 0.3223, 
-    0.3108, 0.2994, 0.2882, 0.2771, 0.2662, 0.2554, 0.2447, 0.2342, 0.2238, 0.2136, 0.2036, 0.1938, 0.1841, 0.1747, 0.1654, 
-    0.1564, 0.1475, 0.1389, 0.1305, 0.1223, 0.1144, 0.1066, 0.0991, 0.0919, 0.0849, 0.0782, 0.0717, 0.0655, 0.0595, 0.0538, 
-    0.0484, 0.0432, 0.0384, 0.0338, 0.0295, 0.0254, 0.0217, 0.0183, 0.0151, 0.0122, 0.0097, 0.0074, 0.0055, 0.0038, 0.0024, 
-    0.0014, 0.0006, 0.0002, 0}; 
-    
-/* Blackman-Harris Window samples generated using MATLAB, can be used to apply  
-   window function on collected samples */    
-const float16_t Blackman_Harris_Window[FFT_SIZE] = {0.0001, 0.0001, 0.0001, 0.0001, 0.0002, 0.0003, 0.0004, 0.0005, 0.0007, 0.0008, 
-    0.0010, 0.0013, 0.0016, 0.0019, 0.0022, 0.0026, 0.0031, 0.0036, 0.0042, 0.0048, 0.0055, 0.0063, 0.0072, 0.0081, 0.0092, 
-    0.0104, 0.0116, 0.0130, 0.0145, 0.0162, 0.0180, 0.0199, 0.0220, 0.0243, 0.0267, 0.0293, 0.0321, 0.0351, 0.0384, 0.0418, 
-    0.0454, 0.0493, 0.0535, 0.0579, 0.0625, 0.0674, 0.0726, 0.0781, 0.0839, 0.0900, 0.0963, 0.1030, 0.1100, 0.1173, 0.1250, 
-    0.1330, 0.1413, 0.1500, 0.1590, 0.1683, 0.1780, 0.1881, 0.1985, 0.2092, 0.2203, 0.2317, 0.2435, 0.2556, 0.2680, 0.2807, 
-    0.2938, 0.3072, 0.3209, 0.3348, 0.3491, 0.3636, 0.3784, 0.3934, 0.4087, 0.4242, 0.4398, 0.4557, 0.4717, 0.4879, 0.5042, 
-    0.5206, 0.5371, 0.5536, 0.5702, 0.5868, 0.6035, 0.6200, 0.6366, 0.6531, 0.6694, 0.6857, 0.7018, 0.7177, 0.7334, 0.7489, 
-    0.7642, 0.7792, 0.7938, 0.8082, 0.8222, 0.8358, 0.8490, 0.8618, 0.8742, 0.8861, 0.8975, 0.9083, 0.9187, 0.9285, 0.9378, 
-    0.9464, 0.9545, 0.9619, 0.9687, 0.9749, 0.9804, 0.9852, 0.9894, 0.9929, 0.9957, 0.9978, 0.9992, 0.9999, 0.9999, 0.9992, 
-    0.9978, 0.9957, 0.9929, 0.9894, 0.9852, 0.9804, 0.9749, 0.9687, 0.9619, 0.9545, 0.9464, 0.9378, 0.9285, 0.9187, 0.9083, 
-    0.8975, 0.8861, 0.8742, 0.8618, 0.8490, 0.8358, 0.8222, 0.8082, 0.7938, 0.7792, 0.7642, 0.7489, 0.7334, 0.7177, 0.7018, 
-    0.6857, 0.6694, 0.6531, 0.6366, 0.6200, 0.6035, 0.5868, 0.5702, 0.5536, 0.5371, 0.5206, 0.5042, 0.4879, 0.4717, 0.4557, 
-    0.4398, 0.4242, 0.4087, 0.3934, 0.3784, 0.3636, 0.3491, 0.3348, 0.3209, 0.3072, 0.2938, 0.2807, 0.2680, 0.2556, 0.2435, 
-    0.2317, 0.2203, 0.2092, 0.1985, 0.1881, 0.1780, 0.1683, 0.1590, 0.1500, 0.1413, 0.1330, 0.1250, 0.1173, 0.1100, 0.1030, 
-    0.0963, 0.0900, 0.0839, 0.0781, 0.0726, 0.0674, 0.0625, 0.0579, 0.0535, 0.0493, 0.0454, 0.0418, 0.0384, 0.0351, 0.0321, 
-    0.0293, 0.0267, 0.0243, 0.0220, 0.0199, 0.0180, 0.0162, 0.0145, 0.0130, 0.0116, 0.0104, 0.0092, 0.0081, 0.0072, 0.0063, 
-    0.0055, 0.0048, 0.0042, 0.0036, 0.0031, 0.0026, 0.0022, 0.0019, 0.0016, 0.0013, 0.0010, 0.0008, 0.0007, 0.0005, 0.0004, 
-    0.0003, 0.0002, 0.0001, 0.0001, 0.0001, 0.0001}; 
+
+/* Column i of modes 2-8 shows ((Mode-2)*16+i+1)*156 Hz. Modes 2-3 lower the 
+   sample rate, so the same frequency is covered by more (narrower) bins. An
+   even number of bins has no middle one: column k=(Mode-2)*16+i+1 sums bins
+   4k-2..4k+1 in mode 2 and 2k-1..2k in mode 3, so its band is centred half
+   a bin below the label (20 Hz in mode 2, 39 Hz in mode 3) */
+const FFT_ModeInfo FFT_Modes[FFT_MODES+1] = {
+    {0, 1, 0},     /* not used */
+    {0, 1, 1},     /* mode 1: 0 - 20000 Hz */
+    {2, 4, 2},     /* mode 2: 0 - 2500 Hz, 10 kHz sampling, 39 Hz bins, -20 Hz */
+    {1, 2, 33},    /* mode 3: 2500 - 5000 Hz, 20 kHz sampling, 78 Hz bins, -39 Hz */
+    {0, 1, 33},    /* mode 4: 5000 - 7500 Hz, CIC would alias 12.5 - 15 kHz */
+    {0, 1, 49},    /* mode 5: 7500 - 10000 Hz */
+    {0, 1, 65},    /* mode 6: 10000 - 12500 Hz */
+    {0, 1, 81},    /* mode 7: 12500 - 15000 Hz */
+    {0, 1, 97}     /* mode 8: 15000 - 17500 Hz */
+};
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* frequency to the nearest bin, for sample rate of mode 1 */
+#define FFT_HZ_TO_BIN(hz)        (((hz)*FFT_SIZE + FFT_SAMPLE_RATE/2)/FFT_SAMPLE_RATE)
+/* first bin of column i: at least one bin per column, no bins above Nyquist */
+#define FFT_BAND_EDGE(i, hz)     (FFT_HZ_TO_BIN(hz) <= (i)+1 ? (i)+1 :    \
+                                  FFT_HZ_TO_BIN(hz) >= FFT_SIZE/2 ? FFT_SIZE/2 : \
+                                  FFT_HZ_TO_BIN(hz))
+
+/* Mode 1 column i sums bins from Band_Edges[i] to Band_Edges[i+1]-1. Edges 
+   are half-octave steps from 80 Hz, calculated by the compiler for any 
+   FFT_SIZE; other edges (e.g. octave or user defined) can be put here as 
+   long as they grow faster than one bin per column */
+static const uint16_t Band_Edges[17] = {
+    FFT_BAND_EDGE( 0,    80), FFT_BAND_EDGE( 1,   113), FFT_BAND_EDGE( 2,   160),
+    FFT_BAND_EDGE( 3,   226), FFT_BAND_EDGE( 4,   320), FFT_BAND_EDGE( 5,   453),
+    FFT_BAND_EDGE( 6,   640), FFT_BAND_EDGE( 7,   905), FFT_BAND_EDGE( 8,  1280),
+    FFT_BAND_EDGE( 9,  1810), FFT_BAND_EDGE(10,  2560), FFT_BAND_EDGE(11,  3620),
+    FFT_BAND_EDGE(12,  5120), FFT_BAND_EDGE(13,  7241), FFT_BAND_EDGE(14, 10240),
+    FFT_BAND_EDGE(15, 14482), FFT_BAND_EDGE(16, 20480)
+};
+
+#if FFT_SIZE % FFT_HOP_SIZE
+#error "FFT_HOP_SIZE must divide FFT_SIZE"
+#endif
+
+/* log2(power) of columns of the current frame, Q8 format */
+static int32_t ColumnPower[16];
+
+#if FFT_WINDOW_IN_ISR
+#if FFT_HOP_SIZE != FFT_SIZE
+#error "FFT_WINDOW_IN_ISR requires FFT_HOP_SIZE equal to FFT_SIZE"
+#endif
+#else
+/* circular history of the last FFT_SIZE captured samples */
+static fft_capture_t FFT_History[FFT_SIZE];
+static uint16_t history_pos = 0;
+/* buffers appended since the history was reset, up to FFT_SIZE/FFT_HOP_SIZE */
+static uint8_t history_count = 0;
+#endif
+
+#if !FFT_WINDOW_IN_ISR || !FFT_FIXED_POINT
+/* windowed samples, input of FFT */
+static fft_sample_t FFT_Frame[FFT_SIZE];
+#endif
+
+
+#if FFT_FIXED_POINT
+static arm_rfft_instance_q15 fft;
+/* log2 (Q8) of the Q15 to float16_t power scale factor */
+static int32_t fft_powerScale;
+
+/* power of bins, wide enough for sums of bins */
+typedef uint64_t fft_power_t;
+#define FFT_POWER_LOG2(x)        (LEVEL_Log2Long(x) + fft_powerScale)
+#else
+static arm_rfft_fast_instance_f16 fft;
+
+/* power of bins */
+typedef float32_t fft_power_t;
+#define FFT_POWER_LOG2(x)        LEVEL_Log2Float(x)
+#endif
 
 /******************************************************************************
  * Function definitions
  ******************************************************************************/
 
 /**-----------------------------------------------------------------------------
- * @brief       Calculate column length for choosen frequencies.
- * @param[in]   Buffer number (0 or 1)
+ * @brief  Initialize FFT instance for the selected pipeline.
+ * @return ARM_MATH_SUCCESS or error status.
+ */
+arm_status FFT_Init(void) {
+#if FFT_FIXED_POINT
+    fft_powerScale = 2*LEVEL_Log2(FFT_Q15_BIN_SCALE);
+    
+    /* forward transform, normal bit order */
+    return arm_rfft_init_q15(&fft, FFT_SIZE, 0, 1);
+#else
+    return arm_rfft_fast_init_f16(&fft, FFT_SIZE);
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Forget the sample history, e.g. after frames were lost by the queue.
+ *        With overlap no FFT is calculated until FFT_SIZE new samples have 
+ *        been collected.
+ */
+void FFT_ResetHistory(void) {
+#if !FFT_WINDOW_IN_ISR
+    history_count = 0;
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Append buffer to the sample history, apply window on the last 
+ *            FFT_SIZE samples, calculate FFT and column lengths. With 
+ *            FFT_WINDOW_IN_ISR the buffer is already windowed and is used 
+ *            directly as FFT input (its content is destroyed).
+ * @param[in] Buffer number: 0 to FFT_BUFFERS-1
+ * @return    1 if FrequencyBins were calculated, 0 if the history is not
+ *            filled yet (see FFT_ResetHistory)
+ */
+uint8_t FFT_ProcessBuffer(uint8_t bufferNumber) {
+#if FFT_WINDOW_IN_ISR && FFT_FIXED_POINT
+    /* samples have been windowed in ADC0 interrupt, buffer is FFT input */
+    fft_sample_t *frame = FFT_Buffer[bufferNumber];
+#else
+    fft_sample_t *frame = FFT_Frame;
+#endif
+#if !FFT_WINDOW_IN_ISR
+    uint16_t idx;
+#endif
+    PROF_START(windowStart);
+#if !FFT_WINDOW_IN_ISR
+    
+    /* history is needed by mode 1 even if current frame comes from DFT */
+    for( uint16_t i=0; i<FFT_HOP_SIZE; i++ )
+        FFT_History[history_pos+i] = FFT_Buffer[bufferNumber][i];
+    history_pos = (history_pos + FFT_HOP_SIZE) & (FFT_SIZE-1);
+    if( history_count < FFT_SIZE/FFT_HOP_SIZE )
+        history_count++;
+    
+    /* an overlapping frame (FFT or DFT) would be spliced across lost samples */
+    if( history_count < FFT_SIZE/FFT_HOP_SIZE ) {
+        PROF_STOP(PROF_WINDOW, windowStart);
+        return 0;
+    }
+#endif
+    
+#if FFT_DFT_BINS
+    /* bins of modes 4-8 have been already calculated while sampling */
+    if( DFT_IsValid(bufferNumber, FFTstatus.mode) ) {
+        PROF_STOP(PROF_WINDOW, windowStart);
+        PROF_START(columnsStart);
+        for( uint8_t i=0; i<DFT_BINS; i++ )
+            ColumnPower[i] = DFT_BinLog2Power(bufferNumber, i);
+        LEVEL_MapColumns(ColumnPower, FrequencyBins, DFT_BINS);
+        PROF_STOP(PROF_COLUMNS, columnsStart);
+        return 1;
+    }
+#endif
+    
+#if !FFT_WINDOW_IN_ISR
+    /* apply selected window function on samples, oldest sample is at 
+       history_pos; conversion to float16_t is done here for the whole frame */
+    idx = history_pos;
+    for( uint16_t i=0; i<FFT_SIZE; i++ ) {
+        FFT_Frame[i] = FFT_FROM_CAPTURE(FFT_WINDOW_SAMPLE(FFT_History[idx], WINDOW_Coeff(i)));
+        idx = (idx + 1) & (FFT_SIZE-1);
+    }
+#elif !FFT_FIXED_POINT
+    /* samples have been windowed in ADC0 interrupt, only conversion left */
+    for( uint16_t i=0; i<FFT_SIZE; i++ )
+        FFT_Frame[i] = FFT_FROM_CAPTURE(FFT_Buffer[bufferNumber][i]);
+#endif
+    PROF_STOP(PROF_WINDOW, windowStart);
+    
+    /* calculate FFT */
+    PROF_START(fftStart);
+#if FFT_FIXED_POINT
+    arm_rfft_q15(&fft, frame, FFT_Output);
+#else
+    arm_rfft_fast_f16(&fft, frame, FFT_Output, 0);
+#endif
+    PROF_STOP(PROF_FFT, fftStart);
+    
+    /* colect proper bins to the LCD, power is calculated only for them */
+    PROF_START(columnsStart);
+    FFT_CalculateColumns_256();
+    PROF_STOP(PROF_COLUMNS, columnsStart);
+    return 1;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Power of a single frequency bin, taken directly from FFT output 
+ *            (no square root, no magnitude buffer).
+ * @param[in] Bin number, 1 to FFT_SIZE/2-1
+ * @return    re^2+im^2
+ */
+static fft_power_t FFT_BinPower(uint16_t bin) {
+#if FFT_FIXED_POINT
+    int32_t re = FFT_Output[2*bin];
+    int32_t im = FFT_Output[2*bin+1];
+    
+    return (uint32_t)(re*re) + (uint32_t)(im*im);
+#else
+    float32_t re = FFT_Output[2*bin];
+    float32_t im = FFT_Output[2*bin+1];
+    
+    return re*re + im*im;
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Power of a column which sums power of consecutive bins.
+ * @param[in] First bin
+ * @param[in] Number of bins
+ * @return    log2(power) in Q8 format, float16_t pipeline scale
+ */
+static int32_t FFT_ColumnLog2Power(uint16_t first, uint8_t count) {
+    fft_power_t power = 0;
+    
+    for( uint8_t i=0; i<count; i++ )
+        power += FFT_BinPower(first+i);
+    
+    /* levels of a tone do not depend on the selected window */
+    return FFT_POWER_LOG2(power) + WINDOW_PowerCorrection();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief       Calculate column length for choosen frequencies from FFT_Output.
  * @descritpion Frequencies on given columns are respectively:
  * 
  * For Mode 1:
- *  [1] [2] [3] [4] [5] [6]  [7]  [8]  [9] [10] [11] [12] [13] [14]  [15]  [16] 
- * |156|312|469|625|781|938|1094|1250|1407|2500|3750|5000|7031|9062|12031|14844|
+ * half-octave bands from 80 Hz to 20 kHz, each column sums power of all bins 
+ * in its band (bands narrower than a bin get one bin)
  *   
  * For Mode 2-8:
- * ((Mode-2)*16+N+1)*156, where N is integer in range 0-15  
+ * ((Mode-2)*16+N+1)*156, where N is integer in range 0-15, each column sums
+ * FFT_Modes[Mode].binsPerColumn bins 
  */
-void FFT_CalculateColumns_256(uint8_t bufferNumber) {
+void FFT_CalculateColumns_256(void) {
     
     if( FFTstatus.mode == 1 ) {
-        for( uint8_t i=1; i<10; i++ ) {
-            FrequencyBins[i-1] = (uint8_t)(log10(FFT_Buffer[bufferNumber][i])
-                                  *16/FFT_AVG_MAX_VALUE);
+        /* single pass over bins 1 to FFT_SIZE/2-1 */
+        for( uint8_t i=0; i<16; i++ ) {
+            ColumnPower[i] = FFT_ColumnLog2Power(Band_Edges[i], 
+                                                 Band_Edges[i+1]-Band_Edges[i]);
         }
-    
-        FrequencyBins[9]  = (uint8_t)(log10(FFT_Buffer[bufferNumber][16])
-                             *16/FFT_AVG_MAX_VALUE);
-        FrequencyBins[10] = (uint8_t)(log10(FFT_Buffer[bufferNumber][24])
-                             *16/FFT_AVG_MAX_VALUE);
-        FrequencyBins[11] = (uint8_t)(log10(FFT_Buffer[bufferNumber][32])
-                             *16/FFT_AVG_MAX_VALUE);
-        FrequencyBins[12] = (uint8_t)(log10(FFT_Buffer[bufferNumber][45])
-                             *16/FFT_AVG_MAX_VALUE);
-        FrequencyBins[13] = (uint8_t)(log10(FFT_Buffer[bufferNumber][58])
-                             *16/FFT_AVG_MAX_VALUE);
-        FrequencyBins[14] = (uint8_t)(log10(FFT_Buffer[bufferNumber][77])
-                             *16/FFT_AVG_MAX_VALUE);
-        FrequencyBins[15] = (uint8_t)(log10(FFT_Buffer[bufferNumber][95])
-                             *16/FFT_AVG_MAX_VALUE);
     }
     else {
+        const FFT_ModeInfo *info = &FFT_Modes[FFTstatus.mode];
+        
         for( uint8_t i=0; i<16; i++ ) {
-            FrequencyBins[i] = (uint8_t)(log10(FFT_Buffer[bufferNumber]
-                               [(FFTstatus.mode-2)*16+i+1])*16/FFT_AVG_MAX_VALUE);
+            ColumnPower[i] = FFT_ColumnLog2Power(info->firstBin + i*info->binsPerColumn,
+                                                 info->binsPerColumn);
         }
     }
+    
+    /* fixed range or automatic gain (LEVEL_AGC) */
+    LEVEL_MapColumns(ColumnPower, FrequencyBins, 16);
 }
-
-/**-----------------------------------------------------------------------------
- * @brief Print frequency bin columns on LCD
- */
-void FFT_PrintColumns(void) {
-    for( uint8_t i=0; i<16; i++ ) {
-        FrequencyBins[i] = FrequencyBins[i] >= 10 ? FrequencyBins[i] -= 9 : 0;
-        /* check if value needs to be printed "again" */
-        if( oldBins[i] != FrequencyBins[i] ) {
-            LCD1602_PrintLVL_16_FFT(FrequencyBins[i], oldBins[i], i);
-            oldBins[i] = FrequencyBins[i];
-        }
-    }
-}
\ No newline at end of file
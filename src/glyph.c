@@ -0,0 +1,165 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   glyph.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for the manager of LCD custom 
+ *         characters. Bar glyphs (fill and peak marker) are composed on 
+ *         demand and kept in the eight CGRAM slots, least recently used slot
+ *         is rewritten when a frame needs a glyph which is not loaded.
+ * @ver    0.1
+ */
+
+#include "glyph.h"
+#include "lcd1602.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* glyph identifier: filled strips and peak marker strip */
+#define GLYPH_KEY(fill, peak)    ((uint8_t)(((fill) << 4) | (peak)))
+#define GLYPH_NONE               (0xFF)
+/* LCD ROM characters */
+#define GLYPH_SPACE              (' ')
+#define GLYPH_BLOCK              ((char)0xFF)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* glyph loaded to each slot, last use (for LRU) and last frame using it */
+static uint8_t glyph_key[GLYPH_SLOTS];
+static uint32_t glyph_lastUse[GLYPH_SLOTS];
+static uint16_t glyph_lastFrame[GLYPH_SLOTS];
+
+static uint32_t glyph_clock = 0;
+static uint16_t glyph_frame = 0;
+static uint32_t glyph_uploads = 0;
+static uint8_t glyph_peakUploads = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static int8_t GLYPH_Load(uint8_t key);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief Forget loaded characters, slots 0-7 hold bars of 1-8 strips (loaded
+ *        by LCD1602_LVL_CH).
+ */
+void GLYPH_Reset(void) {
+    for( uint8_t i=0; i<GLYPH_SLOTS; i++ ) {
+        glyph_key[i] = GLYPH_KEY(i+1, 0);
+        glyph_lastUse[i] = 0;
+        glyph_lastFrame[i] = glyph_frame;
+    }
+    glyph_frame++;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Start a new frame, slots used in this frame are not rewritten until
+ *        the next one.
+ */
+void GLYPH_BeginFrame(void) {
+    glyph_frame++;
+    glyph_peakUploads = 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Character of a bar cell, glyph is loaded to CGRAM if needed.
+ *            If all slots are taken by this frame (or GLYPH_PEAK_UPLOADS is
+ *            reached), peak marker is dropped and then the nearest ROM 
+ *            character is used.
+ * @param[in] Filled strips from the bottom: 0-8
+ * @param[in] Strip with peak marker: 1-8, 0 - no marker
+ * @return    Character code for the display
+ */
+char GLYPH_Get(uint8_t fill, uint8_t peak) {
+    uint8_t key;
+    int8_t slot = -1;
+    
+    if( fill > GLYPH_STRIPS )
+        fill = GLYPH_STRIPS;
+    if( peak <= fill || peak > GLYPH_STRIPS )
+        peak = 0;
+    
+    /* characters which are always available */
+    if( fill == 0 && peak == 0 )
+        return GLYPH_SPACE;
+#if GLYPH_ROM_BLOCK
+    if( fill == GLYPH_STRIPS )
+        return GLYPH_BLOCK;
+#endif
+    
+    key = GLYPH_KEY(fill, peak);
+    for( uint8_t i=0; i<GLYPH_SLOTS; i++ ) {
+        if( glyph_key[i] == key )
+            slot = i;
+    }
+    if( slot < 0 && (peak == 0 || glyph_peakUploads < GLYPH_PEAK_UPLOADS) ) {
+        slot = GLYPH_Load(key);
+        if( slot >= 0 && peak )
+            glyph_peakUploads++;
+    }
+    
+    if( slot < 0 ) {
+        if( peak )
+            return GLYPH_Get(fill, 0);
+        return fill >= GLYPH_STRIPS/2 ? GLYPH_BLOCK : GLYPH_SPACE;
+    }
+    
+    glyph_lastUse[slot] = ++glyph_clock;
+    glyph_lastFrame[slot] = glyph_frame;
+    
+    return (char)slot;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Number of characters loaded to CGRAM since reset.
+ * @return Uploads
+ */
+uint32_t GLYPH_GetUploads(void) {
+    return glyph_uploads;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Compose glyph and load it to the least recently used slot which
+ *            is not used in the current frame.
+ * @param[in] Glyph identifier
+ * @return    Slot number or -1 if all slots are used in the current frame
+ */
+static int8_t GLYPH_Load(uint8_t key) {
+    uint8_t fill = key >> 4;
+    uint8_t peak = key & 0x0F;
+    uint8_t rows[GLYPH_STRIPS];
+    int8_t slot = -1;
+    
+    for( uint8_t i=0; i<GLYPH_SLOTS; i++ ) {
+        if( glyph_lastFrame[i] == glyph_frame )
+            continue;
+        if( slot < 0 || glyph_lastUse[i] < glyph_lastUse[slot] )
+            slot = i;
+    }
+    if( slot < 0 )
+        return -1;
+    
+    /* first row is the top one, strips are counted from the bottom */
+    for( uint8_t row=0; row<GLYPH_STRIPS; row++ ) {
+        uint8_t strip = GLYPH_STRIPS - row;
+        rows[row] = (strip <= fill || strip == peak) ? 0x1F : 0x00;
+    }
+    
+    LCD1602_LoadChar((uint8_t)slot, rows);
+    glyph_key[slot] = key;
+    glyph_uploads++;
+    
+    return slot;
+}
@@ -19,6 +19,13 @@
 #define SCL   9
 #define SDA   8
 
+/* write of a flag or data register of I2C0; host tests replace it by a 
+   register model (flags are cleared by writing 1, a byte written to D is
+   shifted out) */
+#ifndef I2C_WRITE
+#define I2C_WRITE(reg, value)    (I2C0->reg = (uint8_t)(value))
+#endif
+
 /****************************************************************************** 
  * Private prototypes
  ******************************************************************************/
@@ -35,6 +42,13 @@ uint8_t i2c_recv(void);
 void i2c_wait(void);
 void i2c_nack(void);
 void i2c_ack(void);
+#if I2C_ASYNC
+static void i2c_startNext(void);
+static void i2c_start(void);
+static void i2c_service(void);
+static void i2c_finish(void);
+static void i2c_poll(void);
+#endif
 
 /****************************************************************************** 
  * Private memory declarations
@@ -43,6 +57,36 @@ void i2c_ack(void);
 static uint8_t error;
 static uint16_t timeout;
 
+#if I2C_ASYNC
+/**
+ * @brief transaction waiting for background transmission
+ */
+typedef struct {
+    uint8_t      address;
+    uint8_t      size;
+    I2C_Callback done;
+} I2C_Transfer;
+
+/* transactions and their bytes, head is moved by writer and tail by 
+   transmission (free running counters) */
+static I2C_Transfer i2c_queue[I2C_TX_QUEUE];
+static uint8_t i2c_buffer[I2C_TX_BUFFER];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+static volatile uint16_t buffer_head = 0;
+static volatile uint16_t buffer_tail = 0;
+
+/* state of the current transaction */
+static volatile uint8_t async_active = 0;
+static volatile uint8_t async_sent = 0;
+static volatile uint8_t async_error = 0;
+static volatile uint8_t async_errors = 0;
+static volatile uint32_t async_failed = 0;
+static uint16_t async_timeout = 0;
+/* next transaction waits for the stop condition of the previous one */
+static volatile uint8_t async_waitStop = 0;
+#endif
+
 /****************************************************************************** 
  * Function definitions
  ******************************************************************************/
@@ -62,8 +106,14 @@ void I2C_Init(void) {
     /* Set baud rate = BusClock / (2^MULT * SCLdivider) */
     I2C0->F  |= I2C_F_MULT(0x1);        /* MULT = 0,1,2 */
     I2C0->F  |= I2C_F_ICR(0x1B);        /* SCLdivider */ 
-                                        
-    I2C0->C1 |= I2C_C1_IICIE_MASK;      /* enable interrupts */
+    
+#if I2C_ASYNC
+    /* interrupts are enabled in the module only for background transactions;
+       same priority as keypad, which may serve the queue by polling */
+    NVIC_ClearPendingIRQ(I2C0_IRQn);
+    NVIC_SetPriority(I2C0_IRQn, 0);
+    NVIC_EnableIRQ(I2C0_IRQn);
+#endif
 }
 
 /**-----------------------------------------------------------------------------
@@ -127,6 +177,7 @@ uint8_t I2C_Read(uint8_t address, uint8_t* data) {
     i2c_rec();                               /* set to receive mode */
     i2c_nack();
     dummy = i2c_recv();                      /* read data */
+    (void)dummy;
     i2c_wait();
     i2c_m_stop();                            /* clear start mask */
     (*data) = i2c_recv();
@@ -135,6 +186,268 @@ uint8_t I2C_Read(uint8_t address, uint8_t* data) {
     return error;
 }
 
+/**-----------------------------------------------------------------------------
+ * @brief     I2C burst write. Write block of bytes to specified device address
+ *            in one transmission (one start, address and stop). Works best 
+ *            with I/O expanders, every byte is a new state of the outputs.
+ * @param[in] Address of slave.
+ * @param[in] Count of bytes to write.
+ * @param[in] Data to write.
+ * @return    Errors.
+ */
+uint8_t I2C_WriteBlock(uint8_t address, uint8_t size, uint8_t* data) {
+    error = 0x00;
+    uint8_t cnt = 0;
+    
+    i2c_enable();
+    i2c_tran();                         /* set to transmit mode */
+    i2c_m_start();                      /* send start */
+    i2c_send((uint8_t)(address << 1));  /* send write address */
+    i2c_wait();                         /* wait for ack from slave */
+    
+    while( cnt < size ) {
+        i2c_send(data[cnt++]);          /* send data */
+        i2c_wait();
+    }
+    
+    i2c_m_stop();                       /* clear start mask */
+    i2c_disable();
+    
+    return error;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     I2C burst write in the background. Data is copied to the transmit
+ *            queue, function waits only if the queue is full.
+ * @param[in] Address of slave.
+ * @param[in] Count of bytes to write.
+ * @param[in] Data to write.
+ * @param[in] Function called when transaction is finished (or 0), it may be 
+ *            called from I2C0 interrupt.
+ * @return    Errors (I2C_ASYNC 0 only, otherwise they are passed to callback).
+ */
+uint8_t I2C_WriteBlockAsync(uint8_t address, uint8_t size, uint8_t* data, I2C_Callback done) {
+#if I2C_ASYNC
+    I2C_Transfer *transfer;
+    
+    /* wait for free space, queue is served by polling if interrupt can not 
+       be taken now */
+    while( (uint8_t)(queue_head - queue_tail) >= I2C_TX_QUEUE ||
+           (uint16_t)(buffer_head - buffer_tail) > I2C_TX_BUFFER - size )
+        i2c_poll();
+    
+    for( uint8_t i=0; i<size; i++ )
+        i2c_buffer[(uint16_t)(buffer_head + i) & (I2C_TX_BUFFER-1)] = data[i];
+    transfer = &i2c_queue[queue_head & (I2C_TX_QUEUE-1)];
+    transfer->address = address;
+    transfer->size = size;
+    transfer->done = done;
+    
+    NVIC_DisableIRQ(I2C0_IRQn);
+    buffer_head += size;
+    queue_head++;
+    if( !async_active )
+        i2c_startNext();
+    NVIC_EnableIRQ(I2C0_IRQn);
+    
+    return 0;
+#else
+    uint8_t errors = I2C_WriteBlock(address, size, data);
+    
+    if( done )
+        done(errors);
+    
+    return errors;
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Wait until all background transactions are finished.
+ */
+void I2C_Wait(void) {
+#if I2C_ASYNC
+    while( async_active )
+        i2c_poll();
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Check if background transactions are in progress.
+ * @return 1 if transmitting, 0 otherwise
+ */
+uint8_t I2C_IsBusy(void) {
+#if I2C_ASYNC
+    return async_active;
+#else
+    return 0;
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Errors of background transactions since the last call.
+ * @return Errors.
+ */
+uint8_t I2C_GetAsyncErrors(void) {
+#if I2C_ASYNC
+    uint8_t errors;
+    
+    NVIC_DisableIRQ(I2C0_IRQn);
+    errors = async_errors;
+    async_errors = 0;
+    NVIC_EnableIRQ(I2C0_IRQn);
+    
+    return errors;
+#else
+    return 0;
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Number of background transactions which ended with an error, the
+ *         counter is never cleared.
+ * @return Failed transactions.
+ */
+uint32_t I2C_GetFailedTransfers(void) {
+#if I2C_ASYNC
+    return async_failed;
+#else
+    return 0;
+#endif
+}
+
+#if I2C_ASYNC
+/**-----------------------------------------------------------------------------
+ * @brief I2C0 interrupt, next step of the background transaction or the stop
+ *        condition the next transaction waits for.
+ */
+void I2C0_IRQHandler(void) {
+    if( async_waitStop ) {
+        if( I2C0->FLT & I2C_FLT_STOPF_MASK )
+            i2c_start();
+    }
+    else if( I2C0->S & I2C_S_IICIF_MASK )
+        i2c_service();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Start the oldest queued transaction. If the stop condition of the 
+ *        previous one is still on the bus, the start is left to the stop 
+ *        detection interrupt (or i2c_poll) instead of waiting here.
+ */
+static void i2c_startNext(void) {
+    async_active = 1;
+    async_sent = 0;
+    async_error = 0;
+    async_timeout = 0;
+    
+    I2C0->C1 |= I2C_C1_IICEN_MASK | I2C_C1_IICIE_MASK;
+    
+    /* stop detection is armed before the bus is checked, so a stop in 
+       between is not missed (STOPF is write 1 to clear) */
+    I2C_WRITE(FLT, I2C0->FLT | I2C_FLT_STOPF_MASK | I2C_FLT_STOPIE_MASK);
+    if( I2C0->S & I2C_S_BUSY_MASK ) {
+        async_waitStop = 1;
+        return;
+    }
+    i2c_start();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Bus is free: disarm stop detection and send start and address of the
+ *        oldest queued transaction.
+ */
+static void i2c_start(void) {
+    /* stop sets IICIF too, it must not be taken for a transmitted byte */
+    I2C_WRITE(FLT, (I2C0->FLT & ~I2C_FLT_STOPIE_MASK) | I2C_FLT_STOPF_MASK);
+    I2C_WRITE(S, I2C0->S | I2C_S_IICIF_MASK);
+    async_waitStop = 0;
+    async_timeout = 0;
+    
+    i2c_tran();                         /* set to transmit mode */
+    i2c_m_start();                      /* send start */
+    i2c_send((uint8_t)(i2c_queue[queue_tail & (I2C_TX_QUEUE-1)].address << 1));
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Byte has been transmitted: send next one or finish transaction.
+ */
+static void i2c_service(void) {
+    uint8_t status = I2C0->S;
+    
+    I2C_WRITE(S, I2C0->S | I2C_S_IICIF_MASK);
+    async_timeout = 0;
+    
+    if( status & I2C_S_ARBL_MASK ) {
+        I2C_WRITE(S, I2C0->S | I2C_S_ARBL_MASK);
+        async_error |= I2C_ERR_ARBLOST;
+        i2c_finish();
+    }
+    else if( status & I2C_S_RXAK_MASK ) {
+        async_error |= I2C_ERR_NOACK;
+        i2c_finish();
+    }
+    else if( async_sent < i2c_queue[queue_tail & (I2C_TX_QUEUE-1)].size ) {
+        i2c_send(i2c_buffer[(uint16_t)(buffer_tail + async_sent) & (I2C_TX_BUFFER-1)]);
+        async_sent++;
+    }
+    else
+        i2c_finish();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Stop current transaction, report it and start the next one.
+ */
+static void i2c_finish(void) {
+    I2C_Transfer *transfer = &i2c_queue[queue_tail & (I2C_TX_QUEUE-1)];
+    I2C_Callback done = transfer->done;
+    uint8_t errors = async_error;
+    
+    i2c_m_stop();                       /* clear start mask */
+    async_errors |= errors;
+    if( errors )
+        async_failed++;
+    buffer_tail += transfer->size;
+    queue_tail++;
+    
+    if( queue_tail != queue_head )
+        i2c_startNext();
+    else {
+        I2C0->C1 &= ~I2C_C1_IICIE_MASK;
+        i2c_disable();
+        async_active = 0;
+    }
+    
+    if( done )
+        done(errors);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Serve background transaction without interrupt (caller may have 
+ *        the same or higher priority), give up if the bus does not respond.
+ *        A start waiting for the stop condition is sent once the bus is free
+ *        (or after the timeout, the transaction then reports its errors).
+ */
+static void i2c_poll(void) {
+    NVIC_DisableIRQ(I2C0_IRQn);
+    
+    if( async_waitStop ) {
+        if( (I2C0->FLT & I2C_FLT_STOPF_MASK) || !(I2C0->S & I2C_S_BUSY_MASK) 
+            || ++async_timeout >= 10000 )
+            i2c_start();
+    }
+    else if( async_active ) {
+        if( I2C0->S & I2C_S_IICIF_MASK )
+            i2c_service();
+        else if( ++async_timeout >= 10000 ) {
+            async_error |= I2C_ERR_TIMEOUT;
+            i2c_finish();
+        }
+    }
+    
+    NVIC_EnableIRQ(I2C0_IRQn);
+}
+#endif
+
 /**-----------------------------------------------------------------------------
  * @brief     I2C write to register.  
  * @param[in] Address of slave.
@@ -188,6 +501,7 @@ uint8_t I2C_ReadReg(uint8_t address, uint8_t reg, uint8_t* data) {
     i2c_rec();             /* set to receive mode */
     i2c_nack();            /* no acknowledge bit */
     dummy = i2c_recv();    /* read data */
+    (void)dummy;
     i2c_wait();
     i2c_m_stop();          /* clear start mask */
     (*data) = i2c_recv();
@@ -235,6 +549,7 @@ uint8_t I2C_ReadRegBlock(uint8_t address, uint8_t reg, uint8_t size, uint8_t* da
     
     i2c_nack();               /* no acknowledge bit */
     dummy = i2c_recv();       /* read data */
+    (void)dummy;
     i2c_wait();
     i2c_m_stop();             /* set start mask off */    
     data[cnt] = i2c_recv();
@@ -284,9 +599,10 @@ void i2c_rec(void) {
 }
 
 /**-----------------------------------------------------------------------------
- * @brief I2C enable.
+ * @brief I2C enable, background transactions are finished first.
  */
 void i2c_enable(void) {
+    I2C_Wait();
     I2C0->C1 |= I2C_C1_IICEN_MASK;
 }
 
@@ -301,7 +617,7 @@ void i2c_disable(void) {
  * @brief I2C send data.
  */
 void i2c_send(uint8_t data) {
-    I2C0->D = data;
+    I2C_WRITE(D, data);
 }
 
 /**-----------------------------------------------------------------------------
@@ -323,7 +639,7 @@ void i2c_wait(void) {
         error |= I2C_ERR_TIMEOUT; 
     if( (I2C0->S & I2C_S_RXAK_MASK)==1 ) 
         error |= I2C_ERR_NOACK;
-    I2C0->S |= I2C_S_IICIF_MASK;
+    I2C_WRITE(S, I2C0->S | I2C_S_IICIF_MASK);
 }
 
 /**-----------------------------------------------------------------------------
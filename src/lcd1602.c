@@ -11,6 +11,7 @@
  */
 
 #include "lcd1602.h"
+#include "timer.h"
 
 /******************************************************************************
  * Private definitions
@@ -18,9 +19,37 @@
 
 /* LCD functions */
 #define LCD_CLEARDISPLAY    0x01
+#define LCD_RETURNHOME      0x02
+#define LCD_CURSORSHIFT     0x10
+#define LCD_SETCGRAMADDR    0x40
 #define LCD_SETDDRAMADDR    0x80
 #define LCD_FULLLINE        0x40
 
+/* last DDRAM address of the first and the second line (2-line mode) */
+#define LCD_LINE1_END       0x27
+#define LCD_LINE2_END       0x67
+/* address counter does not point to DDRAM or is not known */
+#define LCD_NOADDR          0xFF
+
+/* HD44780 execution times, us (datasheet, fosc = 270 kHz) */
+#define LCD_POWERON_US      15000   /* after Vcc rises to 4.5 V */
+#define LCD_RESET1_US       4100    /* after the first reset nibble */
+#define LCD_RESET2_US       100     /* after the second reset nibble */
+#define LCD_EXEC_US         37      /* most instructions and data writes */
+#define LCD_CLEAR_US        1520    /* clear display and return home */
+
+/* expander bytes sent in one I2C transaction: a row of characters with a set
+   cursor command (4 bytes per LCD byte, EN high and EN low for each nibble);
+   at ~94 kHz SCL one byte on the bus takes ~96 us, so an instruction is
+   followed by at least two bytes (~190 us > LCD_EXEC_US) before the next 
+   one; commands and characters need no waiting, within a burst and between
+   transactions (start and address) */
+#define LCD_BURST_SIZE      (4*(LCD1602_COLS+1))
+
+#if LCD1602_ROWS > 4 || LCD1602_COLS > 20
+#error "Unsupported LCD size"
+#endif
+
 /* PCF8574 */
 #define PCF8574_ADDRESS     0x27 
 #define PCF8574A_ADDRESS    0x3f
@@ -38,6 +67,27 @@
 static uint8_t lcd_backlight = 1;
 static uint8_t pcf_address = PCF8574_ADDRESS;
 
+/* DDRAM address of the first character of each row */
+static const uint8_t Row_Address[4] = {0x00, LCD_FULLLINE, 0x14, LCD_FULLLINE+0x14};
+
+/* frame to be displayed and characters which are on the display now */
+static char lcd_frame[LCD1602_ROWS][LCD1602_COLS];
+static char lcd_screen[LCD1602_ROWS][LCD1602_COLS];
+/* DDRAM address counter of the display */
+static uint8_t lcd_address = LCD_NOADDR;
+
+/* expander bytes waiting for transmission; bytes are collected while 
+   lcd_batch (nesting depth) is not 0, keypad interrupt is masked meanwhile
+   and lcd_keypad tells if it was enabled before the outermost batch */
+static uint8_t lcd_burst[LCD_BURST_SIZE];
+static uint8_t lcd_burst_len = 0;
+static uint8_t lcd_batch = 0;
+static uint8_t lcd_keypad = 0;
+
+/* LCD is executing an instruction: lcd_busy cycles since lcd_stamp */
+static uint32_t lcd_stamp = 0;
+static uint32_t lcd_busy = 0;
+
 /****************************************************************************** 
  * Private prototypes
  ******************************************************************************/
@@ -46,6 +96,13 @@ void PCF8574_Write(uint8_t data);
 void LCD1602_Write4(uint8_t data, uint8_t rs);
 void LCD1602_Write8(uint8_t data, uint8_t rs);
 void LCD1602_CheckAddress(void);
+void LCD1602_Send(void);
+static void LCD1602_SendWait(uint32_t us);
+static void LCD1602_WaitReady(void);
+static void LCD1602_Track(uint8_t data, uint8_t rs);
+static void LCD1602_BeginBatch(void);
+static void LCD1602_EndBatch(void);
+static void LCD1602_Blank(void);
 
 char Lvl_1[] = {0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x1f};          // lvl 1 bar
 char Lvl_2[] = {0x0,0x0,0x0,0x0,0x0,0x0,0x1f,0x1f};         // lvl 2 bar
@@ -56,8 +113,6 @@ char Lvl_6[] = {0x0,0x0,0x1f,0x1f,0x1f,0x1f,0x1f,0x1f};     // lvl 6 bar
 char Lvl_7[] = {0x0,0x1f,0x1f,0x1f,0x1f,0x1f,0x1f,0x1f};    // lvl 7 bar
 char Lvl_8[] = {0x1f,0x1f,0x1f,0x1f,0x1f,0x1f,0x1f,0x1f};   // lvl 8 bar
 
-void DELAY(uint32_t x);   
-
 /****************************************************************************** 
  * Function definitions
  ******************************************************************************/
@@ -69,10 +124,20 @@ void LCD1602_Init(void) {
     I2C_Init();                    /* via I2C communication */
     LCD1602_CheckAddress();        /* if any PCF connected check which one */
                                                                                         
-    DELAY(168);                    /* >15ms */
+    /* >15ms, cycle counter has to be running (TIMER_Init) */
+    lcd_stamp = TIMER_Now();
+    lcd_busy = TIMER_US(LCD_POWERON_US);
     
-    LCD1602_Write8(0x33,0);        /* 4-bit interface */                                
-    LCD1602_Write8(0x32,0);        /* HD44780U datasheet Figure 24 */
+    /* 4-bit interface, HD44780U datasheet Figure 24, nibbles of the reset 
+       sequence are sent one by one because of the delays between them */
+    LCD1602_Write4(0x03,0);
+    LCD1602_SendWait(LCD_RESET1_US);
+    LCD1602_Write4(0x03,0);
+    LCD1602_SendWait(LCD_RESET2_US);
+    LCD1602_Write4(0x03,0);
+    LCD1602_SendWait(LCD_EXEC_US);
+    LCD1602_Write4(0x02,0);
+    LCD1602_SendWait(LCD_EXEC_US);
     LCD1602_Write8(0x28,0);
     LCD1602_Write8(0x08,0);
     LCD1602_Write8(0x01,0);
@@ -85,13 +150,13 @@ void LCD1602_Init(void) {
  * @param[in] Row number
  */
 void LCD1602_SetCursor(uint8_t col, uint8_t row) {
-    if( row>1 ) 
-        row = 1;    /* prevents from too many rows */
+    if( row>LCD1602_ROWS-1 ) 
+        row = LCD1602_ROWS-1;    /* prevents from too many rows */
     if( col>39 )    
         col = 39;    /* prevents from being over range */
     
     /* prevents from incorrect instruction */
-    LCD1602_Write8((LCD_SETDDRAMADDR |(col+(LCD_FULLLINE*row))),0);        
+    LCD1602_Write8((LCD_SETDDRAMADDR |(col+Row_Address[row])),0);        
 }
 
 /**-----------------------------------------------------------------------------
@@ -101,11 +166,17 @@ void LCD1602_SetCursor(uint8_t col, uint8_t row) {
 void LCD1602_Print(char *str) {
     uint8_t str_len = 0;
 
+    /* whole string in one transmission */
+    LCD1602_BeginBatch();
+    
     /* until end of string */
     while( str[str_len] != '\0' ) {              
         LCD1602_Write8(str[str_len], 1);
         ++str_len;
     }
+    
+    LCD1602_EndBatch();
+    I2C_Wait();
 }
 
 /**-----------------------------------------------------------------------------
@@ -116,11 +187,48 @@ void LCD1602_ClearAll(void) {
 }
 
 /**-----------------------------------------------------------------------------
- * @brief     Write byte to LCD including backlight info.
+ * @brief     Queue byte for the expander including backlight info.
  * @param[in] Data to send.
  */
 void PCF8574_Write(uint8_t data) {
-    I2C_Write(pcf_address, data | (lcd_backlight?PCF8574_BL:0x00));
+    lcd_burst[lcd_burst_len++] = data | (lcd_backlight?PCF8574_BL:0x00);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Send queued expander bytes in one I2C transaction, in the background.
+ *        Waits only if the LCD is still executing a long instruction.
+ */
+void LCD1602_Send(void) {
+    if( lcd_burst_len == 0 )
+        return;
+    
+    LCD1602_WaitReady();
+    I2C_WriteBlockAsync(pcf_address, lcd_burst_len, lcd_burst, 0);
+    lcd_burst_len = 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Send queued expander bytes and wait until they are transmitted,
+ *            the next transmission waits for the execution time.
+ * @param[in] Execution time of the last instruction, us
+ */
+static void LCD1602_SendWait(uint32_t us) {
+    LCD1602_Send();
+    I2C_Wait();
+    lcd_stamp = TIMER_Now();
+    lcd_busy = TIMER_US(us);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Wait until the last long instruction is executed.
+ */
+static void LCD1602_WaitReady(void) {
+    if( lcd_busy == 0 )
+        return;
+    
+    while( TIMER_Elapsed(lcd_stamp) < lcd_busy )
+        ;
+    lcd_busy = 0;
 }
 
 /**-----------------------------------------------------------------------------
@@ -131,23 +239,56 @@ void PCF8574_Write(uint8_t data) {
 void LCD1602_Write4(uint8_t data, uint8_t rs) {
     PCF8574_Write(((data << 4)&0xF0) | (rs?PCF8574_RS:0x00) | PCF8574_EN);
     PCF8574_Write(((data << 4)&0xF0) | (rs?PCF8574_RS:0x00));
-    DELAY(1);
 }
 
 /**-----------------------------------------------------------------------------
- * @brief     Write byte to LCD.
+ * @brief Start collecting bytes for one transmission. Batches can be nested,
+ *        keypad interrupt (which prints mode names) is masked until the 
+ *        outermost one ends, so it cannot put its bytes in the middle.
+ */
+static void LCD1602_BeginBatch(void) {
+    if( lcd_batch++ == 0 ) {
+        lcd_keypad = (uint8_t)NVIC_GetEnableIRQ(PORTA_IRQn);
+        NVIC_DisableIRQ(PORTA_IRQn);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief End of a batch, the outermost one sends collected bytes and enables
+ *        keypad interrupt again if it was enabled at its beginning.
+ */
+static void LCD1602_EndBatch(void) {
+    if( --lcd_batch != 0 )
+        return;
+    
+    LCD1602_Send();
+    if( lcd_keypad )
+        NVIC_EnableIRQ(PORTA_IRQn);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Write byte to LCD. Bytes are sent at once, or collected and sent
+ *            together inside a batch (clear and return home, which take 
+ *            1.52 ms, are always sent at once and the next byte waits until
+ *            they are executed).
  * @param[in] Data to send.
  * @param[in] Register select
  */
 void LCD1602_Write8(uint8_t data, uint8_t rs) {
-    /* Prevent keypad interrupt from corrupting transmission */
-    NVIC_DisableIRQ(PORTA_IRQn);
+    /* a single byte is a batch too, keypad interrupt is masked */
+    LCD1602_BeginBatch();
+    
+    if( lcd_burst_len > LCD_BURST_SIZE-4 )
+        LCD1602_Send();
     
     LCD1602_Write4(((data >> 4)&0x0F), rs);
     LCD1602_Write4(( data      &0x0F), rs);
+    LCD1602_Track(data, rs);
     
-    /* Enable keypad interrupt */
-    NVIC_EnableIRQ(PORTA_IRQn);
+    if( rs == 0 && data <= (LCD_RETURNHOME|0x01) )
+        LCD1602_SendWait(LCD_CLEAR_US);
+    
+    LCD1602_EndBatch();
 }
 
 /**-----------------------------------------------------------------------------
@@ -191,308 +332,139 @@ uint8_t LCD1602_BF_AC(uint8_t *ptr) {
 }
 
 /**-----------------------------------------------------------------------------
- * @brief Load custom characters to LCD
+ * @brief Load custom characters to LCD. Whole CGRAM image is streamed in a few
+ *        transmissions, busy flag is not checked (every byte on the bus takes
+ *        longer than execution of the previous write).
  */
 void LCD1602_LVL_CH(void) {
-    uint8_t i,temp;
+    char *bars[8] = {Lvl_1, Lvl_2, Lvl_3, Lvl_4, Lvl_5, Lvl_6, Lvl_7, Lvl_8};
+    
+    LCD1602_BeginBatch();
     
     /* Set CGRAM address = 0 */
-    LCD1602_Write8(0x40,0);        
+    LCD1602_Write8(LCD_SETCGRAMADDR,0);
     
-    for( i=0; i<8; i++ ) {
-        while( LCD1602_BF_AC(&temp) );
-        LCD1602_Write8(Lvl_1[i],1);
-    }
-    for( i=0; i<8; i++ ) {
-        while( LCD1602_BF_AC(&temp) );
-        LCD1602_Write8(Lvl_2[i],1);
-    }
-    for( i=0; i<8; i++ ) {
-        while( LCD1602_BF_AC(&temp) );
-        LCD1602_Write8(Lvl_3[i],1);
-    }
-    for( i=0; i<8; i++ ) {
-        while( LCD1602_BF_AC(&temp) );
-        LCD1602_Write8(Lvl_4[i],1);
-    }
-    for( i=0; i<8; i++ ) {
-        while( LCD1602_BF_AC(&temp) );
-        LCD1602_Write8(Lvl_5[i],1);
-    }
-    for( i=0; i<8; i++ ) {
-        while( LCD1602_BF_AC(&temp) );
-        LCD1602_Write8(Lvl_6[i],1);
-    }
-    for( i=0; i<8; i++ ) {
-        while( LCD1602_BF_AC(&temp) );
-        LCD1602_Write8(Lvl_7[i],1);
-    }
-    for( i=0; i<8; i++ ) {
-        while( LCD1602_BF_AC(&temp) );
-        LCD1602_Write8(Lvl_8[i],1);
+    for( uint8_t i=0; i<8; i++ ) {
+        for( uint8_t j=0; j<8; j++ )
+            LCD1602_Write8(bars[i][j],1);
     }
     
     /* Set DDRAM address = 0 */
-    LCD1602_Write8(0x80,0);        
+    LCD1602_Write8(LCD_SETDDRAMADDR,0);
+    
+    LCD1602_EndBatch();
 }
 
 /**-----------------------------------------------------------------------------
- * @brief     Write normalized 8 level amplitude bar to LCD
- * @param[in] Normalized amplitude level: 1-8
+ * @brief     Write a character to the frame in memory, the display is not
+ *            changed until LCD1602_Flush.
+ * @param[in] Column number
+ * @param[in] Row number
+ * @param[in] Character (0-7 for custom characters)
  */
-void LCD1602_PrintLVL(char *str) {
-    uint8_t str_len = 0;
-    char buf;
+void LCD1602_PutChar(uint8_t col, uint8_t row, char ch) {
+    if( row < LCD1602_ROWS && col < LCD1602_COLS )
+        lcd_frame[row][col] = ch;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Load custom character, in one transmission. Address counter 
+ *            points to CGRAM afterwards, next flush sets the cursor.
+ * @param[in] Character number: 0-7
+ * @param[in] Eight rows of pixels, top row first (5 lower bits)
+ */
+void LCD1602_LoadChar(uint8_t slot, const uint8_t *rows) {
+    LCD1602_BeginBatch();
     
-    /* until end of string */
-    while( str[str_len] != '\0' ) {
-        buf = str[str_len];
-        if( buf=='/' ) {
-            if( (str[str_len+1] != '\0') && (str[str_len+1]=='/') ) {
-                if( str[str_len+2] != '\0' ) {
-                    str_len+=2;
-                    switch( str[str_len] ) {
-                        case '1': buf=0x0;
-                                  break;
-                        case '2': buf=0x01;
-                                  break;
-                        case '3': buf=0x02;
-                                  break;
-                        case '4': buf=0x03;
-                                  break;
-                        case '5': buf=0x04;
-                                  break;
-                        case '6': buf=0x05;
-                                  break;
-                        case '7': buf=0x06;
-                                  break;
-                        case '8': buf=0x07;
-                                  break;
-                        default:  str_len-=2;
-                                  break;
-                    }
-                }
-            }
-        }
-    LCD1602_Write8(buf, 1);
-    ++str_len;
-  }
+    LCD1602_Write8(LCD_SETCGRAMADDR | ((slot & 0x07) << 3), 0);
+    for( uint8_t i=0; i<8; i++ )
+        LCD1602_Write8(rows[i] & 0x1F, 1);
+    
+    LCD1602_EndBatch();
 }
 
 /**-----------------------------------------------------------------------------
- * @deprecated
- * @brief      Write normalized 16-levels amplitude bar to LCD
- * @param[in]  Normalized amplitude level: 0-16
- * @param[in]  Column select
+ * @brief  Send changed characters of the frame in memory to the display. 
+ *         Adjacent changed characters are sent after one set cursor command
+ *         (address counter is incremented by the LCD), set cursor is skipped
+ *         if the address counter already points to the character. Function 
+ *         returns while characters are transmitted in the background.
+ * @return Number of bytes written to the LCD (commands and characters)
  */
-void LCD1602_PrintLVL_16(uint8_t lvl, uint8_t col){
-    switch( lvl ){
-        case 0: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_Print(" ");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL(" ");
-            break;
-        case 1: 
-            LCD1602_SetCursor(col,0);   // select top row
-            LCD1602_Print(" ");         // clear top row
-            LCD1602_SetCursor(col,1);   // select bottom row
-            LCD1602_PrintLVL("//1");    // write one strip
-            break;
-        case 2: 
-            LCD1602_SetCursor(col,0);        
-            LCD1602_Print(" ");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//2");
-            break;
-        case 3: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_Print(" ");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//3");
-            break;
-        case 4: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_Print(" ");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//4");
-            break;
-        case 5: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_Print(" ");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//5");
-            break;
-        case 6: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_Print(" ");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//6");
-            break;
-        case 7: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_Print(" ");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//7");
-            break;
-        case 8: 
-            LCD1602_SetCursor(col,0);            
-            LCD1602_Print(" ");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        case 9: 
-            LCD1602_SetCursor(col,0);   // select top row
-            LCD1602_PrintLVL("//1");    // write first strip
-            LCD1602_SetCursor(col,1);   // select bottom row
-            LCD1602_PrintLVL("//8");    // write first 8 strips
-            break;
-        case 10: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//2");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        case 11: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//3");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        case 12: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//4");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        case 13: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//5");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        case 14: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//6");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        case 15: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//7");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        case 16: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//8");
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        default:
-            break;
+uint8_t LCD1602_Flush(void) {
+    uint8_t written = 0;
+    
+    /* all changes in as few transmissions as possible */
+    LCD1602_BeginBatch();
+    
+    for( uint8_t row=0; row<LCD1602_ROWS; row++ ) {
+        for( uint8_t col=0; col<LCD1602_COLS; col++ ) {
+            if( lcd_frame[row][col] == lcd_screen[row][col] )
+                continue;
+            
+            if( lcd_address != Row_Address[row]+col ) {
+                LCD1602_SetCursor(col, row);
+                written++;
+            }
+            /* updates lcd_screen and lcd_address */
+            LCD1602_Write8((uint8_t)lcd_frame[row][col], 1);
+            written++;
+        }
     }
+    
+    LCD1602_EndBatch();
+    
+    return written;
 }
 
 /**-----------------------------------------------------------------------------
- * @brief     Write normalized 16-levels amplitude bar to LCD. Function dedicated
- *            for a spectrum analyzer, does not do any unnecessary prints and 
- *            works faster
- * @param[in] Normalized amplitude level: 0-16
- * @param[in] Previous normalized amplitude level: 0-16
- * @param[in] Column number
+ * @brief     Follow DDRAM address counter and content of the display after
+ *            each byte written to the LCD.
+ * @param[in] Data sent.
+ * @param[in] Register select
  */
-void LCD1602_PrintLVL_16_FFT(uint8_t lvl, uint8_t oldLvl, uint8_t col){
-    switch( lvl ){
-        case 0:
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL(" ");
-            break;
-        case 1:
-            LCD1602_SetCursor(col,1);   // select bottom row
-            LCD1602_PrintLVL("//1");    // write one strip
-            break;
-        case 2:
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//2");
-            break;
-        case 3:
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//3");
-            break;
-        case 4:
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//4");
-            break;
-        case 5:
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//5");
-            break;
-        case 6:
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//6");
-            break;
-        case 7:
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//7");
-            break;
-        case 8:
-            LCD1602_SetCursor(col,1);
-            LCD1602_PrintLVL("//8");
-            break;
-        case 9: 
-            LCD1602_SetCursor(col,0);   // select top row
-            LCD1602_PrintLVL("//1");    // write first strip
-            break;
-        case 10: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//2");
-            break;
-        case 11: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//3");
-            break;
-        case 12: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//4");
-            break;
-        case 13: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//5");
-            break;
-        case 14: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//6");
-            break;
-        case 15: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//7");
-            break;
-        case 16: 
-            LCD1602_SetCursor(col,0);
-            LCD1602_PrintLVL("//8");
-            break;
-        default:
-            break;
+static void LCD1602_Track(uint8_t data, uint8_t rs) {
+    if( rs == 0 ) {
+        if( data & LCD_SETDDRAMADDR )
+            lcd_address = data & 0x7F;
+        else if( data & LCD_SETCGRAMADDR )
+            lcd_address = LCD_NOADDR;    /* characters go to CGRAM now */
+        else if( data & LCD_CURSORSHIFT )
+            lcd_address = LCD_NOADDR;
+        else if( data == LCD_CLEARDISPLAY ) {
+            LCD1602_Blank();
+            lcd_address = 0x00;
+        }
+        else if( (data & ~0x01) == LCD_RETURNHOME )
+            lcd_address = 0x00;
+        return;
     }
     
-    /* if current level is lower than 9 (upper row needs to be empty) but
-       previos value was greater than 8 (upper row was not empty), clear 
-       upper row; similarly for current lever higher than 8 */
-    if( lvl < 9 && oldLvl > 8 ) {
-        LCD1602_SetCursor(col,0);
-        LCD1602_Print(" ");
-    }
-    else if( lvl >= 9 && oldLvl < 8 ) {
-        LCD1602_SetCursor(col,1);
-        LCD1602_PrintLVL("//8");
+    if( lcd_address == LCD_NOADDR )
+        return;
+    
+    for( uint8_t row=0; row<LCD1602_ROWS; row++ ) {
+        if( lcd_address >= Row_Address[row] && lcd_address < Row_Address[row]+LCD1602_COLS )
+            lcd_screen[row][lcd_address-Row_Address[row]] = (char)data;
     }
+    
+    /* address counter is incremented, lines are continued */
+    if( lcd_address == LCD_LINE1_END )
+        lcd_address = LCD_FULLLINE;
+    else if( lcd_address == LCD_LINE2_END )
+        lcd_address = 0x00;
+    else
+        lcd_address++;
 }
 
 /**-----------------------------------------------------------------------------
- * @brief Simple delay function used only in I2C
+ * @brief Display has been cleared, frame in memory is cleared too.
  */
-void DELAY(uint32_t x) {
-    for( volatile uint32_t i=0; i<(x*8000); i++ )
-        ;
+static void LCD1602_Blank(void) {
+    for( uint8_t row=0; row<LCD1602_ROWS; row++ ) {
+        for( uint8_t col=0; col<LCD1602_COLS; col++ ) {
+            lcd_frame[row][col] = ' ';
+            lcd_screen[row][col] = ' ';
+        }
+    }
 }
@@ -0,0 +1,343 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   level.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for magnitude to bar level mapping.
+ * @ver    0.1
+ */
+
+#include <string.h>
+#include "level.h"
+#include "fft.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* fractional bits of the level scale factor */
+#define LEVEL_SCALE_SHIFT        (20)
+
+/* dB (Q8) to log2 (Q8) conversion */
+#define LEVEL_DB_TO_LOG2(x)      ((int32_t)(x)*256/LEVEL_DB_PER_OCTAVE)
+/* number of levels per one log2 (Q8) step, LEVEL_SCALE_SHIFT fractional bits */
+#define LEVEL_SCALE(range)       ((int32_t)(((int64_t)LEVEL_MAX*LEVEL_DB_PER_OCTAVE \
+                                  <<LEVEL_SCALE_SHIFT)/((int64_t)(range)*256)))
+
+/* fractional bits added to log2 (Q8) values tracked by the automatic gain */
+#define LEVEL_AGC_FRAC           (8)
+/* dB (Q8) to log2 of power with LEVEL_AGC_FRAC more fractional bits */
+#define LEVEL_AGC_DB(x)          ((int32_t)((int64_t)(x)*2*256*(1<<LEVEL_AGC_FRAC) \
+                                  /LEVEL_DB_PER_OCTAVE))
+/* rate in dB per second to a step per frame */
+#define LEVEL_AGC_STEP(db, fps)  (LEVEL_AGC_DB(LEVEL_DB(db))/(fps))
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* log2(1+i/32) in Q8 format */
+static const uint16_t Log2_Table[33] = {0, 11, 22, 33, 44, 54, 63, 73, 82, 92,
+    100, 109, 118, 126, 134, 142, 150, 157, 165, 172, 179, 186, 193, 200, 207,
+    213, 220, 226, 232, 238, 244, 250, 256};
+
+static int32_t level_floor = LEVEL_DB_TO_LOG2(LEVEL_DB_FLOOR);
+static int32_t level_scale = LEVEL_SCALE(LEVEL_DB_RANGE);
+
+#if LEVEL_AGC
+/* running peak of all columns and noise floors of columns, log2(power) with
+   Q8+LEVEL_AGC_FRAC fractional bits */
+static int32_t agc_peak;
+static int32_t agc_noise[LEVEL_COLUMNS];
+/* 0 - state is initialized by the next frame */
+static volatile uint8_t agc_valid = 0;
+/* peak release and noise floor rise per frame */
+static int32_t agc_release = LEVEL_AGC_STEP(LEVEL_AGC_RELEASE_DB, FFT_FRAME_RATE);
+static int32_t agc_rise = LEVEL_AGC_STEP(LEVEL_NOISE_RISE_DB, FFT_FRAME_RATE);
+#endif
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static uint8_t level_clz(uint32_t x);
+static int32_t level_mantissa(uint32_t m);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Set dB range mapped on the bar levels.
+ * @param[in] Magnitude for empty bar, dB in Q8 format (use LEVEL_DB macro)
+ * @param[in] Range of all LEVEL_MAX levels, dB in Q8 format
+ */
+void LEVEL_SetRange(int32_t floorDb, int32_t rangeDb) {
+    if( rangeDb <= 0 )
+        return;    /* prevents from division by zero */
+
+    level_floor = LEVEL_DB_TO_LOG2(floorDb);
+    level_scale = LEVEL_SCALE(rangeDb);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Binary logarithm calculated with leading zero count and lookup
+ *            table, no libm calls.
+ * @param[in] Argument, 0 is treated as 1
+ * @return    log2(x) in Q8 format
+ */
+int32_t LEVEL_Log2(uint32_t x) {
+    uint8_t exponent;
+
+    if( x <= 1 )
+        return 0;
+
+    exponent = 31 - level_clz(x);
+
+    /* normalize, leading one is dropped */
+    x <<= (32 - exponent);
+
+    return ((int32_t)exponent << 8) + level_mantissa(x >> 19);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Binary logarithm of a 64-bit value (sums of powers).
+ * @param[in] Argument, 0 is treated as 1
+ * @return    log2(x) in Q8 format
+ */
+int32_t LEVEL_Log2Long(uint64_t x) {
+    uint8_t shift;
+
+    if( (x >> 32) == 0 )
+        return LEVEL_Log2((uint32_t)x);
+
+    /* drop as many low bits as needed to fit in 32 bits */
+    shift = 32 - level_clz((uint32_t)(x >> 32));
+
+    return LEVEL_Log2((uint32_t)(x >> shift)) + ((int32_t)shift << 8);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Binary logarithm of a floating point value taken from its exponent
+ *            and mantissa bits, no libm calls.
+ * @param[in] Argument, values below 1 are treated as 1
+ * @return    log2(x) in Q8 format
+ */
+int32_t LEVEL_Log2Float(float x) {
+    uint32_t bits;
+    int32_t exponent;
+
+    memcpy(&bits, &x, sizeof(bits));
+    exponent = (int32_t)((bits >> 23) & 0xFF) - 127;
+
+    /* negative values, values below 1 and NaN */
+    if( (bits & 0x80000000) || exponent < 0 || exponent > 127 )
+        return 0;
+
+    /* IEEE 754 single precision: 23 bits of mantissa, leading one hidden */
+    return (exponent << 8) + level_mantissa((bits >> 10) & 0x1FFF);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Binary logarithm of the power of a complex value with 32-bit
+ *            components; both are scaled down to avoid overflow.
+ * @param[in] Real part
+ * @param[in] Imaginary part
+ * @return    log2(re^2+im^2) in Q8 format
+ */
+int32_t LEVEL_Log2Power(int32_t re, int32_t im) {
+    uint32_t absRe = re < 0 ? -(uint32_t)re : (uint32_t)re;
+    uint32_t absIm = im < 0 ? -(uint32_t)im : (uint32_t)im;
+    uint8_t shift = 0;
+
+    /* squares of 15-bit values and their sum fit in uint32_t */
+    while( (absRe | absIm) >= 0x8000 ) {
+        absRe >>= 1;
+        absIm >>= 1;
+        shift++;
+    }
+
+    /* each bit of shift is worth two bits of power */
+    return LEVEL_Log2(absRe*absRe + absIm*absIm) + ((int32_t)shift << 9);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Map binary logarithm of a magnitude to the bar level.
+ * @param[in] log2(magnitude) in Q8 format
+ * @return    Bar level: 0-LEVEL_MAX
+ */
+uint8_t LEVEL_FromLog2(int32_t log2Mag) {
+    int32_t lvl;
+
+    if( log2Mag <= level_floor )
+        return 0;
+
+    lvl = ((log2Mag - level_floor) * level_scale) >> LEVEL_SCALE_SHIFT;
+
+    return lvl > LEVEL_MAX ? LEVEL_MAX : (uint8_t)lvl;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Map binary logarithm of a power (squared magnitude) to the bar 
+ *            level, square root is folded into the mapping.
+ * @param[in] log2(re^2+im^2) in Q8 format
+ * @return    Bar level: 0-LEVEL_MAX
+ */
+uint8_t LEVEL_FromLog2Power(int32_t log2Pow) {
+    int32_t lvl;
+
+    /* log2(power) = 2*log2(magnitude): double floor, halve scale */
+    if( log2Pow <= 2*level_floor )
+        return 0;
+
+    lvl = ((log2Pow - 2*level_floor) * level_scale) >> (LEVEL_SCALE_SHIFT+1);
+
+    return lvl > LEVEL_MAX ? LEVEL_MAX : (uint8_t)lvl;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Map binary logarithms of column powers of one frame to the bar 
+ *             levels. With LEVEL_AGC the running peak and noise floors are 
+ *             updated first, otherwise LEVEL_FromLog2Power is used.
+ * @param[in]  log2(power) of the columns in Q8 format
+ * @param[out] Bar levels: 0-LEVEL_MAX
+ * @param[in]  Number of columns, up to LEVEL_COLUMNS
+ */
+void LEVEL_MapColumns(const int32_t *log2Pow, uint8_t *levels, uint8_t count) {
+#if LEVEL_AGC
+    int32_t x, top, bottom, range, lvl;
+    int32_t noiseMin = 0;
+    int32_t frameMax = log2Pow[0];
+    
+    if( count > LEVEL_COLUMNS )
+        count = LEVEL_COLUMNS;
+    
+    for( uint8_t i=1; i<count; i++ ) {
+        if( log2Pow[i] > frameMax )
+            frameMax = log2Pow[i];
+    }
+    
+    /* first frame sets the state */
+    if( !agc_valid ) {
+        agc_peak = frameMax << LEVEL_AGC_FRAC;
+        for( uint8_t i=0; i<count; i++ )
+            agc_noise[i] = log2Pow[i] << LEVEL_AGC_FRAC;
+        agc_valid = 1;
+    }
+    
+    /* peak: fast attack, linear release (in dB) */
+    x = frameMax << LEVEL_AGC_FRAC;
+    if( x > agc_peak ) {
+        agc_peak += (x - agc_peak) >> LEVEL_AGC_ATTACK_SHIFT;
+    }
+    else {
+        agc_peak -= agc_release;
+        if( agc_peak < x )
+            agc_peak = x;
+    }
+    top = agc_peak >> LEVEL_AGC_FRAC;
+    
+    /* noise floor: fast fall, slow rise */
+    for( uint8_t i=0; i<count; i++ ) {
+        x = log2Pow[i] << LEVEL_AGC_FRAC;
+        if( x < agc_noise[i] ) {
+            agc_noise[i] -= (agc_noise[i] - x) >> LEVEL_NOISE_FALL_SHIFT;
+        }
+        else {
+            agc_noise[i] += agc_rise;
+            if( agc_noise[i] > x )
+                agc_noise[i] = x;
+        }
+        if( i == 0 || agc_noise[i] < noiseMin )
+            noiseMin = agc_noise[i];
+    }
+    
+    for( uint8_t i=0; i<count; i++ ) {
+        if( agc_noise[i] > noiseMin + LEVEL_AGC_DB(LEVEL_NOISE_SPREAD) )
+            agc_noise[i] = noiseMin + LEVEL_AGC_DB(LEVEL_NOISE_SPREAD);
+        
+        /* bars span from the margin above noise floor to the peak */
+        bottom = (agc_noise[i] >> LEVEL_AGC_FRAC) + 2*LEVEL_DB_TO_LOG2(LEVEL_AGC_MARGIN);
+        range = top - bottom;
+        if( range < 2*LEVEL_DB_TO_LOG2(LEVEL_AGC_MIN_RANGE) )
+            range = 2*LEVEL_DB_TO_LOG2(LEVEL_AGC_MIN_RANGE);
+        
+        if( log2Pow[i] <= bottom ) {
+            levels[i] = 0;
+            continue;
+        }
+        lvl = (log2Pow[i] - bottom)*LEVEL_MAX / range;
+        levels[i] = lvl > LEVEL_MAX ? LEVEL_MAX : (uint8_t)lvl;
+    }
+#else
+    for( uint8_t i=0; i<count; i++ )
+        levels[i] = LEVEL_FromLog2Power(log2Pow[i]);
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Convert rates of the automatic gain to steps per frame for the 
+ *            frame rate of the current mode.
+ * @param[in] Frames per second (FFT_MODE_FRAME_RATE)
+ */
+void LEVEL_SetFrameRate(uint16_t framesPerSecond) {
+#if LEVEL_AGC
+    if( framesPerSecond == 0 )
+        return;    /* prevents from division by zero */
+    
+    agc_release = LEVEL_AGC_STEP(LEVEL_AGC_RELEASE_DB, framesPerSecond);
+    agc_rise = LEVEL_AGC_STEP(LEVEL_NOISE_RISE_DB, framesPerSecond);
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Start the automatic gain from the next frame (e.g. after a change of
+ *        displayed frequencies).
+ */
+void LEVEL_AgcReset(void) {
+#if LEVEL_AGC
+    agc_valid = 0;
+#endif
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Map magnitude of a frequency bin to the bar level.
+ * @param[in] Magnitude (same scale as arm_cmplx_mag_f16 output)
+ * @return    Bar level: 0-LEVEL_MAX
+ */
+uint8_t LEVEL_FromMagnitude(uint32_t mag) {
+    return LEVEL_FromLog2(LEVEL_Log2(mag));
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Count leading zeros (Cortex-M0+ has no CLZ instruction).
+ * @param[in] Argument, must not be 0
+ * @return    Number of leading zeros
+ */
+static uint8_t level_clz(uint32_t x) {
+    uint8_t n = 0;
+
+    if( (x & 0xFFFF0000) == 0 ) { n += 16; x <<= 16; }
+    if( (x & 0xFF000000) == 0 ) { n += 8;  x <<= 8;  }
+    if( (x & 0xF0000000) == 0 ) { n += 4;  x <<= 4;  }
+    if( (x & 0xC0000000) == 0 ) { n += 2;  x <<= 2;  }
+    if( (x & 0x80000000) == 0 ) { n += 1; }
+
+    return n;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Binary logarithm of a normalized mantissa: 5 bits index the table,
+ *            next 8 bits are used to interpolate between the entries.
+ * @param[in] 13 most significant bits of the mantissa, leading one dropped
+ * @return    log2(1.m) in Q8 format
+ */
+static int32_t level_mantissa(uint32_t m) {
+    uint8_t idx   = (m >> 8) & 0x1F;
+    uint32_t frac = m & 0xFF;
+
+    return Log2_Table[idx] + (((Log2_Table[idx+1] - Log2_Table[idx])*frac) >> 8);
+}
@@ -10,45 +10,64 @@
  * @ver    0.1
  */
 
+#include <stdio.h>
 #include "MKL25Z4.h"                         /* Devider header file */
 #include "arm_math.h"                        /* Basic arm math header */
-#include "arm_const_structs.h"               /* Structs for FFT */
-#include "arm_math_types_f16.h"              /* Math types, for float16_t */
-#include "dsp/transform_functions_f16.h"     /* FFT functions for float16_t */
-#include "dsp/complex_math_functions_f16.h"  /* FFT functions for float16_t */
 
 #include "lcd1602.h"    /* 2x16 LCD display header file */
 #include "pit.h"        /* PIT header file*/
 #include "ADC.h"        /* ADC header file*/
 #include "buttons.h"    /* button matrix header file*/
 #include "fft.h"        /* complementary FFT header file*/
+#include "timer.h"      /* cycle counter header file*/
+#include "queue.h"      /* sample buffer queue header file*/
+#include "diag.h"       /* diagnostic counters header file*/
+#include "prof.h"       /* stage profiler header file*/
+#include "display.h"    /* queue of frames for the LCD header file*/
+#include "glyph.h"      /* LCD custom characters header file*/
+#include "level.h"      /* column level mapping header file*/
+#include "dft.h"        /* per-sample DFT of modes 4-8 header file*/
 
 #define GREAT_PROJECT   (1)                     
 
+/* 1 - initialization message is shown for a while, 0 - fast boot */
+#ifndef BOOT_SPLASH
+#define BOOT_SPLASH         (1)
+#endif
+
+static void MODE_Restart(void);
+
+#if ADC_MEASURE_CYCLES
+/* buffers processed in every mode by the ISR budget check */
+#define ISR_CHECK_BUFFERS   (16)
+
+static void ISR_BudgetCheck(void);
+#endif
+
 int main() {
     uint8_t cal_error;
+    int8_t slot;
+    
+    /* Initialize cycle counter, used also for LCD timing */
+    TIMER_Init();
     
     /* Initialize LCD */
     LCD1602_Init();
     LCD1602_LVL_CH();
+    GLYPH_Reset();
     LCD1602_SetCursor(0,0);
     LCD1602_Print("Initialization.");
     LCD1602_SetCursor(0,1);
     LCD1602_Print("Please wait...");
+#if BOOT_SPLASH
     FFT_DELAY(1000); // looks cool
+#endif
     
     /* Initialize FFT status */
     arm_status FFT_InitStatus = ARM_MATH_SUCCESS;
     
-    /* Initialize instance for FFT */
-    arm_rfft_fast_instance_f16 fft;
-    
-    /* Initialize rest of FFT */
-    FFT_InitStatus = arm_rfft_fast_init_f16(&fft, FFT_SIZE);
-    FFTstatus.readToBuffer0 = 1;
-    FFTstatus.readToBuffer1 = 0; 
-    FFTstatus.isBuffer0Ready = 0;
-    FFTstatus.isBuffer1Ready = 0; 
+    /* Initialize instance for FFT (Q15 or float16_t, see FFT_FIXED_POINT) */
+    FFT_InitStatus = FFT_Init();
     FFTstatus.mode = 1;
     
     if( FFT_InitStatus != ARM_MATH_SUCCESS ) {
@@ -73,51 +92,118 @@ int main() {
     /* Initialize buttons */
     buttons_Initialize();
     
-    /* Trigger ADC0 on channel 8 */
-    ADC0->SC1[0] = ADC_SC1_AIEN_MASK | ADC_SC1_ADCH(8);    
+    /* Trigger ADC0 on channel 8 (ADC0 interrupt or DMA, see ADC_USE_DMA) */
+    ADC_Start();
+    
+#if ADC_MEASURE_CYCLES
+    ISR_BudgetCheck();
+#endif
         
     LCD1602_ClearAll();
     
-    /* infinite loop */
+    /* infinite loop, woken up by sampling and by I2C transmission */
     while( GREAT_PROJECT ) {
         __WFI();
-        if( FFTstatus.isBuffer0Ready ) {
-            /* apply window function od samples */
-            for( uint16_t i=0; i<FFT_SIZE; i++ )
-                FFT_Buffer[0][i] *= Hann_Window[i];
+        while( (slot = QUEUE_ReadSlot()) != QUEUE_NONE ) {
+            uint8_t valid;
             
-            /* calculate FFT */
-            arm_rfft_fast_f16(&fft, FFT_Buffer[0], FFT_Output, 0);
-            /* calculate magnitude of complex output */
-            arm_cmplx_mag_f16(FFT_Output, FFT_Buffer[0], FFT_SIZE);
+            /* keypad interrupt only sets the flag, frames of the old mode
+               are dropped here */
+            if( buttons_ModeChanged() ) {
+                MODE_Restart();
+                continue;
+            }
             
-            /* colect proper samples to the LCD */
-            FFT_CalculateColumns_256(BUFFER_0);
-            FFTstatus.isBuffer0Ready = 0;
+            /* overlapping frames are not built across lost samples */
+            if( !QUEUE_IsContinuous() )
+                FFT_ResetHistory();
             
-            /* print frequency bins on lcd display */
-            NVIC_DisableIRQ(PORTA_IRQn);
-            FFT_PrintColumns();
-            NVIC_EnableIRQ(PORTA_IRQn);
-        }
-        if( FFTstatus.isBuffer1Ready ) {
-            /* apply window function od samples */
-            for( uint16_t i=0; i<FFT_SIZE; i++ )
-                FFT_Buffer[1][i] *= Hann_Window[i];
-            
-            /* calculate FFT */
-            arm_rfft_fast_f16(&fft, FFT_Buffer[1], FFT_Output, 0);
-            /* calculate magnitude of complex output */
-            arm_cmplx_mag_f16(FFT_Output, FFT_Buffer[1], FFT_SIZE);
-            
-            /* colect proper samples to the LCD */
-            FFT_CalculateColumns_256(BUFFER_1);
-            FFTstatus.isBuffer1Ready = 0;
+            /* window, FFT, magnitude and columns */
+            valid = FFT_ProcessBuffer((uint8_t)slot);
+            QUEUE_Release();
+            DIAG_FrameProcessed();
             
-            /* print frequency bins on lcd display */
-            NVIC_DisableIRQ(PORTA_IRQn);
-            FFT_PrintColumns();
-            NVIC_EnableIRQ(PORTA_IRQn);
+            /* frame waits until the LCD is free, previous frame is still 
+               being sent while the next one is calculated */
+            if( valid )
+                DISPLAY_Submit(FrequencyBins);
+            DISPLAY_Service();
+        }
+        DISPLAY_Service();
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Start the new mode (or window): drop the queued frames (taken one 
+ *        included), forget the sample history and DFT frames and reset 
+ *        columns, levels and the display.
+ *        ADC starts the current buffer again on a mode change, so the next
+ *        frame has only samples of the new mode.
+ */
+static void MODE_Restart(void) {
+    while( QUEUE_ReadSlot() != QUEUE_NONE )
+        QUEUE_Release();
+    FFT_ResetHistory();
+#if FFT_DFT_BINS
+    /* frames in progress may have samples windowed by another window */
+    DFT_Reset();
+#endif
+    
+    /* reset all frequency bins */
+    for( uint8_t i=0; i<16; i++ )
+        FrequencyBins[i] = 0;
+    DISPLAY_Reset();
+    /* new frequencies, new noise floors */
+    LEVEL_AgcReset();
+    /* zoomed modes calculate less frames per second */
+    LEVEL_SetFrameRate(FFT_MODE_FRAME_RATE(FFTstatus.mode));
+    DISPLAY_SetFrameRate(FFT_MODE_FRAME_RATE(FFTstatus.mode));
+}
+
+#if ADC_MEASURE_CYCLES
+/**-----------------------------------------------------------------------------
+ * @brief Run every mode for a while with FFT calculated in the background and
+ *        print the longest ADC0 interrupt and the number of interrupts which
+ *        did not fit in the sample period (ADC_CYCLE_BUDGET). With ADC_USE_DMA
+ *        the DMA0 interrupt is measured against the period of a whole block.
+ */
+static void ISR_BudgetCheck(void) {
+    DiagCounters counters;
+    char line[17];
+    int8_t slot;
+    
+    DIAG_Reset();
+    for( uint8_t mode=1; mode<=FFT_MODES; mode++ ) {
+        FFTstatus.mode = mode;
+        for( uint8_t n=0; n<ISR_CHECK_BUFFERS; ) {
+            __WFI();
+            while( (slot = QUEUE_ReadSlot()) != QUEUE_NONE ) {
+                FFT_ProcessBuffer((uint8_t)slot);
+                QUEUE_Release();
+                n++;
+            }
         }
     }
+    FFTstatus.mode = 1;
+    DIAG_Get(&counters);
+    
+    LCD1602_ClearAll();
+    LCD1602_SetCursor(0,0);
+#if ADC_USE_DMA
+    /* DMA0 interrupt processes a whole block, budget is per block */
+    snprintf(line, sizeof(line), "%6lu/%6lu cy", (unsigned long)(counters.isrCyclesMax % 1000000), 
+                                                 (unsigned long)(ADC_CYCLE_BUDGET % 1000000));
+    LCD1602_Print(line);
+    LCD1602_SetCursor(0,1);
+    snprintf(line, sizeof(line), "per block >%5lu", (unsigned long)(counters.isrOverBudget % 100000));
+#else
+    snprintf(line, sizeof(line), "ISR %4lu/%4lu cy", (unsigned long)(counters.isrCyclesMax % 10000), 
+                                                     (unsigned long)(ADC_CYCLE_BUDGET % 10000));
+    LCD1602_Print(line);
+    LCD1602_SetCursor(0,1);
+    snprintf(line, sizeof(line), "over budget %4lu", (unsigned long)(counters.isrOverBudget % 10000));
+#endif
+    LCD1602_Print(line);
+    FFT_DELAY(3000);
 }
+#endif
@@ -0,0 +1,143 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   prof.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for the cycle profiler of the main
+ *         loop stages. Durations are kept in a ring buffer and as min, max
+ *         and mean per stage.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include "prof.h"
+#include "lcd1602.h"
+#include "fft.h"
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const char *Stage_Names[PROF_STAGES] = {"WIN", "FFT", "COL", "LCD"};
+
+/* statistics of stages */
+static uint32_t prof_min[PROF_STAGES];
+static uint32_t prof_max[PROF_STAGES];
+static uint64_t prof_sum[PROF_STAGES];
+static uint32_t prof_count[PROF_STAGES];
+
+/* last measurements, prof_total counts all of them */
+static ProfSample prof_ring[PROF_RING_SIZE];
+static uint32_t prof_total = 0;
+
+/* LCD row used by the printer */
+static uint8_t prof_row = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void prof_lcdLine(const char *line);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Store duration of a stage.
+ * @param[in] Stage
+ * @param[in] Duration in clock cycles
+ */
+void PROF_Record(ProfStage stage, uint32_t cycles) {
+    if( stage >= PROF_STAGES )
+        return;
+    
+    if( prof_count[stage] == 0 || cycles < prof_min[stage] )
+        prof_min[stage] = cycles;
+    if( cycles > prof_max[stage] )
+        prof_max[stage] = cycles;
+    prof_sum[stage] += cycles;
+    prof_count[stage]++;
+    
+    prof_ring[prof_total & (PROF_RING_SIZE-1)].stage  = stage;
+    prof_ring[prof_total & (PROF_RING_SIZE-1)].cycles = cycles;
+    prof_total++;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Clear statistics and the ring buffer.
+ */
+void PROF_Reset(void) {
+    for( uint8_t i=0; i<PROF_STAGES; i++ ) {
+        prof_min[i] = 0;
+        prof_max[i] = 0;
+        prof_sum[i] = 0;
+        prof_count[i] = 0;
+    }
+    prof_total = 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Last measurements, oldest first.
+ * @param[out] Buffer for up to PROF_RING_SIZE measurements
+ * @return     Number of measurements copied
+ */
+uint16_t PROF_GetRing(ProfSample *samples) {
+    uint16_t count = prof_total < PROF_RING_SIZE ? prof_total : PROF_RING_SIZE;
+    uint32_t first = prof_total - count;
+    
+    for( uint16_t i=0; i<count; i++ )
+        samples[i] = prof_ring[(first + i) & (PROF_RING_SIZE-1)];
+    
+    return count;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Report min, max and mean duration of every stage, two lines per
+ *            stage.
+ * @param[in] Function printing a line
+ */
+void PROF_Report(ProfPrinter print) {
+    char line[17];
+    
+    for( uint8_t i=0; i<PROF_STAGES; i++ ) {
+        uint32_t mean = prof_count[i] ? (uint32_t)(prof_sum[i] / prof_count[i]) : 0;
+        
+        snprintf(line, sizeof(line), "%.3s avg %8lu", Stage_Names[i], 
+                                                  (unsigned long)(mean % 100000000));
+        print(line);
+        snprintf(line, sizeof(line), "%7lu-%-8lu", (unsigned long)(prof_min[i] % 10000000), 
+                                                   (unsigned long)(prof_max[i] % 100000000));
+        print(line);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Show the report on the LCD, one stage per screen.
+ */
+void PROF_Print(void) {
+    prof_row = 0;
+    PROF_Report(prof_lcdLine);
+    LCD1602_ClearAll();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Print a line of the report on the LCD, a full screen is shown
+ *            for a while.
+ * @param[in] Line of text
+ */
+static void prof_lcdLine(const char *line) {
+    if( prof_row == 0 )
+        LCD1602_ClearAll();
+    
+    LCD1602_SetCursor(0, prof_row);
+    LCD1602_Print((char *)line);
+    
+    if( ++prof_row == 2 ) {
+        prof_row = 0;
+        FFT_DELAY(2000);
+    }
+}
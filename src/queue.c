@@ -0,0 +1,240 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   queue.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for the queue of sample buffers 
+ *         between the sampling interrupt (producer) and the main loop 
+ *         (consumer). Each side writes only its own variables, so no 
+ *         interrupt has to be disabled.
+ * @ver    0.2
+ */
+
+#include "queue.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frame numbers wrap around, a is newer than b */
+#define QUEUE_AFTER(a, b)        ((int32_t)((a) - (b)) > 0)
+
+#if QUEUE_SLOTS < 2 || QUEUE_SLOTS > 127
+#error "FFT_BUFFERS must be in range 2-127"
+#endif
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* written only by the producer (interrupt): number of the frame published in
+   a slot (0 - none), last published frame number, slot being filled */
+static volatile uint32_t slot_frame[QUEUE_SLOTS];
+static volatile uint32_t queue_frame = 0;
+static volatile int8_t queue_write = QUEUE_NONE;
+static volatile uint32_t queue_overruns = 0;
+static volatile uint32_t queue_dropped = 0;
+/* samples were dropped since the last published frame */
+static volatile uint8_t queue_gap = 0;
+
+/* written only by the consumer (main loop): taken slot and its frame number,
+   last released frame number */
+static volatile int8_t queue_read = QUEUE_NONE;
+static volatile uint32_t queue_readFrame = 0;
+static volatile uint32_t queue_last = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static int8_t queue_oldest(uint32_t *frame);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief  Producer: slot which can be filled with samples. The same slot is 
+ *         returned until it is published. With QUEUE_DROP_OLDEST the oldest
+ *         frame not taken by the consumer is overwritten when all slots are
+ *         occupied; otherwise every call with the queue full is counted as
+ *         an overrun (one call per dropped sample).
+ * @return Slot (buffer) number or QUEUE_NONE if all slots are occupied
+ */
+int8_t QUEUE_WriteSlot(void) {
+    int8_t taken = queue_read;
+    uint32_t last = queue_last;
+    int8_t slot = QUEUE_NONE;
+    
+    if( queue_write != QUEUE_NONE )
+        return queue_write;
+    
+    /* free slot: empty or already released by the consumer */
+    for( int8_t i=0; i<QUEUE_SLOTS; i++ ) {
+        if( i != taken && (slot_frame[i] == 0 || !QUEUE_AFTER(slot_frame[i], last)) ) {
+            slot = i;
+            break;
+        }
+    }
+    
+#if QUEUE_POLICY == QUEUE_DROP_OLDEST
+    /* overwrite the oldest frame waiting for the consumer */
+    if( slot == QUEUE_NONE ) {
+        for( int8_t i=0; i<QUEUE_SLOTS; i++ ) {
+            if( i != taken && (slot == QUEUE_NONE 
+                               || QUEUE_AFTER(slot_frame[slot], slot_frame[i])) )
+                slot = i;
+        }
+        queue_dropped++;
+    }
+#endif
+    
+    if( slot == QUEUE_NONE ) {
+        queue_overruns++;
+        queue_gap = 1;
+        return QUEUE_NONE;
+    }
+    
+    /* consumer does not take a slot without frame */
+    slot_frame[slot] = 0;
+    queue_write = slot;
+    return slot;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Producer: pass the filled slot to the consumer.
+ */
+void QUEUE_Publish(void) {
+    if( queue_write == QUEUE_NONE )
+        return;
+    
+    /* 0 means no frame; a number is skipped after dropped samples, so the
+       consumer sees the frame does not follow the previous one */
+    if( ++queue_frame == 0 )
+        queue_frame = 1;
+    if( queue_gap ) {
+        queue_gap = 0;
+        if( ++queue_frame == 0 )
+            queue_frame = 1;
+    }
+    
+    /* samples have to be in memory before the slot is visible */
+    __DMB();
+    slot_frame[queue_write] = queue_frame;
+    queue_write = QUEUE_NONE;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Consumer: take the oldest published slot, it is not overwritten 
+ *         until released. The same slot is returned until it is released.
+ * @return Slot (buffer) number or QUEUE_NONE if there is no new frame
+ */
+int8_t QUEUE_ReadSlot(void) {
+    int8_t slot;
+    uint32_t frame, check;
+    
+    if( queue_read != QUEUE_NONE )
+        return queue_read;
+    
+    do {
+        slot = queue_oldest(&frame);
+        if( slot == QUEUE_NONE )
+            return QUEUE_NONE;
+        
+        /* producer could take the slot before it was marked or publish an 
+           older frame in a slot already scanned, check again */
+        queue_read = slot;
+        __DMB();
+        if( queue_oldest(&check) != slot || check != frame )
+            queue_read = QUEUE_NONE;
+    } while( queue_read == QUEUE_NONE );
+    
+    queue_readFrame = frame;
+    return slot;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Consumer: return the taken slot to the producer.
+ */
+void QUEUE_Release(void) {
+    if( queue_read == QUEUE_NONE )
+        return;
+    
+    /* frame is released before the slot, so it is never taken again */
+    queue_last = queue_readFrame;
+    __DMB();
+    queue_read = QUEUE_NONE;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Consumer: check if the taken frame directly follows the last 
+ *         released one, i.e. no frame was overwritten (QUEUE_DROP_OLDEST) 
+ *         and no samples were dropped (QUEUE_DROP_NEWEST) in between.
+ * @return 1 if samples are continuous, 0 otherwise or if no slot is taken
+ */
+uint8_t QUEUE_IsContinuous(void) {
+    uint32_t next = queue_last + 1;
+    
+    if( next == 0 )
+        next = 1;
+    return queue_read != QUEUE_NONE && queue_readFrame == next;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Number of published frames waiting for the consumer.
+ * @return Number of frames: 0 to QUEUE_SLOTS
+ */
+uint8_t QUEUE_Count(void) {
+    uint8_t count = 0;
+    
+    for( int8_t i=0; i<QUEUE_SLOTS; i++ ) {
+        uint32_t f = slot_frame[i];
+        
+        if( f != 0 && QUEUE_AFTER(f, queue_last) )
+            count++;
+    }
+    return count;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Number of producer requests refused because all slots were 
+ *         occupied.
+ * @return Number of overruns (dropped samples)
+ */
+uint32_t QUEUE_GetOverruns(void) {
+    return queue_overruns;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Number of published frames overwritten before the consumer took 
+ *         them (QUEUE_DROP_OLDEST).
+ * @return Number of dropped frames
+ */
+uint32_t QUEUE_GetDroppedFrames(void) {
+    return queue_dropped;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Consumer: slot with the oldest frame not released yet.
+ * @param[out] Frame number of the slot
+ * @return     Slot number or QUEUE_NONE if there is no new frame
+ */
+static int8_t queue_oldest(uint32_t *frame) {
+    int8_t slot = QUEUE_NONE;
+    uint32_t oldest = 0;
+    
+    for( int8_t i=0; i<QUEUE_SLOTS; i++ ) {
+        uint32_t f = slot_frame[i];
+        
+        if( f != 0 && QUEUE_AFTER(f, queue_last) 
+            && (slot == QUEUE_NONE || QUEUE_AFTER(oldest, f)) ) {
+            slot = i;
+            oldest = f;
+        }
+    }
+    *frame = oldest;
+    return slot;
+}
@@ -0,0 +1,47 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   timer.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for SysTick based cycle counter.
+ * @ver    0.1
+ */
+
+#include "timer.h"
+
+/****************************************************************************** 
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief Start SysTick as a free running counter of core clock cycles, 
+ *        without interrupts.
+ */
+void TIMER_Init(void) {
+    SysTick->CTRL = 0;
+    SysTick->LOAD = TIMER_MASK;
+    SysTick->VAL  = 0;
+    /* core clock, no interrupt */
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Current value of the cycle counter.
+ * @return Counter value, counts up from 0 to TIMER_MASK
+ */
+uint32_t TIMER_Now(void) {
+    /* SysTick counts down */
+    return TIMER_MASK - SysTick->VAL;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Number of cycles since the given point in time.
+ * @param[in] Counter value returned by TIMER_Now
+ * @return    Elapsed cycles (valid below TIMER_MASK)
+ */
+uint32_t TIMER_Elapsed(uint32_t start) {
+    return (TIMER_Now() - start) & TIMER_MASK;
+}
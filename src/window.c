@@ -0,0 +1,99 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   window.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  File containing definitions for FFT window functions. Tables are
+ *         calculated by the compiler for any FFT_SIZE.
+ * @ver    0.1
+ */
+
+#include "window.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* symmetric windows: argument of sample n, in [0, pi) for the first half */
+#define WIN_X(n)                 (2*WIN_PI*(n)/(FFT_SIZE-1))
+/* cos(k*x) calculated with Chebyshev polynomials of cos(x) */
+#define WIN_C1(n)                WIN_COS_H(WIN_X(n))
+#define WIN_C2(n)                (2*WIN_C1(n)*WIN_C1(n)-1)
+#define WIN_C3(n)                (WIN_C1(n)*(4*WIN_C1(n)*WIN_C1(n)-3))
+#define WIN_C4(n)                (2*WIN_C2(n)*WIN_C2(n)-1)
+
+/* window functions, same coefficients as in MATLAB */
+#define WIN_HANN(n)              WIN_Q15(0.5 - 0.5*WIN_C1(n))
+#define WIN_BLACKMAN_HARRIS(n)   WIN_Q15(0.35875 - 0.48829*WIN_C1(n)          \
+                                         + 0.14128*WIN_C2(n) - 0.01168*WIN_C3(n))
+#define WIN_FLAT_TOP(n)          WIN_Q15(0.21557895 - 0.41663158*WIN_C1(n)    \
+                                         + 0.277263158*WIN_C2(n)              \
+                                         - 0.083578947*WIN_C3(n)              \
+                                         + 0.006947368*WIN_C4(n))
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* first halves of symmetric windows: w[FFT_SIZE-1-n] = w[n] */
+static const q15_t Window_Tables[WINDOW_RECTANGULAR][FFT_SIZE/2] = {
+    { WIN_HALF(WIN_HANN) },
+    { WIN_HALF(WIN_BLACKMAN_HARRIS) },
+    { WIN_HALF(WIN_FLAT_TOP) }
+};
+
+/* 2*log2(0.5/coherent gain) in Q8 format, Hann window is the reference */
+static const int16_t Window_Correction[WINDOW_COUNT] = {0, 245, 621, -512};
+
+static volatile WindowType window_type = WINDOW_HANN;
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Select window function, can be changed at any time.
+ * @param[in] Window type
+ */
+void WINDOW_Select(WindowType type) {
+    if( type < WINDOW_COUNT )
+        window_type = type;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Get selected window function.
+ * @return Window type
+ */
+WindowType WINDOW_Get(void) {
+    return window_type;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Coefficient of the selected window.
+ * @param[in] Sample number: 0 to FFT_SIZE-1
+ * @return    Coefficient in Q15 format
+ */
+q15_t WINDOW_Coeff(uint16_t n) {
+    WindowType type = window_type;
+
+    if( type == WINDOW_RECTANGULAR )
+        return 32767;
+
+    /* second half is a mirror of the first one */
+    if( n >= FFT_SIZE/2 )
+        n = FFT_SIZE-1-n;
+
+    return Window_Tables[type][n];
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Power correction of the selected window, equalizes levels of a tone
+ *         with levels calculated for the Hann window.
+ * @return Correction added to log2(power), Q8 format
+ */
+int32_t WINDOW_PowerCorrection(void) {
+    return Window_Correction[window_type];
+}
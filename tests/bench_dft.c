@@ -0,0 +1,134 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   bench_dft.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host benchmark of the per-sample DFT engine (dft.c) against the full
+ *         FFT path in mode 4: time per frame of DFT_Push for FFT_HOP_SIZE
+ *         samples with DFT_Latch (ADC0 interrupt) and of FFT_ProcessBuffer
+ *         (main loop), and multiplications per frame of both paths. The FFT
+ *         is the host stand-in, CMSIS-DSP arm_rfft_q15 is counted as a
+ *         radix-2 transform of FFT_SIZE/2 complex points with the real
+ *         split.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "dft.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of each measured path */
+#define BENCH_FRAMES             (20000)
+/* measured mode, one bin per column */
+#define BENCH_MODE               (4)
+
+/* multiplications per frame: DFT - window and re, im of every bin for every
+   overlapping frame; FFT - window, butterflies, real split and bin powers */
+#define BENCH_DFT_MULS           (DFT_FRAMES*FFT_HOP_SIZE*(1 + 2*DFT_BINS))
+#define BENCH_FFT_LOG2           (7)      /* log2(FFT_SIZE/2) */
+#define BENCH_FFT_MULS           (FFT_SIZE + 4*(FFT_SIZE/4)*BENCH_FFT_LOG2 \
+                                  + 4*(FFT_SIZE/2) + 2*DFT_BINS)
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static double bench_now(void);
+static void bench_fill(uint8_t buffer, uint32_t frame);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    double isr = 0, loop = 0, fft = 0;
+    double start;
+    
+#if FFT_SIZE != (2 << BENCH_FFT_LOG2)
+#error "BENCH_FFT_LOG2 does not match FFT_SIZE"
+#endif
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    FFTstatus.mode = BENCH_MODE;
+    
+    /* DFT: samples are pushed one by one, columns come from latched bins */
+    for( uint32_t frame=0; frame<BENCH_FRAMES; frame++ ) {
+        uint8_t buffer = (uint8_t)(frame % FFT_BUFFERS);
+        
+        bench_fill(buffer, frame);
+        start = bench_now();
+        for( uint16_t i=0; i<FFT_HOP_SIZE; i++ )
+            DFT_Push((int16_t)(FFT_Buffer[buffer][i] >> FFT_Q15_SHIFT));
+        DFT_Latch(buffer);
+        isr += bench_now() - start;
+        
+        start = bench_now();
+        FFT_ProcessBuffer(buffer);
+        loop += bench_now() - start;
+    }
+    
+    /* FFT: frames of mode 1 are not calculated by DFT, so latched bins are
+       not valid and FFT_ProcessBuffer windows and transforms */
+    FFTstatus.mode = 1;
+    for( uint16_t i=0; i<FFT_SIZE; i++ )
+        DFT_Push(0);
+    for( uint8_t b=0; b<FFT_BUFFERS; b++ )
+        DFT_Latch(b);
+    FFTstatus.mode = BENCH_MODE;
+    for( uint32_t frame=0; frame<BENCH_FRAMES; frame++ ) {
+        uint8_t buffer = (uint8_t)(frame % FFT_BUFFERS);
+        
+        bench_fill(buffer, frame);
+        start = bench_now();
+        FFT_ProcessBuffer(buffer);
+        fft += bench_now() - start;
+    }
+    
+    printf("bench_dft: mode %d, %d frames of %d samples, per frame:\n",
+           BENCH_MODE, BENCH_FRAMES, FFT_HOP_SIZE);
+    printf("%-28s %10s %12s\n", "path", "ns", "multiplies");
+    printf("%-28s %10.0f %12d\n", "DFT_Push+DFT_Latch (ISR)", isr*1e9/BENCH_FRAMES,
+           BENCH_DFT_MULS);
+    printf("%-28s %10.0f %12s\n", "FFT_ProcessBuffer with DFT", loop*1e9/BENCH_FRAMES, "-");
+    printf("%-28s %10.0f %12d\n", "FFT_ProcessBuffer with FFT", fft*1e9/BENCH_FRAMES,
+           BENCH_FFT_MULS);
+    
+    return 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Monotonic time.
+ * @return Seconds
+ */
+static double bench_now(void) {
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Fill a buffer with a tone and noise, as captured by ADC0
+ *            interrupt.
+ * @param[in] Buffer number
+ * @param[in] Frame number
+ */
+static void bench_fill(uint8_t buffer, uint32_t frame) {
+    static uint32_t seed = 1;
+    
+    for( uint16_t i=0; i<FFT_HOP_SIZE; i++ ) {
+        double t = (double)(frame*FFT_HOP_SIZE + i)/FFT_SAMPLE_RATE;
+        
+        seed = seed*1103515245u + 12345u;
+        FFT_Buffer[buffer][i] = FFT_TO_SAMPLE(lround(800*sin(2*M_PI*6000*t))
+                                              + (int32_t)((seed >> 16) & 0xF) - 8);
+    }
+}
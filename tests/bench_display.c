@@ -0,0 +1,248 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   bench_display.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host benchmark of level smoothing (DISPLAY_Smooth): audio goes
+ *         through FFT_ProcessBuffer in mode 1 and every frame is drawn by
+ *         display.c, glyph.c and lcd1602.c on the LCD model (lcd_model.c).
+ *         Input is raw 16-bit little-endian mono PCM at 40 kHz given as the
+ *         argument, or synthetic music (chords with tremolo and decay, and
+ *         some noise) without it. Prints LCD writes per second (instructions,
+ *         characters and CGRAM rows), how much the shown bars are above the
+ *         calculated levels, and the latency of steps given to DISPLAY_Submit
+ *         directly, read back from the LCD. Built once per smoothing setting:
+ *         none (DISPLAY_SMOOTH 0), decay only, decay and hysteresis; peak
+ *         markers are off, so a bar is the shown level.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "fft.h"
+#include "level.h"
+#include "display.h"
+#include "glyph.h"
+#include "lcd1602.h"
+#include "timer.h"
+#include "lcd_model.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* synthetic music: length, chord length, tremolo and levels in ADC units */
+#define BENCH_SECONDS            (10)
+#define BENCH_CHORD_S            (0.5)
+#define BENCH_TREMOLO_HZ         (6.0)
+#define BENCH_AMPLITUDE          (400.0)
+#define BENCH_NOISE              (24)
+/* frames of every level step and frame rate of mode 1 */
+#define BENCH_STEP_FRAMES        (FFT_FRAME_RATE)
+#define BENCH_FRAME_RATE         (FFT_FRAME_RATE)
+/* frames in ms */
+#define BENCH_MS(frames)         (1000.0*(frames)/BENCH_FRAME_RATE)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* chords of three notes (Hz), one after another */
+static const double Bench_Chords[][3] = {
+    {130.8, 164.8, 196.0},
+    {110.0, 130.8, 164.8},
+    {174.6, 220.0, 261.6},
+    {196.0, 246.9, 293.7},
+    {523.3, 659.3, 784.0},
+    {440.0, 523.3, 1318.5}
+};
+
+/* level steps: from, to */
+static const uint8_t Bench_Steps[][2] = {
+    {0, 16},
+    {16, 15},
+    {16, 12},
+    {16, 0}
+};
+
+static FILE *bench_input = NULL;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void bench_audio(void);
+static void bench_steps(void);
+static void bench_draw(const uint8_t *levels);
+static int16_t bench_nextSample(uint32_t n);
+static uint8_t bench_shown(uint8_t col);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    if( argc > 1 && (bench_input = fopen(argv[1], "rb")) == NULL ) {
+        printf("bench_display: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    FFTstatus.mode = 1;
+    LEVEL_SetFrameRate(BENCH_FRAME_RATE);
+    DISPLAY_SetFrameRate(BENCH_FRAME_RATE);
+    
+    TIMER_Init();
+    LCD1602_Init();
+    LCD1602_LVL_CH();
+    GLYPH_Reset();
+    LCD1602_ClearAll();
+    I2C_Wait();
+    
+    printf("bench_display: smoothing %s, %s\n", !DISPLAY_SMOOTH ? "off" :
+           DISPLAY_HYSTERESIS ? "decay and hysteresis" : "decay only",
+           bench_input ? argv[1] : "synthetic music");
+    bench_audio();
+    bench_steps();
+    
+    if( bench_input )
+        fclose(bench_input);
+    return 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Run the audio through the FFT and the display, print LCD writes per
+ *        second and the difference between shown and calculated levels.
+ */
+static void bench_audio(void) {
+    LcdModelCounters counters;
+    uint32_t frames = 0, above = 0, cells = 0;
+    uint64_t excess = 0;
+    uint32_t n = 0;
+    
+    LCD_MODEL_Reset();
+    for( uint32_t buffer=0; n<(uint32_t)BENCH_SECONDS*FFT_SAMPLE_RATE; buffer++ ) {
+        uint8_t b = (uint8_t)(buffer % FFT_BUFFERS);
+        
+        for( uint16_t i=0; i<FFT_HOP_SIZE; i++ )
+            FFT_Buffer[b][i] = FFT_TO_SAMPLE(bench_nextSample(n++));
+        if( !FFT_ProcessBuffer(b) )
+            continue;
+        
+        bench_draw(FrequencyBins);
+        frames++;
+        for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+            uint8_t shown = bench_shown(i);
+            
+            cells++;
+            if( shown > FrequencyBins[i] ) {
+                above++;
+                excess += shown - FrequencyBins[i];
+            }
+        }
+    }
+    LCD_MODEL_Get(&counters);
+    
+    printf("  %lu frames: %.0f LCD writes/s (%.0f instructions, %.0f characters, "
+           "%.0f CGRAM rows), %.0f I2C bytes/s\n", (unsigned long)frames,
+           (double)(counters.instructions + counters.ddramWrites + counters.cgramWrites)*
+           BENCH_FRAME_RATE/frames,
+           (double)counters.instructions*BENCH_FRAME_RATE/frames,
+           (double)counters.ddramWrites*BENCH_FRAME_RATE/frames,
+           (double)counters.cgramWrites*BENCH_FRAME_RATE/frames,
+           (double)(counters.dataBytes + counters.addressBytes)*BENCH_FRAME_RATE/frames);
+    printf("  bars above the calculated level: %.1f%% of columns, %.2f levels on "
+           "average\n", 100.0*above/cells, above ? (double)excess/above : 0.0);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Give level steps to all columns and print the time until the LCD
+ *        shows the new level (latency added by smoothing).
+ */
+static void bench_steps(void) {
+    for( uint8_t s=0; s<sizeof(Bench_Steps)/sizeof(Bench_Steps[0]); s++ ) {
+        uint8_t levels[DISPLAY_COLUMNS];
+        int32_t latency = -1;
+        
+        memset(levels, Bench_Steps[s][0], sizeof(levels));
+        for( uint32_t f=0; f<BENCH_STEP_FRAMES; f++ )
+            bench_draw(levels);
+        
+        memset(levels, Bench_Steps[s][1], sizeof(levels));
+        for( uint32_t f=0; f<BENCH_STEP_FRAMES && latency < 0; f++ ) {
+            bench_draw(levels);
+            if( bench_shown(0) == Bench_Steps[s][1] )
+                latency = (int32_t)f;
+        }
+        
+        if( latency < 0 )
+            printf("  step %2d -> %2d: not shown within %lu frames\n", Bench_Steps[s][0],
+                   Bench_Steps[s][1], (unsigned long)BENCH_STEP_FRAMES);
+        else
+            printf("  step %2d -> %2d: shown after %3ld frames (%.1f ms)\n",
+                   Bench_Steps[s][0], Bench_Steps[s][1], (long)latency,
+                   BENCH_MS(latency));
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Draw a frame as the main loop does and wait until it is sent.
+ * @param[in] Column levels: 0-16
+ */
+static void bench_draw(const uint8_t *levels) {
+    DISPLAY_Submit(levels);
+    DISPLAY_Service();
+    I2C_Wait();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Next sample: from the file while it lasts, then the music.
+ * @param[in] Sample number
+ * @return    Sample in ADC units, DC removed
+ */
+static int16_t bench_nextSample(uint32_t n) {
+    static uint32_t seed = 1;
+    uint32_t chords = sizeof(Bench_Chords)/sizeof(Bench_Chords[0]);
+    double t = (double)n/FFT_SAMPLE_RATE;
+    double inChord = fmod(t, BENCH_CHORD_S);
+    const double *chord = Bench_Chords[(uint32_t)(t/BENCH_CHORD_S) % chords];
+    double x = 0;
+    uint8_t pcm[2];
+    
+    if( bench_input && fread(pcm, 1, 2, bench_input) == 2 )
+        return (int16_t)((int16_t)(pcm[0] | (pcm[1] << 8))/16);
+    
+    /* notes decay within the chord and tremble */
+    for( uint8_t k=0; k<3; k++ )
+        x += sin(2*M_PI*chord[k]*t)*(1.0 + 0.3*sin(2*M_PI*BENCH_TREMOLO_HZ*t + k));
+    x *= BENCH_AMPLITUDE*exp(-3.0*inChord);
+    seed = seed*1103515245u + 12345u;
+    return (int16_t)(lround(x) + (int32_t)((seed >> 16) % (2*BENCH_NOISE)) - BENCH_NOISE);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Level shown by the LCD in a column: lit strips from the bottom,
+ *            decoded from DDRAM and CGRAM.
+ * @param[in] Column number
+ * @return    Level: 0-16
+ */
+static uint8_t bench_shown(uint8_t col) {
+    uint8_t level = 0;
+    
+    for( uint8_t cell=0; cell<2; cell++ ) {
+        uint8_t rows[8];
+        
+        if( !LCD_MODEL_Rows(LCD_MODEL_Char(col, (uint8_t)(1 - cell)), rows) )
+            return level;
+        for( int8_t row=7; row>=0; row-- ) {
+            if( rows[row] != 0x1F )
+                return level;
+            level++;
+        }
+    }
+    return level;
+}
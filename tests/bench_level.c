@@ -0,0 +1,121 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   bench_level.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host micro-benchmark of the magnitude to bar level mapping: the old
+ *         floating point formula against the integer mapper (level.c), per 
+ *         column and per frame of 16 columns. Host times only compare the 
+ *         paths; on Cortex-M0+ every double operation of the old formula is
+ *         a library call, so the difference there is larger.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "level.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* columns mapped by each measured path */
+#define BENCH_COLUMNS            (1u << 22)
+/* columns of one displayed frame */
+#define BENCH_FRAME              (16)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* keeps the compiler from removing the measured loops */
+static volatile uint32_t bench_sink;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static double bench_now(void);
+static uint8_t bench_oldFormula(uint32_t mag);
+static uint8_t bench_floatPower(int32_t re, int32_t im);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    const char *names[4] = {
+        "log10 of magnitude (old)",
+        "LEVEL_FromMagnitude",
+        "sqrt+log10 of re, im",
+        "LEVEL_Log2Power",
+    };
+    double ns[4];
+    double start;
+    uint32_t sum;
+    
+    for( uint8_t path=0; path<4; path++ ) {
+        sum = 0;
+        start = bench_now();
+        for( uint32_t i=1; i<=BENCH_COLUMNS; i++ ) {
+            /* spread of values similar to the bins of a real spectrum */
+            uint32_t mag = (i * 2654435761u) >> (i & 15);
+            int32_t re = (int32_t)(mag >> 2) - 0x1000;
+            int32_t im = (int32_t)(i & 0x3FFF);
+            
+            switch( path ) {
+            case 0: sum += bench_oldFormula(mag); break;
+            case 1: sum += LEVEL_FromMagnitude(mag); break;
+            case 2: sum += bench_floatPower(re, im); break;
+            default: sum += LEVEL_FromLog2Power(LEVEL_Log2Power(re, im)); break;
+            }
+        }
+        ns[path] = (bench_now() - start) * 1e9 / BENCH_COLUMNS;
+        bench_sink = sum;
+    }
+    
+    printf("%-26s %10s %10s\n", "mapping", "ns/column", "ns/frame");
+    for( uint8_t path=0; path<4; path++ )
+        printf("%-26s %10.2f %10.1f\n", names[path], ns[path], ns[path]*BENCH_FRAME);
+    
+    return 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Monotonic time.
+ * @return Seconds
+ */
+static double bench_now(void) {
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Bar level calculated like in the original FFT_PrintColumns.
+ * @param[in] Magnitude
+ * @return    Bar level: 0-16
+ */
+static uint8_t bench_oldFormula(uint32_t mag) {
+    int32_t lvl = (int32_t)(log10((double)mag) * 16 / 3.5) - 9;
+    
+    return lvl < 0 ? 0 : lvl > LEVEL_MAX ? LEVEL_MAX : (uint8_t)lvl;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Bar level of a complex bin calculated with floating point (the 
+ *            float16_t pipeline with arm_cmplx_mag_f16).
+ * @param[in] Real part
+ * @param[in] Imaginary part
+ * @return    Bar level: 0-16
+ */
+static uint8_t bench_floatPower(int32_t re, int32_t im) {
+    float mag = sqrtf((float)re*re + (float)im*im);
+    
+    return mag < 1.0f ? 0 : bench_oldFormula((uint32_t)mag);
+}
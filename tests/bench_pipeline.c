@@ -0,0 +1,173 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   bench_pipeline.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host run of the whole spectrum pipeline with the profiler (prof.h)
+ *         on the host clock: samples go through ADC0_IRQHandler (DC removal,
+ *         decimation, DFT engine, queue) and the main loop stages (window, 
+ *         FFT, columns, display). Input is raw 16-bit little-endian mono PCM
+ *         at 40 kHz given as the argument, or a synthetic sweep without it.
+ *         Times are host nanoseconds; the FFT is a stand-in for CMSIS-DSP
+ *         (stub/arm_rfft.c) and the LCD is not driven, so only the shares
+ *         of the other stages are comparable with the board. The file is
+ *         built once per FFT_FIXED_POINT (bench_pipeline_f16), the whole
+ *         FFT_ProcessBuffer to columns path is timed for each pipeline; 
+ *         float16_t is a native float on the host, not emulated.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "ADC.h"
+#include "queue.h"
+#include "level.h"
+#include "display.h"
+#include "lcd1602.h"
+#include "i2c.h"
+#include "prof.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* samples per mode: one second */
+#define BENCH_SAMPLES            (FFT_SAMPLE_RATE)
+/* synthetic input: sweep from 50 Hz to 18 kHz with some noise, ADC units */
+#define BENCH_SWEEP_LOW          (50.0)
+#define BENCH_SWEEP_HIGH         (18000.0)
+#define BENCH_AMPLITUDE          (1200.0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static FILE *bench_input = NULL;
+static uint32_t bench_frames = 0;
+static uint32_t bench_shown = 0;
+/* time spent in FFT_ProcessBuffer */
+static uint64_t bench_processTime = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+void ADC0_IRQHandler(void);
+static uint16_t bench_nextSample(uint32_t n);
+static void bench_mainLoop(void);
+static void bench_printLine(const char *line);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    uint32_t n = 0;
+    
+    if( argc > 1 && (bench_input = fopen(argv[1], "rb")) == NULL ) {
+        printf("bench_pipeline: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    
+    /* every mode for a second, as after pressing its key */
+    for( uint8_t mode=1; mode<=FFT_MODES; mode++ ) {
+        FFTstatus.mode = mode;
+        DISPLAY_Reset();
+        LEVEL_AgcReset();
+        LEVEL_SetFrameRate(FFT_MODE_FRAME_RATE(mode));
+        DISPLAY_SetFrameRate(FFT_MODE_FRAME_RATE(mode));
+        
+        for( uint32_t i=0; i<BENCH_SAMPLES; i++, n++ ) {
+            ADC0->R[0] = bench_nextSample(n);
+            ADC0_IRQHandler();
+            bench_mainLoop();
+        }
+    }
+    
+    printf("bench_pipeline: %s pipeline, %s, %lu frames, %lu shown\n", 
+           FFT_FIXED_POINT ? "Q15" : "float16_t", bench_input ? argv[1] : "sweep", 
+           (unsigned long)bench_frames, (unsigned long)bench_shown);
+    printf("  FFT_ProcessBuffer %lu ns per frame, ns per stage:\n", 
+           (unsigned long)(bench_frames ? bench_processTime/bench_frames : 0));
+    PROF_Report(bench_printLine);
+    
+    if( bench_input )
+        fclose(bench_input);
+    return 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Next ADC result: from the file while it lasts, then the sweep.
+ * @param[in] Sample number
+ * @return    12-bit conversion result
+ */
+static uint16_t bench_nextSample(uint32_t n) {
+    static double phase = 0;
+    static uint32_t seed = 1;
+    double t = (double)n/(FFT_MODES*BENCH_SAMPLES);
+    double x;
+    uint8_t pcm[2];
+    
+    if( bench_input && fread(pcm, 1, 2, bench_input) == 2 ) {
+        int16_t s = (int16_t)(pcm[0] | (pcm[1] << 8));
+        
+        return (uint16_t)(2048 + s/16);
+    }
+    
+    /* logarithmic sweep over the whole run */
+    phase += 2*M_PI*BENCH_SWEEP_LOW*pow(BENCH_SWEEP_HIGH/BENCH_SWEEP_LOW, t)/FFT_SAMPLE_RATE;
+    seed = seed*1103515245u + 12345u;
+    x = BENCH_AMPLITUDE*sin(phase) + (double)((seed >> 16) & 0x3F) - 32;
+    return (uint16_t)(FFT_AVG_VALUE + lround(x));
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Body of the main loop in main.c, run after every sample.
+ */
+static void bench_mainLoop(void) {
+    int8_t slot;
+    
+    while( (slot = QUEUE_ReadSlot()) != QUEUE_NONE ) {
+        uint8_t valid;
+        uint32_t start;
+        
+        if( !QUEUE_IsContinuous() )
+            FFT_ResetHistory();
+        start = PROF_CLOCK();
+        valid = FFT_ProcessBuffer((uint8_t)slot);
+        bench_processTime += PROF_ELAPSED(start);
+        QUEUE_Release();
+        bench_frames++;
+        
+        if( valid )
+            DISPLAY_Submit(FrequencyBins);
+        bench_shown += DISPLAY_Service();
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Report line on the console instead of the LCD.
+ * @param[in] Line of text
+ */
+static void bench_printLine(const char *line) {
+    printf("  %s\n", line);
+}
+
+/******************************************************************************
+ * LCD and I2C are not driven on the host
+ ******************************************************************************/
+
+void LCD1602_Print(char *str) {}
+void LCD1602_ClearAll(void) {}
+void LCD1602_SetCursor(uint8_t col, uint8_t row) {}
+void LCD1602_LVL_CH(void) {}
+void LCD1602_PutChar(uint8_t col, uint8_t row, char ch) {}
+void LCD1602_LoadChar(uint8_t slot, const uint8_t *rows) {}
+uint8_t LCD1602_Flush(void) { return 0; }
+uint8_t I2C_IsBusy(void) { return 0; }
+void DIAG_IsrCycles(uint32_t cycles) {}
@@ -0,0 +1,150 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   sim_boot.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Timing simulation of the boot sequence of main.c on the clock of
+ *         the LCD model (lcd_model.c, HD44780 execution times included) with
+ *         the real lcd1602.c, glyph.c and display.c: LCD initialization,
+ *         CGRAM image (LCD1602_LVL_CH), initialization message, splash delay
+ *         (BOOT_SPLASH), clear display and the first frame, which needs
+ *         FFT_SIZE samples and SIM_DSP_US of DSP. Steps without the LCD
+ *         (FFT_Init, PIT, ADC calibration, keypad) are not counted. Prints
+ *         time of every step with burst writes and with every expander byte
+ *         in its own I2C transaction (old transport, without the busy flag
+ *         polling and DELAY loops of the old path). Built once per 
+ *         BOOT_SPLASH.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include "fft.h"
+#include "display.h"
+#include "glyph.h"
+#include "lcd1602.h"
+#include "level.h"
+#include "timer.h"
+#include "lcd_model.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* the same default as in main.c */
+#ifndef BOOT_SPLASH
+#define BOOT_SPLASH              (1)
+#endif
+
+/* core clock cycles of one iteration of FFT_DELAY (volatile counter: load,
+   add, store, load, compare, branch) */
+#define SIM_DELAY_LOOP_CYCLES    (6)
+/* DSP of one frame (window, FFT, columns), as in sim_buffers.c */
+#define SIM_DSP_US               (1500)
+/* steps of the boot sequence */
+#define SIM_STEPS                (6)
+/* model time in ms */
+#define SIM_MS(cycles)           (1000.0*(double)(cycles)/TIMER_CLOCK_HZ)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const char *Sim_Steps[SIM_STEPS] = {
+    "LCD1602_Init",
+    "LCD1602_LVL_CH",
+    "message",
+    "splash",
+    "clear",
+    "first frame"
+};
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void sim_boot(uint64_t *steps);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    uint64_t steps[2][SIM_STEPS];
+    uint64_t total[2] = {0, 0};
+    
+    TIMER_Init();
+    DISPLAY_SetFrameRate(FFT_FRAME_RATE);
+    
+    /* path 0: burst writes, 1: single bytes (the LCD is in 4-bit mode, 
+       LCD1602_Init resets it by instructions) */
+    for( uint8_t path=0; path<2; path++ ) {
+        LCD_MODEL_SingleBytes(path);
+        sim_boot(steps[path]);
+        for( uint8_t i=0; i<SIM_STEPS; i++ )
+            total[path] += steps[path][i];
+    }
+    LCD_MODEL_SingleBytes(0);
+    
+    printf("boot with BOOT_SPLASH %d\n", BOOT_SPLASH);
+    printf("%-16s %12s %14s\n", "step", "burst ms", "single ms");
+    for( uint8_t i=0; i<SIM_STEPS; i++ )
+        printf("%-16s %12.2f %14.2f\n", Sim_Steps[i], SIM_MS(steps[0][i]),
+               SIM_MS(steps[1][i]));
+    printf("%-16s %12.2f %14.2f\n", "total", SIM_MS(total[0]), SIM_MS(total[1]));
+    
+    return 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Boot sequence of main.c up to the first frame on the LCD, every
+ *             step ends when its bytes are transmitted.
+ * @param[out] Core clock cycles of every step (Sim_Steps)
+ */
+static void sim_boot(uint64_t *steps) {
+    uint8_t levels[DISPLAY_COLUMNS];
+    uint64_t last = LCD_MODEL_Now();
+    uint8_t step = 0;
+    
+    LCD1602_Init();
+    I2C_Wait();
+    steps[step++] = LCD_MODEL_Now() - last;
+    last = LCD_MODEL_Now();
+    
+    LCD1602_LVL_CH();
+    GLYPH_Reset();
+    I2C_Wait();
+    steps[step++] = LCD_MODEL_Now() - last;
+    last = LCD_MODEL_Now();
+    
+    LCD1602_SetCursor(0,0);
+    LCD1602_Print("Initialization.");
+    LCD1602_SetCursor(0,1);
+    LCD1602_Print("Please wait...");
+    steps[step++] = LCD_MODEL_Now() - last;
+    last = LCD_MODEL_Now();
+
+#if BOOT_SPLASH
+    /* FFT_DELAY(1000) while the message is transmitted */
+    LCD_MODEL_Tick((uint64_t)1000*10000*SIM_DELAY_LOOP_CYCLES);
+#endif
+    steps[step++] = LCD_MODEL_Now() - last;
+    last = LCD_MODEL_Now();
+    
+    LCD1602_ClearAll();
+    DISPLAY_Reset();
+    I2C_Wait();
+    steps[step++] = LCD_MODEL_Now() - last;
+    last = LCD_MODEL_Now();
+    
+    /* FFT_SIZE samples from ADC_Start, DSP and the frame on the LCD */
+    LCD_MODEL_Tick((uint64_t)FFT_SIZE*TIMER_CLOCK_HZ/FFT_SAMPLE_RATE + TIMER_US(SIM_DSP_US));
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ )
+        levels[i] = (uint8_t)(LEVEL_MAX - i);
+    DISPLAY_Submit(levels);
+    DISPLAY_Service();
+    I2C_Wait();
+    steps[step] = LCD_MODEL_Now() - last;
+}
@@ -0,0 +1,181 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   sim_buffers.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Timing simulation of sample buffers at the current LCD cost: the
+ *         main loop of main.c runs on the clock of the LCD model with the 
+ *         real queue (QUEUE_DROP_OLDEST), display.c, glyph.c and lcd1602.c.
+ *         A buffer is published every FFT_HOP_SIZE samples, its DSP takes 
+ *         SIM_DSP_US and the LCD takes the bus time of the bytes lcd1602.c
+ *         really sends; the loop stalls only when the I2C queue of i2c.c is
+ *         full. Prints frames lost (FFT_HOP_SIZE samples each), frames per 
+ *         second on the LCD and the longest stall for typical spectra. Built
+ *         once per FFT_BUFFERS; CPU time of I2C interrupts is not counted.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "fft.h"
+#include "queue.h"
+#include "display.h"
+#include "glyph.h"
+#include "lcd1602.h"
+#include "level.h"
+#include "timer.h"
+#include "lcd_model.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* simulated time of every spectrum */
+#define SIM_SECONDS              (10)
+/* DSP of one frame (window, FFT, columns) */
+#define SIM_DSP_US               (1500)
+/* core clock cycles between two published buffers */
+#define SIM_PERIOD               ((uint64_t)FFT_HOP_SIZE*TIMER_CLOCK_HZ/FFT_SAMPLE_RATE)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const char *Sim_Spectra[] = {
+    "steady",          /* the same levels every frame */
+    "music",           /* falling slope which moves slowly */
+    "sweep",           /* one strong column moving over the others */
+    "noise"            /* random levels every frame */
+};
+
+/* buffers published by the simulated interrupt */
+static uint64_t sim_buffers = 0;
+static uint64_t sim_start = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void sim_capture(void);
+static void sim_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    TIMER_Init();
+    LCD1602_Init();
+    LCD1602_LVL_CH();
+    GLYPH_Reset();
+    LCD1602_ClearAll();
+    I2C_Wait();
+    DISPLAY_SetFrameRate(FFT_FRAME_RATE);
+    
+    printf("%d buffers (%lu bytes of RAM), %d us of DSP per %.1f ms buffer\n", FFT_BUFFERS,
+           (unsigned long)FFT_BUFFERS_RAM, SIM_DSP_US, 1e3*FFT_HOP_SIZE/FFT_SAMPLE_RATE);
+    printf("%-8s %10s %10s %10s %14s %14s\n", "spectrum", "frames", "lost", "LCD fps",
+           "I2C bytes/fr", "longest stall");
+    for( uint8_t s=0; s<sizeof(Sim_Spectra)/sizeof(Sim_Spectra[0]); s++ ) {
+        uint32_t lost = QUEUE_GetDroppedFrames();
+        uint32_t frames = 0, shown = 0;
+        uint64_t stall = 0;
+        LcdModelCounters counters;
+        int8_t slot;
+        
+        /* the interrupt starts a new buffer at the next period */
+        I2C_Wait();
+        while( QUEUE_ReadSlot() != QUEUE_NONE )
+            QUEUE_Release();
+        DISPLAY_Reset();
+        LCD_MODEL_Reset();
+        sim_buffers = 0;
+        sim_start = LCD_MODEL_Now();
+        QUEUE_WriteSlot();
+        
+        while( sim_buffers < (uint64_t)SIM_SECONDS*FFT_FRAME_RATE ) {
+            uint64_t next;
+            
+            sim_capture();
+            while( (slot = QUEUE_ReadSlot()) != QUEUE_NONE ) {
+                uint8_t levels[DISPLAY_COLUMNS];
+                uint64_t before;
+                
+                sim_levels(s, frames, levels);
+                LCD_MODEL_Tick(TIMER_US(SIM_DSP_US));
+                sim_capture();
+                QUEUE_Release();
+                frames++;
+                
+                /* the loop waits only if the I2C queue is full */
+                before = LCD_MODEL_Now();
+                DISPLAY_Submit(levels);
+                shown += DISPLAY_Service();
+                if( LCD_MODEL_Now() - before > stall )
+                    stall = LCD_MODEL_Now() - before;
+                sim_capture();
+            }
+            shown += DISPLAY_Service();
+            
+            /* __WFI: next buffer or the end of the I2C transmission */
+            next = sim_start + (sim_buffers + 1)*SIM_PERIOD;
+            if( LCD_MODEL_BusFree() > LCD_MODEL_Now() && LCD_MODEL_BusFree() < next )
+                next = LCD_MODEL_BusFree();
+            if( next > LCD_MODEL_Now() )
+                LCD_MODEL_Tick(next - LCD_MODEL_Now());
+        }
+        LCD_MODEL_Get(&counters);
+        lost = QUEUE_GetDroppedFrames() - lost;
+        
+        printf("%-8s %10lu %10lu %10.1f %14.1f %11.2f ms\n", Sim_Spectra[s],
+               (unsigned long)frames, (unsigned long)lost, (double)shown/SIM_SECONDS,
+               (double)(counters.dataBytes + counters.addressBytes)/(shown ? shown : 1),
+               1e3*stall/TIMER_CLOCK_HZ);
+    }
+    return 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Sampling interrupt until now: a buffer is published every SIM_PERIOD
+ *        and the next one is taken, the oldest waiting frame is overwritten
+ *        when all buffers are occupied.
+ */
+static void sim_capture(void) {
+    while( sim_start + (sim_buffers + 1)*SIM_PERIOD <= LCD_MODEL_Now() ) {
+        QUEUE_Publish();
+        sim_buffers++;
+        QUEUE_WriteSlot();
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Levels of a frame of a test spectrum, the same as in 
+ *             test_glyph.c.
+ * @param[in]  Spectrum (Sim_Spectra)
+ * @param[in]  Frame number
+ * @param[out] Column levels: 0-16
+ */
+static void sim_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels) {
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        int32_t level;
+        
+        switch( spectrum ) {
+            case 0:
+                level = 14 - i*3/4;
+                break;
+            case 1:
+                level = 15 - i*3/4 + (int32_t)((frame/40 + i*7) % 5) - 2;
+                break;
+            case 2:
+                level = (i == (frame/25) % DISPLAY_COLUMNS) ? 15 : 3 + (i & 1);
+                break;
+            default:
+                level = rand() % (LEVEL_MAX + 1);
+                break;
+        }
+        levels[i] = (uint8_t)(level < 0 ? 0 : level > LEVEL_MAX ? LEVEL_MAX : level);
+    }
+}
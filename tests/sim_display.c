@@ -0,0 +1,234 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   sim_display.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Discrete-event simulation of the main loop: a sample buffer comes
+ *         every FFT_HOP_SIZE samples, its DSP takes SIM_DSP_US and a frame on
+ *         the LCD takes the bus time of its I2C bytes. The sequential loop 
+ *         waits for the LCD after every frame; the pipelined one goes 
+ *         through display.c (DISPLAY_Submit/DISPLAY_Service), so the LCD is 
+ *         written in the background while the next frame is calculated. 
+ *         Prints frames per second on the LCD, mean latency from the end of
+ *         capture to the end of printing and sample buffers lost.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "fft.h"
+#include "display.h"
+#include "lcd1602.h"
+#include "i2c.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* simulated sample buffers */
+#define SIM_FRAMES               (20000)
+/* time between sample buffers, seconds */
+#define SIM_PERIOD               ((double)FFT_HOP_SIZE/FFT_SAMPLE_RATE)
+/* DSP of one frame (window, FFT, columns), seconds; background I2C 
+   interrupts take SIM_I2C_LOAD of the CPU in the pipelined loop */
+#define SIM_DSP                  (1.5e-3)
+#define SIM_I2C_LOAD             (1.02)
+/* one byte on the bus (8 bits and acknowledge) at ~94 kHz, seconds */
+#define SIM_BYTE                 (9/93750.0)
+/* expander bytes of a frame: mean and deviation of changed characters 
+   (4 bytes each) and cursor commands, plus start and addresses */
+#define SIM_LCD_BYTES            (80.0)
+#define SIM_LCD_SPREAD           (15.0)
+#define SIM_LCD_OVERHEAD         (8.0)
+/* sample buffers of the queue (QUEUE_DROP_OLDEST) */
+#define SIM_BUFFERS              (FFT_BUFFERS)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* simulated time and the end of the current LCD transmission */
+static double sim_now = 0;
+static double sim_lcdFree = 0;
+/* capture time of the newest frame given to the display */
+static double sim_newest = 0;
+/* captured buffers waiting for the main loop */
+static double sim_ready[SIM_BUFFERS];
+static uint8_t sim_readyCount = 0;
+static uint32_t sim_captured = 0;
+/* results */
+static uint32_t sim_shown = 0;
+static uint32_t sim_dropped = 0;
+static double sim_latency = 0;
+static uint32_t sim_seed = 1;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void sim_reset(void);
+static void sim_capture(void);
+static double sim_lcdTime(void);
+static void sim_sequential(void);
+static void sim_pipelined(void);
+static void sim_report(const char *name);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    sim_sequential();
+    sim_report("sequential");
+    sim_pipelined();
+    sim_report("pipelined");
+    return 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Start a new run with the same random sequence.
+ */
+static void sim_reset(void) {
+    sim_now = 0;
+    sim_lcdFree = 0;
+    sim_readyCount = 0;
+    sim_captured = 0;
+    sim_shown = 0;
+    sim_dropped = 0;
+    sim_latency = 0;
+    sim_seed = 1;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Buffers captured until now, the oldest one is lost when all are 
+ *        occupied.
+ */
+static void sim_capture(void) {
+    while( sim_captured < SIM_FRAMES && (sim_captured+1)*SIM_PERIOD <= sim_now ) {
+        sim_captured++;
+        if( sim_readyCount == SIM_BUFFERS ) {
+            for( uint8_t i=1; i<SIM_BUFFERS; i++ )
+                sim_ready[i-1] = sim_ready[i];
+            sim_readyCount--;
+            sim_dropped++;
+        }
+        sim_ready[sim_readyCount++] = sim_captured*SIM_PERIOD;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Bus time of one frame, normally distributed number of bytes.
+ * @return Time in seconds
+ */
+static double sim_lcdTime(void) {
+    double u1, u2;
+    
+    sim_seed = sim_seed*1103515245u + 12345u;
+    u1 = ((sim_seed >> 8) + 1.0)/16777217.0;
+    sim_seed = sim_seed*1103515245u + 12345u;
+    u2 = (sim_seed >> 8)/16777216.0;
+    
+    return (SIM_LCD_BYTES + SIM_LCD_SPREAD*sqrt(-2*log(u1))*cos(2*M_PI*u2) 
+            + SIM_LCD_OVERHEAD)*SIM_BYTE;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Main loop which prints every frame and waits for the LCD.
+ */
+static void sim_sequential(void) {
+    sim_reset();
+    
+    while( sim_captured < SIM_FRAMES || sim_readyCount ) {
+        double capture;
+        
+        sim_capture();
+        if( sim_readyCount == 0 ) {
+            sim_now = (sim_captured+1)*SIM_PERIOD;
+            continue;
+        }
+        
+        capture = sim_ready[0];
+        for( uint8_t i=1; i<sim_readyCount; i++ )
+            sim_ready[i-1] = sim_ready[i];
+        sim_readyCount--;
+        
+        sim_now += SIM_DSP + sim_lcdTime();
+        sim_shown++;
+        sim_latency += sim_now - capture;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Main loop of main.c: frames go to the display queue, which prints 
+ *        one whenever the LCD is free; the loop sleeps until the next buffer
+ *        or the end of the transmission.
+ */
+static void sim_pipelined(void) {
+    uint8_t levels[DISPLAY_COLUMNS] = {0};
+    
+    sim_reset();
+    DISPLAY_Reset();
+    
+    while( sim_captured < SIM_FRAMES || sim_readyCount ) {
+        double next;
+        
+        sim_capture();
+        while( sim_readyCount ) {
+            sim_newest = sim_ready[0];
+            for( uint8_t i=1; i<sim_readyCount; i++ )
+                sim_ready[i-1] = sim_ready[i];
+            sim_readyCount--;
+            
+            sim_now += SIM_DSP*SIM_I2C_LOAD;
+            DISPLAY_Submit(levels);
+            DISPLAY_Service();
+            sim_capture();
+        }
+        DISPLAY_Service();
+        
+        /* __WFI: next buffer or I2C interrupt at the end of the frame */
+        next = (sim_captured+1)*SIM_PERIOD;
+        if( sim_lcdFree > sim_now && sim_lcdFree < next )
+            next = sim_lcdFree;
+        sim_now = next;
+    }
+    
+    /* frame left in the display queue */
+    sim_now = sim_lcdFree;
+    DISPLAY_Service();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Print results of a run.
+ * @param[in] Name of the loop
+ */
+static void sim_report(const char *name) {
+    printf("%-10s %5.1f frames/s on LCD, latency %5.1f ms, %lu buffers lost "
+           "of %u\n", name, sim_shown/(SIM_FRAMES*SIM_PERIOD), 
+           1e3*sim_latency/sim_shown, (unsigned long)sim_dropped, SIM_FRAMES);
+}
+
+/******************************************************************************
+ * LCD and I2C of the pipelined loop: a flush occupies the bus
+ ******************************************************************************/
+
+uint8_t I2C_IsBusy(void) {
+    return sim_now < sim_lcdFree;
+}
+
+uint8_t LCD1602_Flush(void) {
+    sim_lcdFree = sim_now + sim_lcdTime();
+    sim_shown++;
+    sim_latency += sim_lcdFree - sim_newest;
+    return 0;
+}
+
+void LCD1602_Print(char *str) {}
+void LCD1602_ClearAll(void) {}
+void LCD1602_SetCursor(uint8_t col, uint8_t row) {}
+void LCD1602_LVL_CH(void) {}
+void LCD1602_PutChar(uint8_t col, uint8_t row, char ch) {}
+void LCD1602_LoadChar(uint8_t slot, const uint8_t *rows) {}
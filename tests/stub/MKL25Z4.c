@@ -0,0 +1,63 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   MKL25Z4.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host replacement of the peripherals: registers are plain memory,
+ *         NVIC keeps only enable bits and intrinsics do nothing unless a 
+ *         test defines its own ones.
+ * @ver    0.1
+ */
+
+#include "MKL25Z4.h"
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static SIM_Type     sim;
+static PORT_Type    porta, portb, portc;
+static GPIO_Type    pta, ptb, ptc;
+static ADC_Type     adc0;
+static PIT_Type     pit;
+static I2C_Type     i2c0;
+static SysTick_Type systick;
+static DMA_Type     dma0;
+static DMAMUX_Type  dmamux0;
+static uint32_t     nvic_enabled;
+
+/******************************************************************************
+ * Global variable definitions
+ ******************************************************************************/
+
+SIM_Type     *SIM     = &sim;
+PORT_Type    *PORTA   = &porta;
+PORT_Type    *PORTB   = &portb;
+PORT_Type    *PORTC   = &portc;
+GPIO_Type    *PTA     = &pta;
+GPIO_Type    *PTB     = &ptb;
+GPIO_Type    *PTC     = &ptc;
+ADC_Type     *ADC0    = &adc0;
+PIT_Type     *PIT     = &pit;
+I2C_Type     *I2C0    = &i2c0;
+SysTick_Type *SysTick = &systick;
+DMA_Type     *DMA0    = &dma0;
+DMAMUX_Type  *DMAMUX0 = &dmamux0;
+
+uint32_t SystemCoreClock = 48000000;
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+__attribute__((weak)) void NVIC_EnableIRQ(IRQn_Type irq) { nvic_enabled |= 1u << irq; }
+__attribute__((weak)) void NVIC_DisableIRQ(IRQn_Type irq) { nvic_enabled &= ~(1u << irq); }
+__attribute__((weak)) uint32_t NVIC_GetEnableIRQ(IRQn_Type irq) { return (nvic_enabled >> irq) & 1u; }
+__attribute__((weak)) void NVIC_ClearPendingIRQ(IRQn_Type irq) { (void)irq; }
+__attribute__((weak)) void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+__attribute__((weak)) void __WFI(void) {}
+__attribute__((weak)) void __enable_irq(void) {}
+__attribute__((weak)) void __disable_irq(void) {}
@@ -0,0 +1,194 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   MKL25Z4.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host replacement of the device header: peripherals are plain 
+ *         structures in RAM (MKL25Z4.c), so modules can be built and tested 
+ *         on a PC. Only registers and bits used by the project are defined.
+ * @ver    0.1
+ */
+
+#ifndef MKL25Z4_H
+#define MKL25Z4_H
+
+#include <stdint.h>
+
+/******************************************************************************
+ * Core
+ ******************************************************************************/
+
+typedef enum {
+    DMA0_IRQn  = 0,
+    I2C0_IRQn  = 8,
+    ADC0_IRQn  = 15,
+    PIT_IRQn   = 22,
+    PORTA_IRQn = 30
+} IRQn_Type;
+
+/* NVIC keeps only enable bits, intrinsics do nothing; tests may replace
+   them (weak symbols) */
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+void __WFI(void);
+void __enable_irq(void);
+void __disable_irq(void);
+
+#define __DMB()                  __sync_synchronize()
+
+extern uint32_t SystemCoreClock;
+
+/******************************************************************************
+ * Peripherals
+ ******************************************************************************/
+
+typedef struct {
+    volatile uint32_t SOPT2, SOPT7, SCGC4, SCGC5, SCGC6, SCGC7;
+} SIM_Type;
+
+typedef struct {
+    volatile uint32_t PCR[32];
+    volatile uint32_t ISFR;
+} PORT_Type;
+
+typedef struct {
+    volatile uint32_t PDOR, PSOR, PCOR, PTOR, PDIR, PDDR;
+} GPIO_Type;
+
+typedef struct {
+    volatile uint32_t SC1[2], CFG1, CFG2, R[2], CV1, CV2, SC2, SC3, OFS, PG, MG;
+    volatile uint32_t CLPD, CLPS, CLP4, CLP3, CLP2, CLP1, CLP0;
+} ADC_Type;
+
+typedef struct {
+    volatile uint32_t MCR;
+    struct {
+        volatile uint32_t LDVAL, CVAL, TCTRL, TFLG;
+    } CHANNEL[2];
+} PIT_Type;
+
+typedef struct {
+    volatile uint8_t A1, F, C1, S, D, C2, FLT, RA, SMB, A2, SLTH, SLTL;
+} I2C_Type;
+
+typedef struct {
+    volatile uint32_t CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+typedef struct {
+    struct {
+        volatile uint32_t SAR, DAR, DSR_BCR, DCR;
+    } DMA[4];
+} DMA_Type;
+
+typedef struct {
+    volatile uint8_t CHCFG[4];
+} DMAMUX_Type;
+
+extern SIM_Type *SIM;
+extern PORT_Type *PORTA, *PORTB, *PORTC;
+extern GPIO_Type *PTA, *PTB, *PTC;
+extern ADC_Type *ADC0;
+extern PIT_Type *PIT;
+extern I2C_Type *I2C0;
+extern SysTick_Type *SysTick;
+extern DMA_Type *DMA0;
+extern DMAMUX_Type *DMAMUX0;
+
+#ifdef I2C_MODEL
+/* tests with a model of I2C0 see every write of its flag and data registers
+   (I2C_WRITE in i2c.c) */
+void I2C_ModelWrite(volatile uint8_t *reg, uint8_t value);
+#define I2C_WRITE(reg, value)          I2C_ModelWrite(&I2C0->reg, (uint8_t)(value))
+#endif
+
+/******************************************************************************
+ * Bits
+ ******************************************************************************/
+
+#define SIM_SCGC4_I2C0_MASK            0x40u
+#define SIM_SCGC5_PORTA_MASK           0x200u
+#define SIM_SCGC5_PORTB_MASK           0x400u
+#define SIM_SCGC5_PORTC_MASK           0x800u
+#define SIM_SCGC6_DMAMUX_MASK          0x2u
+#define SIM_SCGC6_PIT_MASK             0x800000u
+#define SIM_SCGC6_ADC0_MASK            0x8000000u
+#define SIM_SCGC7_DMA_MASK             0x100u
+#define SIM_SOPT7_ADC0ALTTRGEN_MASK    0x80u
+#define SIM_SOPT7_ADC0TRGSEL(x)        ((uint32_t)(x) & 0xFu)
+
+#define PORT_PCR_PS_MASK               0x1u
+#define PORT_PCR_PE_MASK               0x2u
+#define PORT_PCR_MUX(x)                (((uint32_t)(x) & 0x7u) << 8)
+#define PORT_PCR_IRQC(x)               (((uint32_t)(x) & 0xFu) << 16)
+#define PORT_PCR_ISF_MASK              0x1000000u
+
+#define ADC_SC1_ADCH(x)                ((uint32_t)(x) & 0x1Fu)
+#define ADC_SC1_AIEN_MASK              0x40u
+#define ADC_SC1_COCO_MASK              0x80u
+#define ADC_CFG1_ADICLK(x)             ((uint32_t)(x) & 0x3u)
+#define ADC_CFG1_MODE(x)               (((uint32_t)(x) & 0x3u) << 2)
+#define ADC_CFG1_ADLSMP_MASK           0x10u
+#define ADC_CFG1_ADIV(x)               (((uint32_t)(x) & 0x3u) << 5)
+#define ADC_CFG2_ADHSC_MASK            0x4u
+#define ADC_SC2_DMAEN_MASK             0x4u
+#define ADC_SC2_ADTRG_MASK             0x40u
+#define ADC_SC3_AVGS(x)                ((uint32_t)(x) & 0x3u)
+#define ADC_SC3_AVGE_MASK              0x4u
+#define ADC_SC3_CALF_MASK              0x40u
+#define ADC_SC3_CAL_MASK               0x80u
+#define ADC_PG_PG(x)                   ((uint32_t)(x) & 0xFFFFu)
+
+#define PIT_MCR_FRZ_MASK               0x1u
+#define PIT_MCR_MDIS_MASK              0x2u
+#define PIT_LDVAL_TSV(x)               ((uint32_t)(x))
+#define PIT_TCTRL_TEN_MASK             0x1u
+#define PIT_TCTRL_TIE_MASK             0x2u
+#define PIT_TCTRL_CHN_MASK             0x4u
+#define PIT_TFLG_TIF_MASK              0x1u
+
+#define I2C_F_ICR(x)                   ((uint8_t)((x) & 0x3Fu))
+#define I2C_F_MULT(x)                  ((uint8_t)(((x) & 0x3u) << 6))
+#define I2C_C1_RSTA_MASK               0x4u
+#define I2C_C1_TXAK_MASK               0x8u
+#define I2C_C1_TX_MASK                 0x10u
+#define I2C_C1_MST_MASK                0x20u
+#define I2C_C1_IICIE_MASK              0x40u
+#define I2C_C1_IICEN_MASK              0x80u
+#define I2C_S_RXAK_MASK                0x1u
+#define I2C_S_IICIF_MASK               0x2u
+#define I2C_S_ARBL_MASK                0x10u
+#define I2C_S_BUSY_MASK                0x20u
+#define I2C_S_TCF_MASK                 0x80u
+#define I2C_FLT_STOPIE_MASK            0x20u
+#define I2C_FLT_STOPF_MASK             0x40u
+
+#define SysTick_CTRL_ENABLE_Msk        0x1u
+#define SysTick_CTRL_TICKINT_Msk       0x2u
+#define SysTick_CTRL_CLKSOURCE_Msk     0x4u
+#define SysTick_LOAD_RELOAD_Msk        0xFFFFFFu
+
+#define DMA_DSR_BCR_BCR(x)             ((uint32_t)(x) & 0xFFFFFu)
+#define DMA_DSR_BCR_BCR_MASK           0xFFFFFu
+#define DMA_DSR_BCR_DONE_MASK          0x1000000u
+#define DMA_DSR_BCR_BED_MASK           0x10000000u
+#define DMA_DSR_BCR_BES_MASK           0x20000000u
+#define DMA_DSR_BCR_CE_MASK            0x40000000u
+#define DMA_DCR_D_REQ_MASK             0x80u
+#define DMA_DCR_DSIZE(x)               (((uint32_t)(x) & 0x3u) << 17)
+#define DMA_DCR_DINC_MASK              0x80000u
+#define DMA_DCR_SSIZE(x)               (((uint32_t)(x) & 0x3u) << 20)
+#define DMA_DCR_CS_MASK                0x20000000u
+#define DMA_DCR_ERQ_MASK               0x40000000u
+#define DMA_DCR_EINT_MASK              0x80000000u
+
+#define DMAMUX_CHCFG_SOURCE(x)         ((uint8_t)((x) & 0x3Fu))
+#define DMAMUX_CHCFG_ENBL_MASK         0x80u
+
+#endif /* MKL25Z4_H */
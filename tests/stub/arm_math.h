@@ -0,0 +1,39 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   arm_math.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host replacement of CMSIS-DSP: types and declarations used by the
+ *         project headers. The Q15 and float16_t real FFTs used by fft.c
+ *         have host stand-ins in arm_rfft.c, other transforms are not 
+ *         available.
+ * @ver    0.1
+ */
+
+#ifndef ARM_MATH_H
+#define ARM_MATH_H
+
+#include <stdint.h>
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+typedef float   float32_t;
+
+typedef enum {
+    ARM_MATH_SUCCESS        =  0,
+    ARM_MATH_ARGUMENT_ERROR = -1
+} arm_status;
+
+typedef struct {
+    uint32_t fftLenReal;
+} arm_rfft_instance_q15;
+
+arm_status arm_rfft_init_q15(arm_rfft_instance_q15 *S, uint32_t fftLenReal, 
+                             uint32_t ifftFlagR, uint32_t bitReverseFlag);
+void arm_rfft_q15(const arm_rfft_instance_q15 *S, q15_t *pSrc, q15_t *pDst);
+
+#endif /* ARM_MATH_H */
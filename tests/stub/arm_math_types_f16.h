@@ -0,0 +1,19 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   arm_math_types_f16.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host replacement of CMSIS-DSP half precision type.
+ * @ver    0.1
+ */
+
+#ifndef ARM_MATH_TYPES_F16_H
+#define ARM_MATH_TYPES_F16_H
+
+/* same range is not needed on the host, only the type name */
+typedef float float16_t;
+
+#endif /* ARM_MATH_TYPES_F16_H */
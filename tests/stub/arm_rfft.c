@@ -0,0 +1,172 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   arm_rfft.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host stand-in for the Q15 and float16_t real FFTs of CMSIS-DSP: a 
+ *         plain radix-2 transform in double with the same output layout and
+ *         scaling (Q15: 1/fftLenReal, bins 0 to fftLenReal/2 as 
+ *         real/imaginary pairs; float16_t: not scaled, bins 1 to 
+ *         fftLenReal/2-1 as pairs, real DC and Nyquist bins first).
+ *         Results are close to CMSIS, its timing is not.
+ * @ver    0.1
+ */
+
+#include <math.h>
+#include "arm_math.h"
+#include "dsp/transform_functions_f16.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* largest transform */
+#define RFFT_MAX_SIZE            (4096)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* input and output of rfft_double */
+static double re[RFFT_MAX_SIZE], im[RFFT_MAX_SIZE];
+/* twiddle factors exp(-2*pi*i*k/n) of the last size */
+static double twiddleRe[RFFT_MAX_SIZE/2], twiddleIm[RFFT_MAX_SIZE/2];
+static uint32_t twiddleSize = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static arm_status rfft_check(uint32_t n);
+static void rfft_double(uint32_t n);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Initialize instance, only forward transforms of a power of 2.
+ * @param[in] Instance
+ * @param[in] Number of real samples
+ * @param[in] 0 - forward transform
+ * @param[in] Not used (output is always in normal order)
+ * @return    ARM_MATH_SUCCESS or ARM_MATH_ARGUMENT_ERROR
+ */
+arm_status arm_rfft_init_q15(arm_rfft_instance_q15 *S, uint32_t fftLenReal, 
+                             uint32_t ifftFlagR, uint32_t bitReverseFlag) {
+    if( ifftFlagR )
+        return ARM_MATH_ARGUMENT_ERROR;
+    
+    S->fftLenReal = fftLenReal;
+    return rfft_check(fftLenReal);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Real FFT of Q15 samples.
+ * @param[in]  Instance
+ * @param[in]  fftLenReal samples
+ * @param[out] 2*fftLenReal values, bins 0 to fftLenReal/2 are filled
+ */
+void arm_rfft_q15(const arm_rfft_instance_q15 *S, q15_t *pSrc, q15_t *pDst) {
+    uint32_t n = S->fftLenReal;
+    
+    for( uint32_t i=0; i<n; i++ )
+        re[i] = pSrc[i];
+    rfft_double(n);
+    
+    for( uint32_t k=0; k<=n/2; k++ ) {
+        pDst[2*k]   = (q15_t)lround(re[k]/n);
+        pDst[2*k+1] = (q15_t)lround(im[k]/n);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Initialize instance of the float16_t real FFT.
+ * @param[in] Instance
+ * @param[in] Number of real samples
+ * @return    ARM_MATH_SUCCESS or ARM_MATH_ARGUMENT_ERROR
+ */
+arm_status arm_rfft_fast_init_f16(arm_rfft_fast_instance_f16 *S, uint16_t fftLen) {
+    S->fftLenRFFT = fftLen;
+    return rfft_check(fftLen);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Real FFT of float16_t samples, only forward.
+ * @param[in]  Instance
+ * @param[in]  fftLenRFFT samples
+ * @param[out] fftLenRFFT values: DC, Nyquist, then bins 1 to fftLenRFFT/2-1
+ *             as real/imaginary pairs
+ * @param[in]  0 - forward transform
+ */
+void arm_rfft_fast_f16(const arm_rfft_fast_instance_f16 *S, float16_t *p, 
+                       float16_t *pOut, uint8_t ifftFlag) {
+    uint32_t n = S->fftLenRFFT;
+    
+    for( uint32_t i=0; i<n; i++ )
+        re[i] = p[i];
+    rfft_double(n);
+    
+    pOut[0] = (float16_t)re[0];
+    pOut[1] = (float16_t)re[n/2];
+    for( uint32_t k=1; k<n/2; k++ ) {
+        pOut[2*k]   = (float16_t)re[k];
+        pOut[2*k+1] = (float16_t)im[k];
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Check the size of a transform.
+ * @param[in] Number of real samples
+ * @return    ARM_MATH_SUCCESS or ARM_MATH_ARGUMENT_ERROR
+ */
+static arm_status rfft_check(uint32_t n) {
+    if( n < 2 || n > RFFT_MAX_SIZE || (n & (n-1)) )
+        return ARM_MATH_ARGUMENT_ERROR;
+    return ARM_MATH_SUCCESS;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Complex FFT of n real values in re, result in re and im.
+ * @param[in] Number of values, power of 2
+ */
+static void rfft_double(uint32_t n) {
+    if( twiddleSize != n ) {
+        for( uint32_t k=0; k<n/2; k++ ) {
+            twiddleRe[k] = cos(-2*M_PI*k/n);
+            twiddleIm[k] = sin(-2*M_PI*k/n);
+        }
+        twiddleSize = n;
+    }
+    
+    /* bit reversed order */
+    for( uint32_t i=0, j=0; i<n; i++ ) {
+        if( i < j ) {
+            double t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+        }
+        im[i] = 0;
+        for( uint32_t bit=n>>1; (j ^= bit) < bit; bit >>= 1 )
+            ;
+    }
+    
+    /* butterflies */
+    for( uint32_t len=2; len<=n; len<<=1 ) {
+        for( uint32_t k=0; k<n; k+=len ) {
+            for( uint32_t m=0; m<len/2; m++ ) {
+                double wr = twiddleRe[m*(n/len)], wi = twiddleIm[m*(n/len)];
+                double xr = re[k+m+len/2]*wr - im[k+m+len/2]*wi;
+                double xi = re[k+m+len/2]*wi + im[k+m+len/2]*wr;
+                
+                re[k+m+len/2] = re[k+m] - xr;
+                im[k+m+len/2] = im[k+m] - xi;
+                re[k+m] += xr;
+                im[k+m] += xi;
+            }
+        }
+    }
+}
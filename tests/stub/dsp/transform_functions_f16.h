@@ -0,0 +1,27 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   transform_functions_f16.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host replacement of CMSIS-DSP half precision transforms.
+ * @ver    0.1
+ */
+
+#ifndef TRANSFORM_FUNCTIONS_F16_H
+#define TRANSFORM_FUNCTIONS_F16_H
+
+#include "arm_math.h"
+#include "arm_math_types_f16.h"
+
+typedef struct {
+    uint16_t fftLenRFFT;
+} arm_rfft_fast_instance_f16;
+
+arm_status arm_rfft_fast_init_f16(arm_rfft_fast_instance_f16 *S, uint16_t fftLen);
+void arm_rfft_fast_f16(const arm_rfft_fast_instance_f16 *S, float16_t *p, 
+                       float16_t *pOut, uint8_t ifftFlag);
+
+#endif /* TRANSFORM_FUNCTIONS_F16_H */
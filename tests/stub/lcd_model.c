@@ -0,0 +1,433 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   lcd_model.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host model of the LCD behind the PCF8574 expander (lcd_model.h).
+ *         A transaction started while the bus is busy begins when the
+ *         previous one ends; as in i2c.c the caller waits while I2C_TX_QUEUE
+ *         transactions or I2C_TX_BUFFER bytes are not finished. The LCD 
+ *         latches a nibble on the falling edge of EN, at the end of the 
+ *         expander byte.
+ * @ver    0.1
+ */
+
+#include "lcd_model.h"
+#include "i2c.h"
+#include "timer.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* core clock cycles of one SCL period */
+#define MODEL_BIT_CYCLES         (TIMER_CLOCK_HZ/LCD_MODEL_SCL_HZ)
+/* bits of a byte with acknowledge, START and STOP take about a bit each */
+#define MODEL_BYTE_BITS          (9)
+
+/* HD44780 execution times (datasheet, fosc = 270 kHz), core clock cycles */
+#define MODEL_US(x)              ((uint64_t)(x)*(TIMER_CLOCK_HZ/1000000))
+#define MODEL_POWERON            MODEL_US(15000)  /* from the start of the model */
+#define MODEL_RESET1             MODEL_US(4100)   /* first nibble of 8-bit mode */
+#define MODEL_RESET2             MODEL_US(100)    /* second nibble of 8-bit mode */
+#define MODEL_EXEC               MODEL_US(37)     /* other instructions, data */
+#define MODEL_CLEAR              MODEL_US(1520)   /* clear display, return home */
+
+/* PCF8574 connections to LCD, the same as in lcd1602.c */
+#define MODEL_EN                 (0x04)
+#define MODEL_RS                 (0x01)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static LcdModelCounters model_counters;
+static uint64_t model_now = 0;
+/* end of the last transaction on the bus */
+static uint64_t model_busEnd = 0;
+/* ends and sizes of the last I2C_TX_QUEUE transactions (queue of i2c.c) */
+static uint64_t model_ends[I2C_TX_QUEUE];
+static uint8_t model_sizes[I2C_TX_QUEUE];
+static uint8_t model_head = 0;
+/* every expander byte in its own transaction (LCD_MODEL_SingleBytes) */
+static uint8_t model_single = 0;
+
+/* expander outputs and HD44780 state: interface width, nibble waiting for
+   its pair, address counter pointing to CGRAM or DDRAM */
+static uint8_t model_outputs = 0;
+static uint8_t model_4bit = 0;
+static uint8_t model_nibble = 0;
+static uint8_t model_haveNibble = 0;
+static uint8_t model_cgram = 0;
+static uint8_t model_address = 0;
+static char model_ddram[128];
+/* nibbles latched in 8-bit mode, end of the byte on the bus being decoded
+   and end of the execution of the last instruction */
+static uint8_t model_resets = 0;
+static uint64_t model_latch = 0;
+static uint64_t model_ready = MODEL_POWERON;
+static uint8_t model_cgramRows[64];
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void model_tick(uint64_t cycles);
+static void model_transaction(uint8_t address, uint8_t size, const uint8_t *data);
+static void model_expander(uint8_t value);
+static void model_execute(uint8_t data, uint8_t rs);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief Clear the counters, the content of the LCD is kept.
+ */
+void LCD_MODEL_Reset(void) {
+    LcdModelCounters empty = {0};
+    
+    model_counters = empty;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Counters since LCD_MODEL_Reset.
+ * @param[out] Counters
+ */
+void LCD_MODEL_Get(LcdModelCounters *counters) {
+    *counters = model_counters;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Model time.
+ * @return Core clock cycles since the start
+ */
+uint64_t LCD_MODEL_Now(void) {
+    return model_now;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  End of the last transaction on the bus.
+ * @return Core clock cycles since the start
+ */
+uint64_t LCD_MODEL_BusFree(void) {
+    return model_busEnd;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Let the time pass while the CPU does other work.
+ * @param[in] Core clock cycles
+ */
+void LCD_MODEL_Tick(uint64_t cycles) {
+    model_tick(cycles);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Send blocks as the old path did: every expander byte in its own
+ *            transaction (PCF8574_Write -> I2C_Write) and the caller waits.
+ * @param[in] 1 - single bytes, 0 - blocks
+ */
+void LCD_MODEL_SingleBytes(uint8_t on) {
+    model_single = on;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Character shown by the LCD.
+ * @param[in] Column
+ * @param[in] Row
+ * @return    Character code in DDRAM
+ */
+char LCD_MODEL_Char(uint8_t col, uint8_t row) {
+    return model_ddram[(row ? 0x40 : 0x00) + col];
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Pixels of a character: custom ones from CGRAM, space and the
+ *             full block (0xFF) from the ROM.
+ * @param[in]  Character code
+ * @param[out] Eight rows of pixels, top row first
+ * @return     1 if the character is known, 0 otherwise
+ */
+uint8_t LCD_MODEL_Rows(char ch, uint8_t *rows) {
+    uint8_t code = (uint8_t)ch;
+    
+    for( uint8_t i=0; i<8; i++ ) {
+        if( code < 16 )
+            rows[i] = model_cgramRows[(code & 0x07)*8 + i];
+        else if( code == ' ' )
+            rows[i] = 0x00;
+        else if( code == 0xFF )
+            rows[i] = 0x1F;
+        else
+            return 0;
+    }
+    return 1;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief I2C initialization, nothing to do.
+ */
+void I2C_Init(void) {
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Write one byte and wait until it is transmitted.
+ * @param[in] Address of slave
+ * @param[in] Data to write
+ * @return    Errors: no ACK from other addresses than LCD_MODEL_ADDRESS
+ */
+uint8_t I2C_Write(uint8_t address, uint8_t data) {
+    I2C_Wait();
+    model_transaction(address, 1, &data);
+    I2C_Wait();
+    return address == LCD_MODEL_ADDRESS ? 0 : I2C_ERR_NOACK;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief        Read one byte, the expander inputs are not modelled.
+ * @param[in]    Address of slave
+ * @param[inout] Data from slave: 0
+ * @return       Errors
+ */
+uint8_t I2C_Read(uint8_t address, uint8_t *data) {
+    *data = 0;
+    return address == LCD_MODEL_ADDRESS ? 0 : I2C_ERR_NOACK;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Write a block in the background: it starts when the bus is free
+ *            and the caller goes on at once, unless the queue of i2c.c is 
+ *            full; then it waits until enough transactions are finished.
+ * @param[in] Address of slave
+ * @param[in] Count of bytes
+ * @param[in] Data to write
+ * @param[in] Function called when transaction is finished (or 0)
+ * @return    Errors: none
+ */
+uint8_t I2C_WriteBlockAsync(uint8_t address, uint8_t size, uint8_t *data, I2C_Callback done) {
+    if( model_single ) {
+        for( uint8_t i=0; i<size; i++ )
+            I2C_Write(address, data[i]);
+        if( done )
+            done(0);
+        return 0;
+    }
+    
+    for( ;; ) {
+        uint64_t next = 0;
+        uint16_t bytes = 0;
+        uint8_t count = 0;
+        
+        /* transactions are in the queue until they are finished */
+        for( uint8_t i=0; i<I2C_TX_QUEUE; i++ ) {
+            if( model_ends[i] <= model_now )
+                continue;
+            count++;
+            bytes += model_sizes[i];
+            if( next == 0 || model_ends[i] < next )
+                next = model_ends[i];
+        }
+        if( count < I2C_TX_QUEUE && bytes <= I2C_TX_BUFFER - size )
+            break;
+        model_counters.waitCycles += next - model_now;
+        model_tick(next - model_now);
+    }
+    
+    model_transaction(address, size, data);
+    model_ends[model_head] = model_busEnd;
+    model_sizes[model_head] = size;
+    model_head = (uint8_t)((model_head + 1) % I2C_TX_QUEUE);
+    if( done )
+        done(0);
+    return 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Wait until all transactions are finished.
+ */
+void I2C_Wait(void) {
+    if( model_now < model_busEnd )
+        model_tick(model_busEnd - model_now);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Check if transactions are in progress, the check takes a few 
+ *         cycles.
+ * @return 1 if transmitting, 0 otherwise
+ */
+uint8_t I2C_IsBusy(void) {
+    model_tick(LCD_MODEL_POLL_CYCLES);
+    return model_now < model_busEnd;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Start the SysTick stub, it is advanced by the model.
+ */
+void TIMER_Init(void) {
+    SysTick->LOAD = TIMER_MASK;
+    SysTick->VAL  = TIMER_MASK;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Current value of the cycle counter, every read takes a few cycles,
+ *         so waiting loops end.
+ * @return Counter value, counts up from 0 to TIMER_MASK
+ */
+uint32_t TIMER_Now(void) {
+    model_tick(LCD_MODEL_POLL_CYCLES);
+    return TIMER_MASK - SysTick->VAL;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Number of cycles since the given point in time.
+ * @param[in] Counter value returned by TIMER_Now
+ * @return    Elapsed cycles (valid below TIMER_MASK)
+ */
+uint32_t TIMER_Elapsed(uint32_t start) {
+    return (TIMER_Now() - start) & TIMER_MASK;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Let the time pass, SysTick counts down.
+ * @param[in] Core clock cycles
+ */
+static void model_tick(uint64_t cycles) {
+    model_now += cycles;
+    SysTick->VAL = (uint32_t)(TIMER_MASK - (model_now & TIMER_MASK));
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Put a write transaction on the bus after the previous one, bytes
+ *            reach the expander one by one. The caller does not wait.
+ * @param[in] Address of slave
+ * @param[in] Count of bytes
+ * @param[in] Bytes
+ */
+static void model_transaction(uint8_t address, uint8_t size, const uint8_t *data) {
+    uint64_t start = model_busEnd > model_now ? model_busEnd : model_now;
+    uint64_t bits = 1 + MODEL_BYTE_BITS;
+    
+    model_counters.starts++;
+    model_counters.addressBytes++;
+    for( uint8_t i=0; i<size && address == LCD_MODEL_ADDRESS; i++ ) {
+        bits += MODEL_BYTE_BITS;
+        model_counters.dataBytes++;
+        model_latch = start + bits*MODEL_BIT_CYCLES;
+        model_expander(data[i]);
+    }
+    bits++;
+    model_counters.stops++;
+    
+    model_busEnd = start + bits*MODEL_BIT_CYCLES;
+    model_counters.busCycles += bits*MODEL_BIT_CYCLES;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     New state of the expander outputs, a nibble is latched when EN
+ *            goes low. After reset the LCD has 8-bit interface and a nibble
+ *            is a whole instruction (lower data lines are not connected).
+ *            The first nibble of an instruction latched before the previous
+ *            one is executed is counted as an early write.
+ * @param[in] Expander byte
+ */
+static void model_expander(uint8_t value) {
+    uint8_t falling = (model_outputs & MODEL_EN) && !(value & MODEL_EN);
+    uint8_t nibble = model_outputs >> 4;
+    uint8_t rs = model_outputs & MODEL_RS;
+    
+    model_outputs = value;
+    if( !falling )
+        return;
+    
+    if( !model_haveNibble && model_latch < model_ready )
+        model_counters.earlyWrites++;
+    if( !model_4bit ) {
+        model_execute((uint8_t)(nibble << 4), rs);
+        return;
+    }
+    if( !model_haveNibble ) {
+        model_nibble = nibble;
+        model_haveNibble = 1;
+        return;
+    }
+    model_haveNibble = 0;
+    model_execute((uint8_t)((model_nibble << 4) | nibble), rs);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Execute an instruction or write a character (address counter is
+ *            incremented, the second line follows the first one), the LCD is
+ *            busy for the execution time.
+ * @param[in] Data
+ * @param[in] Register select
+ */
+static void model_execute(uint8_t data, uint8_t rs) {
+    uint64_t exec = MODEL_EXEC;
+    
+    /* reset by instruction: 4.1 ms after the first 8-bit nibble, 100 us 
+       after the second one */
+    if( !model_4bit && !rs ) {
+        if( model_resets == 0 )
+            exec = MODEL_RESET1;
+        else if( model_resets == 1 )
+            exec = MODEL_RESET2;
+        if( model_resets < 2 )
+            model_resets++;
+    }
+    if( !rs && (data & 0xFE) <= 0x02 && data != 0x00 )
+        exec = MODEL_CLEAR;
+    model_ready = model_latch + exec;
+    
+    if( rs ) {
+        if( model_cgram ) {
+            model_cgramRows[model_address] = data & 0x1F;
+            model_address = (model_address + 1) & 0x3F;
+            model_counters.cgramWrites++;
+            return;
+        }
+        model_ddram[model_address & 0x7F] = (char)data;
+        if( model_address == 0x27 )
+            model_address = 0x40;
+        else if( model_address == 0x67 )
+            model_address = 0x00;
+        else
+            model_address++;
+        model_counters.ddramWrites++;
+        return;
+    }
+    
+    model_counters.instructions++;
+    if( data & 0x80 ) {
+        model_cgram = 0;
+        model_address = data & 0x7F;
+    }
+    else if( data & 0x40 ) {
+        model_cgram = 1;
+        model_address = data & 0x3F;
+    }
+    else if( data & 0x20 ) {
+        /* function set, DL 0 - 4-bit interface, DL 1 - 8-bit interface 
+           (two 0x3 nibbles in 4-bit mode start the reset again) */
+        if( !(data & 0x10) ) {
+            model_4bit = 1;
+            model_haveNibble = 0;
+        }
+        else if( model_4bit ) {
+            model_4bit = 0;
+            model_resets = 1;
+        }
+    }
+    else if( data == 0x01 ) {
+        for( uint8_t i=0; i<sizeof(model_ddram); i++ )
+            model_ddram[i] = ' ';
+        model_cgram = 0;
+        model_address = 0;
+    }
+    else if( (data & 0xFE) == 0x02 ) {
+        model_cgram = 0;
+        model_address = 0;
+    }
+}
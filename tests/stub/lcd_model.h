@@ -0,0 +1,113 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   lcd_model.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host model of the LCD behind the PCF8574 expander: replaces i2c.c
+ *         (transactions take the bus time of their bytes at LCD_MODEL_SCL_HZ,
+ *         a full queue makes the caller wait)
+ *         and timer.c (SysTick stub advanced by the model), and decodes the
+ *         expander bytes into HD44780 instructions and writes to DDRAM and
+ *         CGRAM with their execution times, so lcd1602.c can be tested as it
+ *         is.
+ * @ver    0.1
+ */
+
+#ifndef LCD_MODEL_H
+#define LCD_MODEL_H
+
+#include <stdint.h>
+
+/******************************************************************************
+ * Global definitions
+ ******************************************************************************/
+
+/* SCL of I2C0: 24 MHz bus clock, MULT 2, SCL divider 128 (i2c.c) */
+#define LCD_MODEL_SCL_HZ         (93750)
+/* core clock cycles taken by one read of the cycle counter in a loop */
+#define LCD_MODEL_POLL_CYCLES    (8)
+/* address of the expander, the other one does not answer */
+#define LCD_MODEL_ADDRESS        (0x27)
+
+/******************************************************************************
+ * Global structs
+ ******************************************************************************/
+
+/**
+ * @brief counters of the bus and the LCD since LCD_MODEL_Reset
+ */
+typedef struct {
+    uint32_t starts;          /* START conditions (transactions) */
+    uint32_t stops;           /* STOP conditions */
+    uint32_t addressBytes;    /* address bytes */
+    uint32_t dataBytes;       /* expander bytes */
+    uint64_t busCycles;       /* core clock cycles with SCL running */
+    uint32_t instructions;    /* LCD instructions (RS 0) */
+    uint32_t ddramWrites;     /* characters written to DDRAM */
+    uint32_t cgramWrites;     /* pixel rows written to CGRAM */
+    uint64_t waitCycles;      /* core clock cycles waiting for the I2C queue */
+    uint32_t earlyWrites;     /* instructions and characters latched before
+                                 the previous instruction was executed */
+} LcdModelCounters;
+
+/******************************************************************************
+ * Function declarations
+ ******************************************************************************/
+
+/**
+ * @brief Clear the counters, the content of the LCD is kept.
+ */
+void LCD_MODEL_Reset(void);
+
+/**
+ * @brief      Counters since LCD_MODEL_Reset.
+ * @param[out] Counters
+ */
+void LCD_MODEL_Get(LcdModelCounters *counters);
+
+/**
+ * @brief  Model time.
+ * @return Core clock cycles since the start
+ */
+uint64_t LCD_MODEL_Now(void);
+
+/**
+ * @brief  End of the last transaction on the bus.
+ * @return Core clock cycles since the start
+ */
+uint64_t LCD_MODEL_BusFree(void);
+
+/**
+ * @brief     Let the time pass while the CPU does other work.
+ * @param[in] Core clock cycles
+ */
+void LCD_MODEL_Tick(uint64_t cycles);
+
+/**
+ * @brief     Send blocks as the old path did: every expander byte in its own
+ *            transaction (PCF8574_Write -> I2C_Write) and the caller waits.
+ * @param[in] 1 - single bytes, 0 - blocks
+ */
+void LCD_MODEL_SingleBytes(uint8_t on);
+
+/**
+ * @brief     Character shown by the LCD.
+ * @param[in] Column
+ * @param[in] Row
+ * @return    Character code in DDRAM
+ */
+char LCD_MODEL_Char(uint8_t col, uint8_t row);
+
+/**
+ * @brief      Pixels of a character: custom ones from CGRAM, space and the
+ *             full block (0xFF) from the ROM.
+ * @param[in]  Character code
+ * @param[out] Eight rows of pixels, top row first
+ * @return     1 if the character is known, 0 otherwise
+ */
+uint8_t LCD_MODEL_Rows(char ch, uint8_t *rows);
+
+#endif /* LCD_MODEL_H */
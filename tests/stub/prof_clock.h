@@ -0,0 +1,42 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   prof_clock.h
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host clock backend of the profiler (prof.h), included before every
+ *         source of a host build: durations are in nanoseconds.
+ * @ver    0.1
+ */
+
+#ifndef PROF_CLOCK_H
+#define PROF_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+/******************************************************************************
+ * Global definitions
+ ******************************************************************************/
+
+#define PROF_CLOCK()             PROF_HostClock()
+#define PROF_ELAPSED(t)          (PROF_HostClock() - (t))
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**
+ * @brief  Monotonic host clock, wraps around like the SysTick counter.
+ * @return Time in nanoseconds
+ */
+static inline uint32_t PROF_HostClock(void) {
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec*1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+#endif /* PROF_CLOCK_H */
@@ -0,0 +1,229 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_adc_dma.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the DMA capture (ADC_USE_DMA): a register model of
+ *         ADC0, DMAMUX and DMA0 channel 0 moves conversions to the address 
+ *         set by ADC.c and raises DMA0 interrupt at the end of a block. The 
+ *         test checks the channel setup, completion events, alternation of 
+ *         the two blocks and that every sample reaches the queue in order.
+ *         Built with -no-pie, so 32-bit DMA addresses are host pointers.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "ADC.h"
+#include "queue.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* blocks moved in each mode */
+#define TEST_BLOCKS              (64)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Global variable definitions (normally in fft.c)
+ ******************************************************************************/
+
+fft_capture_t FFT_Buffer[FFT_BUFFERS][FFT_HOP_SIZE];
+FFT_Flags FFTstatus;
+const FFT_ModeInfo FFT_Modes[FFT_MODES+1] = {
+    {0, 1, 0}, {0, 1, 1}, {2, 4, 2}, {1, 2, 33},
+    {0, 1, 33}, {0, 1, 49}, {0, 1, 65}, {0, 1, 81}, {0, 1, 97}
+};
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static uint32_t test_failed = 0;
+/* DMA0 interrupts and restarts on the lower/upper block */
+static uint32_t test_irqs = 0;
+static uint32_t test_blockStarts[2] = {0, 0};
+/* conversions which came with the DMA request disabled */
+static uint32_t test_lost = 0;
+/* reference of DC removal in ADC.c */
+static int32_t test_dc = (int32_t)FFT_AVG_VALUE << ADC_DC_SHIFT;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+void DMA0_IRQHandler(void);
+static void *test_calibration(void *arg);
+static void test_convert(uint16_t value);
+static uint32_t test_run(uint8_t mode);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Interrupt duration reported by ADC.c, called once per DMA0 
+ *            interrupt (completion event).
+ * @param[in] Cycles
+ */
+void DIAG_IsrCycles(uint32_t cycles) {
+    test_irqs++;
+}
+
+int main(void) {
+    pthread_t adc;
+    uint32_t checked;
+    
+    /* calibration bit is cleared by "hardware" */
+    pthread_create(&adc, NULL, test_calibration, NULL);
+    FFTstatus.mode = 1;
+    TEST_CHECK(ADC_Init() == 0);
+    pthread_join(adc, NULL);
+    
+    /* conversion complete requests DMA which reads the result register */
+    TEST_CHECK(ADC0->SC2 & ADC_SC2_DMAEN_MASK);
+    TEST_CHECK(DMAMUX0->CHCFG[0] == (DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_SOURCE(ADC_DMAMUX_SOURCE)));
+    TEST_CHECK(DMA0->DMA[0].SAR == (uint32_t)(uintptr_t)&ADC0->R[0]);
+    TEST_CHECK((DMA0->DMA[0].DCR & (DMA_DCR_EINT_MASK | DMA_DCR_CS_MASK | DMA_DCR_DINC_MASK
+                                    | DMA_DCR_D_REQ_MASK)) 
+               == (DMA_DCR_EINT_MASK | DMA_DCR_CS_MASK | DMA_DCR_DINC_MASK | DMA_DCR_D_REQ_MASK));
+    TEST_CHECK((DMA0->DMA[0].DCR & (DMA_DCR_SSIZE(3) | DMA_DCR_DSIZE(3))) 
+               == (DMA_DCR_SSIZE(2) | DMA_DCR_DSIZE(2)));
+    
+    ADC_Start();
+    TEST_CHECK(DMA0->DMA[0].DCR & DMA_DCR_ERQ_MASK);
+    TEST_CHECK((DMA0->DMA[0].DSR_BCR & DMA_DSR_BCR_BCR_MASK) == ADC_DMA_BLOCK*sizeof(uint16_t));
+    TEST_CHECK(!(ADC0->SC1[0] & ADC_SC1_AIEN_MASK));
+    
+    /* full rate and both decimated rates */
+    checked  = test_run(1);
+    checked += test_run(2);
+    checked += test_run(3);
+    
+    TEST_CHECK(test_irqs == 3*TEST_BLOCKS);
+    TEST_CHECK(test_lost == 0);
+    TEST_CHECK(test_blockStarts[0] != 0 && test_blockStarts[1] != 0 
+               && test_blockStarts[0] == test_blockStarts[1]);
+    TEST_CHECK(QUEUE_GetOverruns() == 0 && QUEUE_GetDroppedFrames() == 0);
+    
+    printf("test_adc_dma: %lu interrupts, %lu/%lu block starts, %lu samples "
+           "checked, %lu lost, %lu failed\n", (unsigned long)test_irqs, 
+           (unsigned long)test_blockStarts[0], (unsigned long)test_blockStarts[1],
+           (unsigned long)checked, (unsigned long)test_lost, (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     ADC0 calibration: CAL bit is cleared when it has been set.
+ * @param[in] Not used
+ * @return    NULL
+ */
+static void *test_calibration(void *arg) {
+    while( !(ADC0->SC3 & ADC_SC3_CAL_MASK) )
+        ;
+    ADC0->SC3 &= ~ADC_SC3_CAL_MASK;
+    return NULL;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     One conversion triggered by PIT0: result is moved by DMA0 
+ *            channel 0 (16-bit transfer, incremented destination), the end
+ *            of a block disables the request and raises the interrupt.
+ * @param[in] Conversion result
+ */
+static void test_convert(uint16_t value) {
+    uint32_t bcr;
+    
+    ADC0->R[0] = value;
+    if( !(DMA0->DMA[0].DCR & DMA_DCR_ERQ_MASK) || !(DMAMUX0->CHCFG[0] & DMAMUX_CHCFG_ENBL_MASK) ) {
+        test_lost++;
+        return;
+    }
+    
+    *(uint16_t *)(uintptr_t)DMA0->DMA[0].DAR = (uint16_t)ADC0->R[0];
+    DMA0->DMA[0].DAR += sizeof(uint16_t);
+    bcr = (DMA0->DMA[0].DSR_BCR & DMA_DSR_BCR_BCR_MASK) - sizeof(uint16_t);
+    DMA0->DMA[0].DSR_BCR = (DMA0->DMA[0].DSR_BCR & ~DMA_DSR_BCR_BCR_MASK) | bcr;
+    
+    if( bcr == 0 ) {
+        uint32_t block = DMA0->DMA[0].DAR - ADC_DMA_BLOCK*sizeof(uint16_t);
+        
+        DMA0->DMA[0].DSR_BCR |= DMA_DSR_BCR_DONE_MASK;
+        if( DMA0->DMA[0].DCR & DMA_DCR_D_REQ_MASK )
+            DMA0->DMA[0].DCR &= ~DMA_DCR_ERQ_MASK;
+        if( DMA0->DMA[0].DCR & DMA_DCR_EINT_MASK )
+            DMA0_IRQHandler();
+        
+        /* handler has to restart the channel on the other block */
+        if( DMA0->DMA[0].DAR == block )
+            test_failed++;
+        else
+            test_blockStarts[block < DMA0->DMA[0].DAR ? 0 : 1]++;
+        if( (DMA0->DMA[0].DSR_BCR & DMA_DSR_BCR_DONE_MASK) 
+            || (DMA0->DMA[0].DSR_BCR & DMA_DSR_BCR_BCR_MASK) != ADC_DMA_BLOCK*sizeof(uint16_t) )
+            test_failed++;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Convert TEST_BLOCKS blocks of a pseudo random signal in given 
+ *            mode and compare every published sample with the reference.
+ * @param[in] Mode
+ * @return    Number of checked samples
+ */
+static uint32_t test_run(uint8_t mode) {
+    uint32_t seed = 12345u + mode;
+    uint8_t shift = FFT_Modes[mode].decimationShift;
+    fft_capture_t expected[ADC_DMA_BLOCK*TEST_BLOCKS];
+    uint32_t produced = 0;
+    uint32_t samples = (ADC_DMA_BLOCK*TEST_BLOCKS) >> shift;
+    uint32_t checked = 0;
+    uint32_t irqs = test_irqs;
+    int8_t slot;
+    
+    FFTstatus.mode = mode;
+    for( uint32_t n=0; n<ADC_DMA_BLOCK*TEST_BLOCKS; n++ ) {
+        uint16_t value;
+        int32_t out;
+        
+        seed = seed*1103515245u + 12345u;
+        value = (uint16_t)(FFT_AVG_VALUE - 1000 + ((seed >> 16) % 2000));
+        
+        /* reference: DC removal, decimated modes average the input */
+        out = (int32_t)value - (test_dc >> ADC_DC_SHIFT);
+        test_dc += out;
+        if( shift == 0 )
+            expected[produced++] = FFT_TO_SAMPLE(out);
+        
+        test_convert(value);
+        
+        /* consumer takes every published buffer at once */
+        while( (slot = QUEUE_ReadSlot()) != QUEUE_NONE ) {
+            for( uint16_t i=0; i<FFT_HOP_SIZE; i++ ) {
+                if( shift == 0 && FFT_Buffer[slot][i] != expected[checked] ) {
+                    if( test_failed++ < 10 )
+                        printf("mode %u sample %lu: %d, expected %d\n", mode, 
+                               (unsigned long)checked, FFT_Buffer[slot][i], expected[checked]);
+                }
+                checked++;
+            }
+            QUEUE_Release();
+        }
+    }
+    
+    /* one interrupt per block; lower rate fills buffers 2^shift times slower
+       (first decimated sample waits for the CIC to fill) */
+    TEST_CHECK(test_irqs - irqs == TEST_BLOCKS);
+    TEST_CHECK(checked + FFT_HOP_SIZE > samples && checked <= samples);
+    
+    return checked;
+}
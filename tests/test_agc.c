@@ -0,0 +1,138 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_agc.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of attack and release of the automatic gain 
+ *         (LEVEL_MapColumns) at the frame rate of every sample rate 
+ *         (LEVEL_SetFrameRate): a reference tone stays at the same level 
+ *         while a louder tone in another column steps up by TEST_STEP_DB and
+ *         back. The reference bar falls when the running peak follows the
+ *         step (attack, a fixed number of frames: 1/2^LEVEL_AGC_ATTACK_SHIFT
+ *         of the distance per frame) and rises to full height again when the
+ *         peak has been released by TEST_STEP_DB at LEVEL_AGC_RELEASE_DB per
+ *         second (the same time, so frames scale with the frame rate).
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "fft.h"
+#include "level.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* levels of the columns in dB: noise, reference tone and stepped tone */
+#define TEST_NOISE_DB            (20.0)
+#define TEST_REF_DB              (90.0)
+#define TEST_STEP_DB             (20.0)
+/* frames before a step, the noise floors settle */
+#define TEST_SETTLE_SECONDS      (8)
+/* attack is done in a few frames at any frame rate */
+#define TEST_ATTACK_FRAMES       (4)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static uint32_t test_failed = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static uint8_t test_frame(double stepDb);
+static uint32_t test_until(double stepDb, uint8_t level, int8_t below, uint32_t limit);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    printf("%6s %6s %19s %20s %22s\n", "shift", "fps", "attack frames (ms)",
+           "release frames (ms)", "expected attack/release");
+    for( uint8_t shift=0; shift<=2; shift++ ) {
+        uint16_t fps = FFT_FRAME_RATE >> shift;
+        uint32_t attack, release;
+        uint8_t full, low;
+        
+        LEVEL_SetFrameRate(fps);
+        LEVEL_AgcReset();
+        for( uint32_t n=0; n<TEST_SETTLE_SECONDS*fps; n++ )
+            full = test_frame(0);
+        /* reference is the loudest column, bar is full */
+        TEST_CHECK(full == LEVEL_MAX);
+        
+        /* reference bar falls to the level below the louder peak */
+        low = (uint8_t)(LEVEL_MAX*(TEST_REF_DB - TEST_NOISE_DB - LEVEL_NOISE_SPREAD/256.0
+                                   - LEVEL_AGC_MARGIN/256.0)
+                        /(TEST_REF_DB + TEST_STEP_DB - TEST_NOISE_DB - LEVEL_NOISE_SPREAD/256.0
+                          - LEVEL_AGC_MARGIN/256.0));
+        attack = test_until(TEST_STEP_DB, low, 1, fps);
+        for( uint32_t n=0; n<fps; n++ )
+            TEST_CHECK(test_frame(TEST_STEP_DB) == low);
+        
+        /* louder tone is gone, peak is released */
+        release = test_until(0, LEVEL_MAX, 0, 10*fps);
+        
+        printf("%6d %6d %11lu (%5.1f) %11lu (%6.0f) %12d / %4.0f ms\n", shift, fps,
+               (unsigned long)attack, attack*1000.0/fps, (unsigned long)release,
+               release*1000.0/fps, TEST_ATTACK_FRAMES, TEST_STEP_DB*1000/LEVEL_AGC_RELEASE_DB);
+        TEST_CHECK(attack >= 1 && attack <= TEST_ATTACK_FRAMES);
+        TEST_CHECK(fabs(release - TEST_STEP_DB*fps/LEVEL_AGC_RELEASE_DB) 
+                   <= 0.02*TEST_STEP_DB*fps/LEVEL_AGC_RELEASE_DB + 2);
+    }
+    
+    printf("test_agc: %lu failed\n", (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Map one frame: reference tone in column 1, tone TEST_STEP_DB 
+ *            louder or as loud as the reference in column 5, noise in the 
+ *            other columns.
+ * @param[in] Level of the second tone above the reference in dB
+ * @return    Level of the reference bar
+ */
+static uint8_t test_frame(double stepDb) {
+    int32_t log2Pow[LEVEL_COLUMNS];
+    uint8_t levels[LEVEL_COLUMNS];
+    
+    for( uint8_t i=0; i<LEVEL_COLUMNS; i++ ) {
+        double db = i == 1 ? TEST_REF_DB : i == 5 ? TEST_REF_DB + stepDb : TEST_NOISE_DB;
+        
+        /* dB of magnitude to log2 of power, Q8 */
+        log2Pow[i] = (int32_t)lround(db/20*log2(10.0)*2*256);
+    }
+    LEVEL_MapColumns(log2Pow, levels, LEVEL_COLUMNS);
+    
+    return levels[1];
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Count frames until the reference bar reaches a level.
+ * @param[in] Level of the second tone above the reference in dB
+ * @param[in] Level of the reference bar
+ * @param[in] 1 - bar falls to the level, 0 - bar rises to it
+ * @param[in] Most frames
+ * @return    Frames including the one which reached the level
+ */
+static uint32_t test_until(double stepDb, uint8_t level, int8_t below, uint32_t limit) {
+    for( uint32_t n=1; n<=limit; n++ ) {
+        uint8_t bar = test_frame(stepDb);
+        
+        if( below ? bar <= level : bar >= level )
+            return n;
+    }
+    return limit + 1;
+}
@@ -0,0 +1,195 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_burst.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of burst writes to the LCD: the boot sequence and typical
+ *         spectra go through display.c, glyph.c and lcd1602.c on the LCD
+ *         model (lcd_model.c) twice, once with every expander byte in its
+ *         own I2C transaction as the old PCF8574_Write -> I2C_Write path
+ *         (LCD_MODEL_SingleBytes) and once with the blocks of the batches.
+ *         START and STOP conditions, address bytes and bus time are counted
+ *         per frame; the LCD must get the same bytes both ways.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "lcd1602.h"
+#include "glyph.h"
+#include "display.h"
+#include "timer.h"
+#include "level.h"
+#include "lcd_model.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of every spectrum and frame rate of mode 1 */
+#define TEST_FRAMES              (2000)
+#define TEST_FRAME_RATE          (312)
+/* bits on the bus: a byte with acknowledge, START and STOP about a bit */
+#define TEST_BYTE_BITS           (9)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const char *Test_Spectra[] = {
+    "steady",          /* the same levels every frame */
+    "music",           /* falling slope which moves slowly */
+    "sweep",           /* one strong column moving over the others */
+    "noise"            /* random levels every frame */
+};
+
+static uint32_t test_failed = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void test_boot(LcdModelCounters *counters);
+static void test_spectrum(uint8_t spectrum, LcdModelCounters *counters);
+static void test_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels);
+static void test_print(const char *name, const char *path, const LcdModelCounters *counters,
+                       uint32_t frames);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    LcdModelCounters counters[2];
+    
+    TIMER_Init();
+    DISPLAY_SetFrameRate(TEST_FRAME_RATE);
+    
+    printf("%-8s %-6s %9s %9s %9s %9s %9s %9s\n", "frames", "path", "starts", "stops",
+           "address", "data", "overhead", "bus ms");
+    for( int8_t s=-1; s<(int8_t)(sizeof(Test_Spectra)/sizeof(Test_Spectra[0])); s++ ) {
+        /* path 0: single bytes (old), 1: blocks */
+        for( uint8_t path=0; path<2; path++ ) {
+            LCD_MODEL_SingleBytes(path == 0);
+            if( s < 0 )
+                test_boot(&counters[path]);
+            else
+                test_spectrum((uint8_t)s, &counters[path]);
+            test_print(s < 0 ? "boot" : Test_Spectra[s], path ? "burst" : "single",
+                       &counters[path], s < 0 ? 1 : TEST_FRAMES);
+        }
+        
+        /* the LCD gets the same bytes, one transaction per expander byte 
+           before (and the probe of the other expander address at boot) */
+        TEST_CHECK(counters[0].dataBytes == counters[1].dataBytes);
+        TEST_CHECK(counters[0].ddramWrites == counters[1].ddramWrites);
+        TEST_CHECK(counters[0].cgramWrites == counters[1].cgramWrites);
+        TEST_CHECK(counters[0].starts == counters[0].dataBytes + (s < 0));
+        TEST_CHECK(counters[1].starts == counters[1].stops);
+        TEST_CHECK(counters[1].starts == counters[1].addressBytes);
+        TEST_CHECK(counters[1].starts <= counters[0].starts);
+        TEST_CHECK(counters[1].busCycles <= counters[0].busCycles);
+        if( counters[1].dataBytes > 0 )
+            TEST_CHECK(counters[1].starts < counters[0].starts);
+    }
+    
+    printf("test_burst: %lu failed\n", (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Boot sequence of main.c: LCD initialization, bars of 1-8
+ *             strips in slots 0-7 and clear display.
+ * @param[out] Counters of the sequence
+ */
+static void test_boot(LcdModelCounters *counters) {
+    LCD_MODEL_Reset();
+    LCD1602_Init();
+    LCD1602_LVL_CH();
+    LCD1602_ClearAll();
+    I2C_Wait();
+    LCD_MODEL_Get(counters);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Draw the frames of a spectrum from an empty display.
+ * @param[in]  Spectrum (Test_Spectra)
+ * @param[out] Counters of all frames
+ */
+static void test_spectrum(uint8_t spectrum, LcdModelCounters *counters) {
+    /* same frames and glyphs for both paths */
+    srand(1);
+    LCD1602_LVL_CH();
+    GLYPH_Reset();
+    LCD1602_ClearAll();
+    DISPLAY_Reset();
+    I2C_Wait();
+    
+    LCD_MODEL_Reset();
+    for( uint32_t frame=0; frame<TEST_FRAMES; frame++ ) {
+        uint8_t levels[DISPLAY_COLUMNS];
+        
+        test_levels(spectrum, frame, levels);
+        DISPLAY_Submit(levels);
+        DISPLAY_Service();
+        I2C_Wait();
+    }
+    LCD_MODEL_Get(counters);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Levels of a frame of a test spectrum.
+ * @param[in]  Spectrum (Test_Spectra)
+ * @param[in]  Frame number
+ * @param[out] Column levels: 0-16
+ */
+static void test_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels) {
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        int32_t level;
+        
+        switch( spectrum ) {
+            case 0:
+                level = 14 - i*3/4;
+                break;
+            case 1:
+                level = 15 - i*3/4 + (int32_t)((frame/40 + i*7) % 5) - 2;
+                break;
+            case 2:
+                level = (i == (frame/25) % DISPLAY_COLUMNS) ? 15 : 3 + (i & 1);
+                break;
+            default:
+                level = rand() % (LEVEL_MAX + 1);
+                break;
+        }
+        levels[i] = (uint8_t)(level < 0 ? 0 : level > LEVEL_MAX ? LEVEL_MAX : level);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Print counters per frame; overhead is the share of the bus time
+ *            taken by START, address and STOP.
+ * @param[in] Name of the frames
+ * @param[in] Name of the path
+ * @param[in] Counters
+ * @param[in] Number of frames
+ */
+static void test_print(const char *name, const char *path, const LcdModelCounters *counters,
+                       uint32_t frames) {
+    uint64_t overhead = counters->starts + counters->stops +
+                        (uint64_t)counters->addressBytes*TEST_BYTE_BITS;
+    uint64_t bits = overhead + (uint64_t)counters->dataBytes*TEST_BYTE_BITS;
+    
+    printf("%-8s %-6s %9.2f %9.2f %9.2f %9.2f %8.1f%% %9.3f\n", name, path,
+           (double)counters->starts/frames, (double)counters->stops/frames,
+           (double)counters->addressBytes/frames, (double)counters->dataBytes/frames,
+           bits ? 100.0*overhead/bits : 0.0,
+           1000.0*counters->busCycles/TIMER_CLOCK_HZ/frames);
+}
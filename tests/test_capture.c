@@ -0,0 +1,253 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_capture.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the float16_t pipeline with packed Q15 capture: the
+ *         same frames are windowed as now (Q15 capture and integer window in
+ *         FFT_ProcessBuffer, one conversion per sample of the frame) and as 
+ *         before (every sample converted to float16_t in ADC0 interrupt, 
+ *         window multiplied in float16_t), with float16_t rounding emulated 
+ *         (host float16_t is float). Columns of both may differ by one level
+ *         but never more; the model of the new path must give exactly the
+ *         columns of FFT_ProcessBuffer. An instruction count model of the 
+ *         store step of ADC0 interrupt compares both.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "fft.h"
+#include "window.h"
+#include "level.h"
+#include "dsp/transform_functions_f16.h"
+
+#if FFT_FIXED_POINT
+#error "test_capture is built with FFT_FIXED_POINT 0"
+#endif
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of every mode */
+#define TEST_FRAMES              (64)
+/* Thumb-1 instructions of the steps of the int to float16_t conversion 
+   (__aeabi_i2f followed by __aeabi_f2h, no FPU on Cortex-M0+) */
+#define TEST_OPS_CALL            (6)     /* bl, push, pop, argument moves */
+#define TEST_OPS_SIGN            (4)     /* zero and sign tests, negation */
+#define TEST_OPS_CLZ_STEP        (2)     /* test of a leading zeros step */
+#define TEST_OPS_CLZ_TAKEN       (2)     /* count and shift of a taken step */
+#define TEST_OPS_PACK            (5)     /* exponent, mantissa, sign to float */
+#define TEST_OPS_UNPACK          (6)     /* exponent and mantissa of float */
+#define TEST_OPS_RANGE           (4)     /* overflow and subnormal tests */
+#define TEST_OPS_ROUND           (7)     /* round to nearest even, carry */
+#define TEST_OPS_STORE           (2)     /* index and store to the buffer */
+#define TEST_OPS_SHIFT           (1)     /* FFT_TO_SAMPLE */
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static arm_rfft_fast_instance_f16 test_fft;
+static float16_t test_frame[FFT_SIZE];
+static int16_t test_samples[FFT_SIZE];
+
+static uint32_t test_failed = 0;
+/* instructions of the old store step and samples converted */
+static uint64_t test_ops = 0;
+static uint32_t test_converted = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void test_signal(uint8_t mode, uint32_t frame);
+static void test_process(uint8_t *levels);
+static void test_columns(uint8_t *levels);
+static float test_half(float x);
+static float test_toHalf(int32_t x);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    uint32_t same = 0, offByOne = 0, worse = 0, lit = 0, model = 0;
+    
+    if( FFT_Init() != ARM_MATH_SUCCESS || arm_rfft_fast_init_f16(&test_fft, FFT_SIZE) 
+        != ARM_MATH_SUCCESS )
+        return 1;
+    
+    for( uint8_t mode=1; mode<=FFT_MODES; mode++ ) {
+        FFTstatus.mode = mode;
+        for( uint32_t frame=0; frame<TEST_FRAMES; frame++ ) {
+            uint8_t real[16], exact[16], now[16], before[16];
+            
+            test_signal(mode, frame);
+            test_process(real);
+            
+            /* new path without float16_t rounding is FFT_ProcessBuffer */
+            for( uint16_t i=0; i<FFT_SIZE; i++ )
+                test_frame[i] = FFT_FROM_CAPTURE(FFT_WINDOW_SAMPLE(FFT_TO_SAMPLE(test_samples[i]),
+                                                                   WINDOW_Coeff(i)));
+            test_columns(exact);
+            if( memcmp(real, exact, 16) != 0 )
+                model++;
+            
+            /* now: Q15 capture, integer window, conversion of the product */
+            for( uint16_t i=0; i<FFT_SIZE; i++ )
+                test_frame[i] = test_half(FFT_WINDOW_SAMPLE(FFT_TO_SAMPLE(test_samples[i]),
+                                                            WINDOW_Coeff(i)))
+                                *(1.0f/(1<<FFT_Q15_SHIFT));
+            test_columns(now);
+            
+            /* before: float16_t capture, window coefficient and product */
+            for( uint16_t i=0; i<FFT_SIZE; i++ )
+                test_frame[i] = test_half(test_toHalf(test_samples[i])
+                                          *test_half(WINDOW_Coeff(i)*(1.0f/32768)));
+            test_columns(before);
+            
+            for( uint8_t i=0; i<16; i++ ) {
+                int diff = abs(now[i] - before[i]);
+                
+                if( before[i] != 0 )
+                    lit++;
+                if( diff == 0 )
+                    same++;
+                else if( diff == 1 )
+                    offByOne++;
+                else if( worse++ < 10 )
+                    printf("mode %d frame %lu column %d: level %d, float16_t capture %d\n",
+                           mode, (unsigned long)frame, i, now[i], before[i]);
+            }
+        }
+    }
+    TEST_CHECK(model == 0);
+    TEST_CHECK(worse == 0 && lit != 0);
+    printf("columns: %lu (%lu lit), %lu same, %lu one level off, %lu worse; "
+           "%lu frames differ from FFT_ProcessBuffer\n", (unsigned long)(same+offByOne+worse),
+           (unsigned long)lit, (unsigned long)same, (unsigned long)offByOne,
+           (unsigned long)worse, (unsigned long)model);
+    
+    /* store step of ADC0 interrupt, per sample and at 40 kHz */
+    printf("ISR store step: float16_t %.1f instructions, Q15 %d instructions per sample "
+           "(%.2f%% of 48 MHz at %d Hz saved)\n", (double)test_ops/test_converted,
+           TEST_OPS_SHIFT + TEST_OPS_STORE, 
+           100.0*((double)test_ops/test_converted - TEST_OPS_SHIFT - TEST_OPS_STORE)
+           *FFT_SAMPLE_RATE/48e6, FFT_SAMPLE_RATE);
+    TEST_CHECK((double)test_ops/test_converted > TEST_OPS_SHIFT + TEST_OPS_STORE);
+    
+    printf("test_capture: %lu failed\n", (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Samples of a frame (ADC units, constant value removed): a tone of
+ *            changing frequency and level (-6 to -66 dB of the ADC range), a
+ *            weaker second tone and noise which grows with the tone, so 
+ *            most columns are lit.
+ * @param[in] Mode
+ * @param[in] Frame number
+ */
+static void test_signal(uint8_t mode, uint32_t frame) {
+    static uint32_t seed = 1;
+    double rate = FFT_SAMPLE_RATE >> FFT_Modes[mode].decimationShift;
+    double f1 = rate/2 * (frame*37 % TEST_FRAMES + 0.5)/TEST_FRAMES;
+    double f2 = rate/2 * (frame*11 % TEST_FRAMES + 0.3)/TEST_FRAMES;
+    double a1 = 2048*pow(10, -(6 + 60.0*(frame*53 % TEST_FRAMES)/TEST_FRAMES)/20);
+    
+    for( uint16_t i=0; i<FFT_SIZE; i++ ) {
+        double x = a1*sin(2*M_PI*f1*i/rate) + a1/8*sin(2*M_PI*f2*i/rate + 1);
+        
+        /* noise of the amplifier and a part of the signal */
+        seed = seed*1103515245u + 12345u;
+        x += ((double)((seed >> 16) & 0xFF) - 127.5)*(1.0/16 + a1/1024);
+        test_samples[i] = (int16_t)lround(x);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Columns of the frame calculated by FFT_ProcessBuffer, the frame
+ *             is given in FFT_HOP_SIZE buffers after a reset of the history.
+ * @param[out] Levels of 16 columns
+ */
+static void test_process(uint8_t *levels) {
+    uint8_t valid = 0;
+    
+    FFT_ResetHistory();
+    for( uint16_t hop=0; hop<FFT_SIZE/FFT_HOP_SIZE; hop++ ) {
+        for( uint16_t i=0; i<FFT_HOP_SIZE; i++ )
+            FFT_Buffer[0][i] = FFT_TO_SAMPLE(test_samples[hop*FFT_HOP_SIZE + i]);
+        valid = FFT_ProcessBuffer(0);
+    }
+    TEST_CHECK(valid);
+    memcpy(levels, FrequencyBins, 16);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Columns of the windowed frame in test_frame, FFT and columns of
+ *             fft.c.
+ * @param[out] Levels of 16 columns
+ */
+static void test_columns(uint8_t *levels) {
+    arm_rfft_fast_f16(&test_fft, test_frame, FFT_Output, 0);
+    FFT_CalculateColumns_256();
+    memcpy(levels, FrequencyBins, 16);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Round to the nearest float16_t value (11 significant bits, ties
+ *            to even, subnormals below 2^-14).
+ * @param[in] Value
+ * @return    Rounded value
+ */
+static float test_half(float x) {
+    int e;
+    double quantum;
+    
+    if( x == 0 )
+        return 0;
+    frexp(x, &e);
+    if( e - 1 < -14 )
+        e = -13;
+    quantum = ldexp(1.0, e - 1 - 10);
+    return (float)(nearbyint(x/quantum)*quantum);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Conversion of a sample to float16_t in ADC0 interrupt before 
+ *            packed capture, instructions of its steps are counted.
+ * @param[in] Sample with removed constant value (ADC units)
+ * @return    Converted value
+ */
+static float test_toHalf(int32_t x) {
+    uint32_t m = (uint32_t)(x < 0 ? -x : x);
+    uint32_t ops = 2*TEST_OPS_CALL + TEST_OPS_SIGN + TEST_OPS_STORE;
+    
+    if( m != 0 ) {
+        /* leading zeros by halving steps 16, 8, 4, 2, 1 (no CLZ) */
+        for( uint8_t step=16; step>0; step>>=1 ) {
+            ops += TEST_OPS_CLZ_STEP;
+            if( (m >> (32 - step)) == 0 ) {
+                m <<= step;
+                ops += TEST_OPS_CLZ_TAKEN;
+            }
+        }
+        ops += TEST_OPS_PACK + TEST_OPS_UNPACK + TEST_OPS_RANGE + TEST_OPS_ROUND;
+    }
+    test_ops += ops;
+    test_converted++;
+    
+    return test_half((float)x);
+}
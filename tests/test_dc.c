@@ -0,0 +1,149 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_dc.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the DC offset tracker of ADC0 interrupt (ADC_RemoveDc):
+ *         a tone on a bias which jumps and then drifts slowly is given to the
+ *         interrupt, and the estimate (ADC_GetDcEstimate) is compared with
+ *         the bias. After a step the residual must fall to 1/e in 
+ *         2^ADC_DC_SHIFT samples and below 1 ADC unit later; on a linear 
+ *         drift the residual DC must be the lag of the first order low-pass,
+ *         slope*2^ADC_DC_SHIFT, instead of the whole drift left by a fixed
+ *         FFT_AVG_VALUE.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "ADC.h"
+#include "fft.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* bias step in ADC units, as after power-up of the amplifier */
+#define TEST_STEP                (400)
+/* bias drift in ADC units per second (warming up) and its duration */
+#define TEST_DRIFT               (100.0)
+#define TEST_DRIFT_SECONDS       (5)
+/* tone on the bias, ripple of the estimate is averaged over 
+   TEST_AVERAGE samples (a whole number of periods) */
+#define TEST_TONE_HZ             (1000.0)
+#define TEST_TONE                (300.0)
+#define TEST_AVERAGE             (4000)
+/* time constant of the tracker in samples */
+#define TEST_TAU                 (1 << ADC_DC_SHIFT)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static uint32_t test_n = 0;
+static uint32_t test_failed = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+void ADC0_IRQHandler(void);
+static double test_sample(double bias);
+static double test_residual(double bias, double slope);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Interrupt duration reported by ADC.c, not checked here.
+ * @param[in] Cycles
+ */
+void DIAG_IsrCycles(uint32_t cycles) {
+}
+
+int main(void) {
+    double bias = FFT_AVG_VALUE + TEST_STEP;
+    double slope = TEST_DRIFT/FFT_SAMPLE_RATE;
+    uint32_t settle = 0, settle1 = 0;
+    double residual, expected;
+    
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    /* full rate, every sample reaches the buffers */
+    FFTstatus.mode = 4;
+    ADC_Start();
+    
+    /* bias step: the estimate starts at FFT_AVG_VALUE */
+    for( uint32_t n=0; n<12*TEST_TAU; n++ ) {
+        double error = bias - test_sample(bias);
+        
+        if( settle == 0 && error <= TEST_STEP*exp(-1.0) )
+            settle = n + 1;
+        if( settle1 == 0 && error <= 1.0 )
+            settle1 = n + 1;
+    }
+    residual = test_residual(bias, 0);
+    printf("step %d: 1/e after %lu samples (%.1f ms), 1 unit after %lu samples (%.0f ms), "
+           "residual %.2f\n", TEST_STEP, (unsigned long)settle, settle*1000.0/FFT_SAMPLE_RATE,
+           (unsigned long)settle1, settle1*1000.0/FFT_SAMPLE_RATE, residual);
+    /* first order low-pass with time constant 2^ADC_DC_SHIFT samples */
+    TEST_CHECK(settle >= TEST_TAU*95/100 && settle <= TEST_TAU*105/100);
+    TEST_CHECK(settle1 > 0 && settle1 <= 7*TEST_TAU);
+    TEST_CHECK(fabs(residual) <= 1.0);
+    
+    /* linear drift: the estimate lags by slope*tau */
+    for( uint32_t n=0; n<TEST_DRIFT_SECONDS*FFT_SAMPLE_RATE; n++ ) {
+        bias += slope;
+        test_sample(bias);
+    }
+    residual = test_residual(bias, slope);
+    expected = slope*TEST_TAU;
+    printf("drift %.0f/s for %d s: residual DC %.2f (lag %.2f), %.0f with fixed FFT_AVG_VALUE\n",
+           TEST_DRIFT, TEST_DRIFT_SECONDS, residual, expected, bias - FFT_AVG_VALUE);
+    /* the estimate is truncated, up to one unit below the low-pass */
+    TEST_CHECK(residual >= expected - 0.5 && residual <= expected + 1.5);
+    
+    printf("test_dc (shift %d): %lu failed\n", ADC_DC_SHIFT, (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Give one sample of the tone on the bias to ADC0 interrupt.
+ * @param[in] Bias in ADC units
+ * @return    DC estimate after the sample
+ */
+static double test_sample(double bias) {
+    double x = bias + TEST_TONE*sin(2*M_PI*TEST_TONE_HZ*test_n/FFT_SAMPLE_RATE);
+    
+    test_n++;
+    ADC0->R[0] = (uint32_t)lround(x);
+    ADC0_IRQHandler();
+    
+    return ADC_GetDcEstimate();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Average difference between the bias and the estimate over 
+ *            TEST_AVERAGE samples, the ripple of the tone is averaged out.
+ * @param[in] Bias in ADC units at the start
+ * @param[in] Drift in ADC units per sample
+ * @return    Residual DC in ADC units
+ */
+static double test_residual(double bias, double slope) {
+    double sum = 0;
+    
+    for( uint32_t n=0; n<TEST_AVERAGE; n++ ) {
+        bias += slope;
+        sum += bias - test_sample(bias);
+    }
+    return sum/TEST_AVERAGE;
+}
@@ -0,0 +1,165 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_dft.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the per-sample DFT engine (dft.c): synthetic tones
+ *         (on a bin, between bins, two tones, different levels) are pushed
+ *         sample by sample in modes 4-8 and every latched column is compared
+ *         with a double precision DFT of the same Hann windowed frame.
+ *         Magnitudes must match within TEST_RELATIVE_ERROR (log2 table) plus
+ *         TEST_ABSOLUTE_ERROR (windowed samples are truncated to ADC units,
+ *         about -70 dB of a full scale tone), levels within one level.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "dft.h"
+#include "level.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames latched in every test signal */
+#define TEST_FRAMES              (8)
+/* largest error of a column magnitude: relative and absolute part (a full 
+   scale tone has magnitude of 2048*FFT_SIZE/4) */
+#define TEST_RELATIVE_ERROR      (0.003)
+#define TEST_ABSOLUTE_ERROR      (32.0)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private structs
+ ******************************************************************************/
+
+/**
+ * @brief test signal: up to two tones, frequency as a bin number of the mode
+ */
+typedef struct {
+    double bin1, amplitude1;
+    double bin2, amplitude2;
+} TestSignal;
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const TestSignal Test_Signals[] = {
+    { 0.0,   1800, 0.0,  0   },    /* on the bin of column 0 */
+    { 7.0,   1800, 0.0,  0   },    /* on the bin of column 7 */
+    { 10.5,  1000, 0.0,  0   },    /* between columns 10 and 11 */
+    { 15.25, 200,  0.0,  0   },    /* near the last column */
+    { 3.0,   1500, 12.0, 40  },    /* strong and weak tone */
+    { 5.4,   20,   0.0,  0   },    /* quiet tone */
+    { -3.0,  1000, 20.0, 1000}     /* tones outside the columns */
+};
+
+/* samples of the last FFT_SIZE pushes, the stream goes on across signals */
+static int16_t test_history[FFT_SIZE];
+static uint32_t test_pushed = 0;
+static uint8_t test_mode = 0;
+static uint32_t test_failed = 0;
+static uint32_t test_columns = 0;
+/* largest error above the relative part */
+static double test_maxError = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void test_signal(uint8_t mode, const TestSignal *signal);
+static void test_frame(uint8_t mode, uint8_t buffer);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    for( uint8_t mode=4; mode<=FFT_MODES; mode++ ) {
+        for( uint8_t s=0; s<sizeof(Test_Signals)/sizeof(Test_Signals[0]); s++ )
+            test_signal(mode, &Test_Signals[s]);
+    }
+    
+    printf("test_dft: %lu columns of modes 4-8, largest error %.1f%% + %.1f, "
+           "%lu failed\n", (unsigned long)test_columns, 100*TEST_RELATIVE_ERROR, test_maxError,
+           (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Push a test signal sample by sample as ADC0 interrupt does, latch
+ *            a buffer every FFT_HOP_SIZE samples and check the complete ones.
+ * @param[in] Mode
+ * @param[in] Test signal
+ */
+static void test_signal(uint8_t mode, const TestSignal *signal) {
+    double first = FFT_Modes[mode].firstBin;
+    uint32_t pushed = 0;
+    uint8_t buffer = 0;
+    uint8_t valid = 0;
+    uint8_t changed = (mode != test_mode);
+    
+    FFTstatus.mode = test_mode = mode;
+    while( valid < TEST_FRAMES ) {
+        for( uint16_t i=0; i<FFT_HOP_SIZE; i++, pushed++ ) {
+            double phase = 2*M_PI*pushed/FFT_SIZE;
+            double x = signal->amplitude1*sin((first + signal->bin1)*phase)
+                     + signal->amplitude2*sin((first + signal->bin2)*phase + 0.7);
+            int16_t sample = (int16_t)lround(x);
+            
+            test_history[test_pushed++ % FFT_SIZE] = sample;
+            DFT_Push(sample);
+        }
+        DFT_Latch(buffer);
+        
+        /* frames started in the previous mode must not be valid */
+        if( DFT_IsValid(buffer, mode) ) {
+            TEST_CHECK(!changed || pushed >= FFT_SIZE);
+            test_frame(mode, buffer);
+            valid++;
+        }
+        buffer = (uint8_t)((buffer + 1) % FFT_BUFFERS);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Compare latched columns with a double precision DFT of the last
+ *            FFT_SIZE samples.
+ * @param[in] Mode
+ * @param[in] Latched buffer
+ */
+static void test_frame(uint8_t mode, uint8_t buffer) {
+    for( uint8_t i=0; i<DFT_BINS; i++ ) {
+        uint16_t bin = FFT_Modes[mode].firstBin + i;
+        int32_t log2Pow = DFT_BinLog2Power(buffer, i);
+        double re = 0, im = 0;
+        double magnitude, error;
+        
+        for( uint16_t n=0; n<FFT_SIZE; n++ ) {
+            double w = 0.5 - 0.5*cos(2*M_PI*n/(FFT_SIZE-1));
+            double x = w*test_history[(test_pushed + n) % FFT_SIZE];
+            
+            re += x*cos(2*M_PI*bin*n/FFT_SIZE);
+            im -= x*sin(2*M_PI*bin*n/FFT_SIZE);
+        }
+        magnitude = sqrt(re*re + im*im);
+        error = fabs(pow(2, log2Pow/512.0) - magnitude) - TEST_RELATIVE_ERROR*magnitude;
+        if( error > test_maxError )
+            test_maxError = error;
+        
+        test_columns++;
+        TEST_CHECK(error <= TEST_ABSOLUTE_ERROR);
+        TEST_CHECK(abs(LEVEL_FromLog2Power(log2Pow) 
+                       - LEVEL_FromLog2Power((int32_t)lround(log2(re*re + im*im + 1)*256))) <= 1);
+    }
+}
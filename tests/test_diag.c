@@ -0,0 +1,271 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_diag.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of diagnostic counters under overload: samples go through
+ *         ADC0 interrupt and the real queue while the main loop stops taking
+ *         frames (dropped frames with QUEUE_DROP_OLDEST, dropped samples with
+ *         QUEUE_DROP_NEWEST), the cycle counter stub makes interrupts longer
+ *         than ADC_CYCLE_BUDGET and the I2C stub reports failed background
+ *         transactions. Every DIAG counter must have the forced value, also 
+ *         after DIAG_Reset, and DIAG_Print must show them in 16 characters.
+ *         Built once per QUEUE_POLICY.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "ADC.h"
+#include "fft.h"
+#include "queue.h"
+#include "timer.h"
+#include "diag.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* interrupt duration measured by the stub, normal and overloaded */
+#define TEST_ISR_CYCLES          (300)
+#define TEST_ISR_SLOW            (ADC_CYCLE_BUDGET)
+/* frames published beyond the free buffers while the main loop is stalled */
+#define TEST_STALLED             (5)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* cycle counter stub: duration of every measured interrupt */
+static uint32_t test_clock = 0;
+static uint32_t test_isrCycles = TEST_ISR_CYCLES;
+/* failed transactions reported by the I2C stub */
+static uint32_t test_i2cFailed = 0;
+/* LCD stub: screens shown by DIAG_Print */
+static char test_screens[4][2][17];
+static uint8_t test_screen = 0;
+static uint8_t test_row = 0;
+
+static uint32_t test_failed = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+void ADC0_IRQHandler(void);
+static void test_samples(uint32_t count, uint8_t consume);
+static void test_print(const DiagCounters *counters);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    DiagCounters counters;
+    
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    FFTstatus.mode = 1;
+    ADC_Start();
+    DIAG_Reset();
+    
+    /* normal load: every frame is processed, every interrupt fits */
+    test_samples(64*FFT_HOP_SIZE, 1);
+    DIAG_Get(&counters);
+    TEST_CHECK(counters.framesProcessed == 64);
+    TEST_CHECK(counters.droppedFrames == 0);
+    TEST_CHECK(counters.droppedSamples == 0);
+    TEST_CHECK(counters.isrCyclesMax == TEST_ISR_CYCLES + ADC_IRQ_OVERHEAD);
+    TEST_CHECK(counters.isrCyclesAvg + 1 >= TEST_ISR_CYCLES + ADC_IRQ_OVERHEAD
+               && counters.isrCyclesAvg <= TEST_ISR_CYCLES + ADC_IRQ_OVERHEAD);
+    TEST_CHECK(counters.isrOverBudget == 0);
+    TEST_CHECK(counters.i2cErrors == 0);
+    
+    /* main loop stalled: buffers fill up, TEST_STALLED frames more come */
+    test_samples((FFT_BUFFERS + TEST_STALLED)*FFT_HOP_SIZE, 0);
+    /* a few interrupts longer than the sample period */
+    test_isrCycles = TEST_ISR_SLOW;
+    test_samples(7, 0);
+    test_isrCycles = TEST_ISR_CYCLES;
+    /* LCD frames lost on the bus */
+    test_i2cFailed += 3;
+    
+    DIAG_Get(&counters);
+    TEST_CHECK(counters.framesProcessed == 64);
+#if QUEUE_POLICY == QUEUE_DROP_OLDEST
+    /* the first sample of every stalled frame overwrites the oldest one */
+    TEST_CHECK(counters.droppedFrames == TEST_STALLED + 1);
+    TEST_CHECK(counters.droppedSamples == 0);
+#else
+    /* every sample is dropped while all buffers are occupied */
+    TEST_CHECK(counters.droppedFrames == 0);
+    TEST_CHECK(counters.droppedSamples == TEST_STALLED*FFT_HOP_SIZE + 7);
+#endif
+    TEST_CHECK(counters.isrCyclesMax == TEST_ISR_SLOW + ADC_IRQ_OVERHEAD);
+    TEST_CHECK(counters.isrOverBudget == 7);
+    TEST_CHECK(counters.i2cErrors == 3);
+    printf("overload: %lu frames, %lu dropped frames, %lu dropped samples, "
+           "ISR max %lu avg %lu cycles, %lu over budget, %lu I2C errors\n",
+           (unsigned long)counters.framesProcessed, (unsigned long)counters.droppedFrames,
+           (unsigned long)counters.droppedSamples, (unsigned long)counters.isrCyclesMax,
+           (unsigned long)counters.isrCyclesAvg, (unsigned long)counters.isrOverBudget,
+           (unsigned long)counters.i2cErrors);
+    
+    /* the LCD shows the same values */
+    test_print(&counters);
+    
+    /* after a reset only new events are counted, queue and I2C counters of
+       the modules go on */
+    DIAG_Reset();
+    DIAG_Get(&counters);
+    TEST_CHECK(counters.framesProcessed == 0 && counters.droppedFrames == 0
+               && counters.droppedSamples == 0 && counters.isrCyclesMax == 0
+               && counters.isrOverBudget == 0 && counters.i2cErrors == 0);
+    test_i2cFailed++;
+    test_samples(2*FFT_HOP_SIZE, 1);
+    DIAG_Get(&counters);
+#if QUEUE_POLICY == QUEUE_DROP_OLDEST
+    /* one of the buffers was being filled again, 7 samples are in it */
+    TEST_CHECK(counters.framesProcessed == FFT_BUFFERS - 1 + 2);
+#else
+    TEST_CHECK(counters.framesProcessed == FFT_BUFFERS + 2);
+#endif
+    TEST_CHECK(counters.droppedFrames == 0);
+    TEST_CHECK(counters.droppedSamples == 0);
+    TEST_CHECK(counters.isrCyclesMax == TEST_ISR_CYCLES + ADC_IRQ_OVERHEAD);
+    TEST_CHECK(counters.isrOverBudget == 0);
+    TEST_CHECK(counters.i2cErrors == 1);
+    
+    printf("test_diag (%s): %lu failed\n", QUEUE_POLICY == QUEUE_DROP_OLDEST ? "drop oldest"
+           : "drop newest", (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Give samples to ADC0 interrupt, the main loop takes every 
+ *            published frame or none.
+ * @param[in] Number of samples
+ * @param[in] 1 - frames are processed, 0 - main loop is stalled
+ */
+static void test_samples(uint32_t count, uint8_t consume) {
+    int8_t slot;
+    
+    for( uint32_t n=0; n<=count; n++ ) {
+        /* frames waiting from before are taken first */
+        while( consume && (slot = QUEUE_ReadSlot()) != QUEUE_NONE ) {
+            QUEUE_Release();
+            DIAG_FrameProcessed();
+        }
+        if( n == count )
+            break;
+        
+        ADC0->R[0] = FFT_AVG_VALUE + (n & 0x3F);
+        ADC0_IRQHandler();
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Print counters with DIAG_Print on the LCD stub and compare the
+ *            screens with the values.
+ * @param[in] Counters printed
+ */
+static void test_print(const DiagCounters *counters) {
+    /* values of the test fit in the columns, longer text would not match */
+    char expected[2][32];
+    
+    test_screen = 0;
+    DIAG_Print();
+    /* three screens and the final clear */
+    TEST_CHECK(test_screen == 4);
+    
+    snprintf(expected[0], sizeof(expected[0]), "Frames  %8lu", 
+             (unsigned long)counters->framesProcessed);
+    snprintf(expected[1], sizeof(expected[1]), "Lost %4lu/%6lu",
+             (unsigned long)counters->droppedFrames, (unsigned long)counters->droppedSamples);
+    TEST_CHECK(strcmp(test_screens[0][0], expected[0]) == 0);
+    TEST_CHECK(strcmp(test_screens[0][1], expected[1]) == 0);
+    
+    snprintf(expected[0], sizeof(expected[0]), "ISR max %4lu cy",
+             (unsigned long)counters->isrCyclesMax);
+    snprintf(expected[1], sizeof(expected[1]), "avg %4lu >%6lu",
+             (unsigned long)counters->isrCyclesAvg, (unsigned long)counters->isrOverBudget);
+    TEST_CHECK(strcmp(test_screens[1][0], expected[0]) == 0);
+    TEST_CHECK(strcmp(test_screens[1][1], expected[1]) == 0);
+    
+    snprintf(expected[0], sizeof(expected[0]), "I2C errors %5lu",
+             (unsigned long)counters->i2cErrors);
+    TEST_CHECK(strcmp(test_screens[2][0], expected[0]) == 0);
+    
+    for( uint8_t s=0; s<3; s++ )
+        printf("screen %d: [%-16s] [%-16s]\n", s+1, test_screens[s][0], test_screens[s][1]);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Cycle counter stub, nothing to start.
+ */
+void TIMER_Init(void) {
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Cycle counter stub: time goes on by one cycle at every read.
+ * @return Counter value
+ */
+uint32_t TIMER_Now(void) {
+    test_clock = (test_clock + 1) & TIMER_MASK;
+    return test_clock;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Cycle counter stub: the interrupt took test_isrCycles.
+ * @param[in] Counter value returned by TIMER_Now
+ * @return    Elapsed cycles
+ */
+uint32_t TIMER_Elapsed(uint32_t start) {
+    return test_isrCycles;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  I2C stub: failed background transactions.
+ * @return Failed transactions
+ */
+uint32_t I2C_GetFailedTransfers(void) {
+    return test_i2cFailed;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief LCD stub: a new screen starts.
+ */
+void LCD1602_ClearAll(void) {
+    if( test_screen < 4 ) {
+        memset(test_screens[test_screen], 0, sizeof(test_screens[0]));
+        test_screen++;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     LCD stub: row of the next text.
+ * @param[in] Column
+ * @param[in] Row
+ */
+void LCD1602_SetCursor(uint8_t col, uint8_t row) {
+    test_row = row & 1;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     LCD stub: text of the current screen and row, longer text than
+ *            the LCD row is a failure.
+ * @param[in] Text
+ */
+void LCD1602_Print(char *str) {
+    TEST_CHECK(strlen(str) <= 16);
+    if( test_screen > 0 )
+        snprintf(test_screens[test_screen-1][test_row], sizeof(test_screens[0][0]), "%s", str);
+}
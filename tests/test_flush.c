@@ -0,0 +1,239 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_flush.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the shadow frame (LCD1602_Flush): typical spectra are
+ *         drawn with bars of 1-8 strips in slots 0-7 (LCD1602_LVL_CH) on the
+ *         LCD model (lcd_model.c), once by the old per column path (both
+ *         cells of every column whose level changed, each after a set cursor
+ *         command) and once by LCD1602_PutChar and LCD1602_Flush. LCD
+ *         instructions and characters are counted per frame, both ways must
+ *         show the same columns and the shadow frame must never write more.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lcd1602.h"
+#include "timer.h"
+#include "level.h"
+#include "lcd_model.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of every spectrum */
+#define TEST_FRAMES              (2000)
+/* columns of the spectrum, two cells each */
+#define TEST_COLUMNS             (LCD1602_COLS)
+/* cells of a level: empty, bar of 1-8 strips (slot 0-7) */
+#define TEST_EMPTY               (' ')
+#define TEST_BAR(strips)         ((char)((strips) - 1))
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const char *Test_Spectra[] = {
+    "steady",          /* the same levels every frame */
+    "music",           /* falling slope which moves slowly */
+    "sweep",           /* one strong column moving over the others */
+    "noise"            /* random levels every frame */
+};
+
+static uint32_t test_failed = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+/* not in lcd1602.h, the old path wrote characters 0-7 with it */
+void LCD1602_Write8(uint8_t data, uint8_t rs);
+
+static void test_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels);
+static void test_cells(uint8_t level, char *top, char *bottom);
+static void test_oldPath(const uint8_t *levels, uint8_t *shown);
+static void test_flushPath(const uint8_t *levels);
+static uint32_t test_wrong(const uint8_t *levels);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    TIMER_Init();
+    LCD1602_Init();
+    LCD1602_LVL_CH();
+    
+    printf("%-8s %-6s %10s %10s %10s %8s\n", "spectrum", "path", "instr/frm", "chars/frm",
+           "bytes/frm", "max");
+    for( uint8_t s=0; s<sizeof(Test_Spectra)/sizeof(Test_Spectra[0]); s++ ) {
+        LcdModelCounters counters;
+        uint32_t instructions[2] = {0, 0};
+        uint32_t chars[2] = {0, 0};
+        uint32_t most[2] = {0, 0};
+        uint32_t wrong = 0;
+        
+        for( uint8_t path=0; path<2; path++ ) {
+            uint8_t shown[TEST_COLUMNS];
+            
+            /* same frames for both paths, from an empty display */
+            srand(1);
+            LCD1602_ClearAll();
+            I2C_Wait();
+            memset(shown, 0, sizeof(shown));
+            
+            for( uint32_t frame=0; frame<TEST_FRAMES; frame++ ) {
+                uint8_t levels[TEST_COLUMNS];
+                uint32_t bytes;
+                
+                test_levels(s, frame, levels);
+                LCD_MODEL_Reset();
+                if( path == 0 )
+                    test_oldPath(levels, shown);
+                else
+                    test_flushPath(levels);
+                I2C_Wait();
+                LCD_MODEL_Get(&counters);
+                
+                bytes = counters.instructions + counters.ddramWrites;
+                instructions[path] += counters.instructions;
+                chars[path] += counters.ddramWrites;
+                if( bytes > most[path] )
+                    most[path] = bytes;
+                wrong += test_wrong(levels);
+            }
+            
+            printf("%-8s %-6s %10.2f %10.2f %10.2f %8lu\n", Test_Spectra[s],
+                   path ? "flush" : "old", (double)instructions[path]/TEST_FRAMES,
+                   (double)chars[path]/TEST_FRAMES,
+                   (double)(instructions[path] + chars[path])/TEST_FRAMES,
+                   (unsigned long)most[path]);
+        }
+        
+        TEST_CHECK(wrong == 0);
+        TEST_CHECK(instructions[1] + chars[1] <= instructions[0] + chars[0]);
+        TEST_CHECK(most[1] <= most[0]);
+        /* no set cursor command without a character after it */
+        TEST_CHECK(instructions[1] <= chars[1]);
+    }
+    
+    printf("test_flush: %lu failed\n", (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Levels of a frame of a test spectrum.
+ * @param[in]  Spectrum (Test_Spectra)
+ * @param[in]  Frame number
+ * @param[out] Column levels: 0-16
+ */
+static void test_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels) {
+    for( uint8_t i=0; i<TEST_COLUMNS; i++ ) {
+        int32_t level;
+        
+        switch( spectrum ) {
+            case 0:
+                level = 14 - i*3/4;
+                break;
+            case 1:
+                level = 15 - i*3/4 + (int32_t)((frame/40 + i*7) % 5) - 2;
+                break;
+            case 2:
+                level = (i == (frame/25) % TEST_COLUMNS) ? 15 : 3 + (i & 1);
+                break;
+            default:
+                level = rand() % (LEVEL_MAX + 1);
+                break;
+        }
+        levels[i] = (uint8_t)(level < 0 ? 0 : level > LEVEL_MAX ? LEVEL_MAX : level);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Cells of a column as the old FFT_PrintColumns drew them.
+ * @param[in]  Level: 0-16
+ * @param[out] Character of the first row
+ * @param[out] Character of the second row
+ */
+static void test_cells(uint8_t level, char *top, char *bottom) {
+    if( level == 0 ) {
+        *top = TEST_EMPTY;
+        *bottom = TEST_EMPTY;
+    }
+    else if( level <= 8 ) {
+        *top = TEST_EMPTY;
+        *bottom = TEST_BAR(level);
+    }
+    else {
+        *top = TEST_BAR(level - 8);
+        *bottom = TEST_BAR(8);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief         Old path: every column whose level changed is written again,
+ *                a set cursor command before each of its two cells.
+ * @param[in]     Column levels: 0-16
+ * @param[in,out] Levels on the display
+ */
+static void test_oldPath(const uint8_t *levels, uint8_t *shown) {
+    for( uint8_t i=0; i<TEST_COLUMNS; i++ ) {
+        char top, bottom;
+        
+        if( levels[i] == shown[i] )
+            continue;
+        
+        test_cells(levels[i], &top, &bottom);
+        LCD1602_SetCursor(i, 0);
+        LCD1602_Write8((uint8_t)top, 1);
+        LCD1602_SetCursor(i, 1);
+        LCD1602_Write8((uint8_t)bottom, 1);
+        shown[i] = levels[i];
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     New path: the whole frame is put in the shadow frame and only
+ *            changed characters are sent.
+ * @param[in] Column levels: 0-16
+ */
+static void test_flushPath(const uint8_t *levels) {
+    for( uint8_t i=0; i<TEST_COLUMNS; i++ ) {
+        char top, bottom;
+        
+        test_cells(levels[i], &top, &bottom);
+        LCD1602_PutChar(i, 0, top);
+        LCD1602_PutChar(i, 1, bottom);
+    }
+    LCD1602_Flush();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Compare the columns shown by the LCD with the levels.
+ * @param[in] Column levels: 0-16
+ * @return    Number of wrong columns
+ */
+static uint32_t test_wrong(const uint8_t *levels) {
+    uint32_t wrong = 0;
+    
+    for( uint8_t i=0; i<TEST_COLUMNS; i++ ) {
+        char top, bottom;
+        
+        test_cells(levels[i], &top, &bottom);
+        if( LCD_MODEL_Char(i, 0) != top || LCD_MODEL_Char(i, 1) != bottom )
+            wrong++;
+    }
+    return wrong;
+}
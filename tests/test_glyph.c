@@ -0,0 +1,181 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_glyph.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of custom characters: typical spectra are drawn by
+ *         display.c, glyph.c and lcd1602.c on the LCD model (lcd_model.c),
+ *         CGRAM uploads are counted per frame (GLYPH_GetUploads and the rows
+ *         written to CGRAM must agree) and every column shown by the LCD,
+ *         decoded from DDRAM and CGRAM, must be the bar of its level with at
+ *         most a peak marker above it. Levels are not smoothed
+ *         (DISPLAY_SMOOTH 0), so the bar is the given level.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "lcd1602.h"
+#include "glyph.h"
+#include "display.h"
+#include "timer.h"
+#include "level.h"
+#include "lcd_model.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of every spectrum and frame rate of mode 1 */
+#define TEST_FRAMES              (2000)
+#define TEST_FRAME_RATE          (312)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const char *Test_Spectra[] = {
+    "steady",          /* the same levels every frame */
+    "music",           /* falling slope which moves slowly */
+    "sweep",           /* one strong column moving over the others */
+    "noise"            /* random levels every frame */
+};
+
+static uint32_t test_failed = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void test_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels);
+static uint8_t test_column(uint8_t col, uint8_t level);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    LcdModelCounters counters;
+    uint8_t rows[8];
+    
+    /* as main.c: bars of 1-8 strips in slots 0-7 */
+    TIMER_Init();
+    LCD1602_Init();
+    LCD1602_LVL_CH();
+    GLYPH_Reset();
+    LCD1602_ClearAll();
+    I2C_Wait();
+    for( uint8_t slot=0; slot<GLYPH_SLOTS; slot++ ) {
+        LCD_MODEL_Rows((char)slot, rows);
+        for( uint8_t row=0; row<8; row++ )
+            TEST_CHECK(rows[row] == (row >= 7 - slot ? 0x1F : 0x00));
+    }
+    DISPLAY_SetFrameRate(TEST_FRAME_RATE);
+    
+    printf("%-8s %14s %8s %12s\n", "spectrum", "uploads/frame", "max", "wrong cols");
+    for( uint8_t s=0; s<sizeof(Test_Spectra)/sizeof(Test_Spectra[0]); s++ ) {
+        uint32_t uploads = 0, most = 0, wrong = 0;
+        
+        DISPLAY_Reset();
+        for( uint32_t frame=0; frame<TEST_FRAMES; frame++ ) {
+            uint8_t levels[DISPLAY_COLUMNS];
+            uint32_t before = GLYPH_GetUploads();
+            uint32_t loaded;
+            
+            test_levels(s, frame, levels);
+            LCD_MODEL_Reset();
+            DISPLAY_Submit(levels);
+            TEST_CHECK(DISPLAY_Service() == 1);
+            I2C_Wait();
+            LCD_MODEL_Get(&counters);
+            
+            /* every upload is one character of eight rows */
+            loaded = GLYPH_GetUploads() - before;
+            TEST_CHECK(counters.cgramWrites == 8*loaded);
+            TEST_CHECK(loaded <= GLYPH_SLOTS);
+            uploads += loaded;
+            if( loaded > most )
+                most = loaded;
+            
+            for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+                if( !test_column(i, levels[i]) && wrong++ < 5 )
+                    printf("%s frame %lu column %d: level %d drawn wrong\n", Test_Spectra[s],
+                           (unsigned long)frame, i, levels[i]);
+            }
+        }
+        TEST_CHECK(wrong == 0);
+        
+        printf("%-8s %14.2f %8lu %12lu\n", Test_Spectra[s], (double)uploads/TEST_FRAMES,
+               (unsigned long)most, (unsigned long)wrong);
+    }
+    
+    printf("test_glyph: %lu failed\n", (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Levels of a frame of a test spectrum.
+ * @param[in]  Spectrum (Test_Spectra)
+ * @param[in]  Frame number
+ * @param[out] Column levels: 0-16
+ */
+static void test_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels) {
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        int32_t level;
+        
+        switch( spectrum ) {
+            case 0:
+                level = 14 - i*3/4;
+                break;
+            case 1:
+                level = 15 - i*3/4 + (int32_t)((frame/40 + i*7) % 5) - 2;
+                break;
+            case 2:
+                level = (i == (frame/25) % DISPLAY_COLUMNS) ? 15 : 3 + (i & 1);
+                break;
+            default:
+                level = rand() % (LEVEL_MAX + 1);
+                break;
+        }
+        levels[i] = (uint8_t)(level < 0 ? 0 : level > LEVEL_MAX ? LEVEL_MAX : level);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Decode a column shown by the LCD (two cells, bottom one in the
+ *            second row) and check it: strips up to the level are lit, above
+ *            it at most one strip (peak marker).
+ * @param[in] Column number
+ * @param[in] Level: 0-16
+ * @return    1 if the column is right
+ */
+static uint8_t test_column(uint8_t col, uint8_t level) {
+    uint8_t extra = 0;
+    
+    for( uint8_t cell=0; cell<2; cell++ ) {
+        uint8_t rows[8];
+        
+        if( !LCD_MODEL_Rows(LCD_MODEL_Char(col, (uint8_t)(1 - cell)), rows) )
+            return 0;
+        for( uint8_t row=0; row<8; row++ ) {
+            /* strips are counted from the bottom, 1-16 */
+            uint8_t strip = (uint8_t)(cell*8 + 8 - row);
+            
+            if( rows[row] != 0x00 && rows[row] != 0x1F )
+                return 0;
+            if( strip <= level && rows[row] != 0x1F )
+                return 0;
+            if( strip > level && rows[row] == 0x1F )
+                extra++;
+        }
+    }
+    return extra <= 1;
+}
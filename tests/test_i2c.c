@@ -0,0 +1,283 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_i2c.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the background I2C transmission (I2C_ASYNC) against a 
+ *         simulated I2C0: bytes take a few bus ticks, a 
+ *         stop condition keeps the bus busy for a while and raises STOPF. 
+ *         The test checks that transactions come out in order, that a start
+ *         is never sent while the bus is busy, and NACK and timeout errors, 
+ *         both with I2C0 interrupt and by polling. The registers are written 
+ *         through I2C_ModelWrite (I2C_MODEL): flags of S and FLT are write 1
+ *         to clear like on the chip, a write to D starts a byte.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "i2c.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* bus ticks of one byte (with acknowledge) and of a stop condition */
+#define BUS_BYTE_TICKS           (5)
+#define BUS_STOP_TICKS           (20)
+/* S: IICIF and ARBL are write 1 to clear, the rest is read-only; 
+   FLT: STOPF is write 1 to clear */
+#define MODEL_S_W1C              (I2C_S_IICIF_MASK | I2C_S_ARBL_MASK)
+#define MODEL_S_RO               ((uint8_t)~MODEL_S_W1C)
+#define MODEL_FLT_W1C            (I2C_FLT_STOPF_MASK)
+/* transactions of a run and the expander address */
+#define TEST_TRANSFERS           (30)
+#define TEST_ADDRESS             (0x27)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* bus: interrupt enabled in NVIC, CPU busy at the same priority (keypad), 
+   previous master bit, remaining ticks of the byte and of the stop */
+static uint8_t bus_irqEnabled = 0;
+static uint8_t bus_masked = 0;
+static uint8_t bus_master = 0;
+static uint16_t bus_byteTicks = 0;
+static uint16_t bus_stopTicks = 0;
+/* byte written to D is being shifted out */
+static uint8_t bus_written = 0;
+/* device does not respond, byte number which is not acknowledged */
+static uint8_t bus_dead = 0;
+static int32_t bus_nackAt = -1;
+/* bytes seen on the bus */
+static uint8_t bus_log[8192];
+static uint32_t bus_logged = 0;
+/* starts sent while the bus was busy, interrupts of stop detection */
+static uint32_t bus_busyStarts = 0;
+static uint32_t bus_stopIrqs = 0;
+
+static uint32_t test_failed = 0;
+static uint32_t test_callbacks = 0;
+static uint8_t test_errors[TEST_TRANSFERS];
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+void I2C0_IRQHandler(void);
+static uint8_t model_flags(uint8_t reg, uint8_t value, uint8_t w1c, uint8_t ro);
+static void bus_tick(void);
+static void bus_deliver(void);
+static void test_done(uint8_t errors);
+static void test_run(uint8_t polled);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief NVIC of I2C0: enabling lets a pending interrupt in, both let the bus
+ *        run (the driver calls them while polling).
+ */
+void NVIC_EnableIRQ(IRQn_Type irq) {
+    if( irq == I2C0_IRQn ) {
+        bus_irqEnabled = 1;
+        bus_deliver();
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq) {
+    if( irq == I2C0_IRQn ) {
+        bus_irqEnabled = 0;
+        bus_tick();
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Write of a flag or data register by the driver.
+ * @param[in] Register
+ * @param[in] Value written
+ */
+void I2C_ModelWrite(volatile uint8_t *reg, uint8_t value) {
+    if( reg == &I2C0->S )
+        I2C0->S = model_flags(I2C0->S, value, MODEL_S_W1C, MODEL_S_RO);
+    else if( reg == &I2C0->FLT )
+        I2C0->FLT = model_flags(I2C0->FLT, value, MODEL_FLT_W1C, 0);
+    else {
+        *reg = value;
+        if( reg == &I2C0->D )
+            bus_written = 1;
+    }
+}
+
+int main(void) {
+    uint8_t data[8];
+    
+    I2C_Init();
+    
+    /* interrupt driven, then by polling from an interrupt of the same priority */
+    test_run(0);
+    test_run(1);
+    
+    /* second byte (first data byte) is not acknowledged, next transaction 
+       is sent anyway */
+    memset(data, 0x55, sizeof(data));
+    test_callbacks = 0;
+    bus_nackAt = (int32_t)bus_logged + 1;
+    I2C_WriteBlockAsync(TEST_ADDRESS, 5, data, test_done);
+    I2C_WriteBlockAsync(TEST_ADDRESS, 3, data, test_done);
+    I2C_Wait();
+    bus_nackAt = -1;
+    TEST_CHECK(test_callbacks == 2);
+    TEST_CHECK(test_errors[0] == I2C_ERR_NOACK && test_errors[1] == 0);
+    TEST_CHECK(I2C_GetAsyncErrors() == I2C_ERR_NOACK);
+    
+    /* bus does not move */
+    test_callbacks = 0;
+    bus_dead = 1;
+    I2C_WriteBlockAsync(TEST_ADDRESS, 5, data, test_done);
+    I2C_Wait();
+    bus_dead = 0;
+    bus_written = 0;
+    TEST_CHECK(test_callbacks == 1 && test_errors[0] == I2C_ERR_TIMEOUT);
+    TEST_CHECK(!I2C_IsBusy());
+    TEST_CHECK(I2C_GetAsyncErrors() == I2C_ERR_TIMEOUT);
+    
+    TEST_CHECK(bus_busyStarts == 0);
+    printf("test_i2c: %lu bytes, %lu stop interrupts, %lu starts on busy bus, "
+           "%lu failed\n", (unsigned long)bus_logged, (unsigned long)bus_stopIrqs,
+           (unsigned long)bus_busyStarts, (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     New value of a flag register: W1C bits are cleared by writing 1,
+ *            RO bits are not changed by writes, the others are plain memory;
+ *            read-modify-write (|=) clears every set flag, as on the chip.
+ * @param[in] Value of the register
+ * @param[in] Value written
+ * @param[in] Write 1 to clear bits
+ * @param[in] Read-only bits
+ * @return    Value of the register after the write
+ */
+static uint8_t model_flags(uint8_t reg, uint8_t value, uint8_t w1c, uint8_t ro) {
+    return (uint8_t)((reg & ro) | (value & ~(ro | w1c)) | (reg & w1c & ~value));
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief One bus tick: start and stop conditions follow the master bit, a 
+ *        written byte is shifted out and acknowledged, the end of a stop 
+ *        frees the bus and sets STOPF (and IICIF if STOPIE is set).
+ */
+static void bus_tick(void) {
+    uint8_t master = I2C0->C1 & I2C_C1_MST_MASK;
+    
+    if( master && !bus_master ) {
+        if( I2C0->S & I2C_S_BUSY_MASK )
+            bus_busyStarts++;
+        I2C0->S |= I2C_S_BUSY_MASK;
+        bus_stopTicks = 0;
+    }
+    else if( !master && bus_master )
+        bus_stopTicks = BUS_STOP_TICKS;
+    bus_master = master;
+    
+    if( bus_stopTicks != 0 && --bus_stopTicks == 0 ) {
+        I2C0->S &= ~I2C_S_BUSY_MASK;
+        I2C0->FLT |= I2C_FLT_STOPF_MASK;
+        if( I2C0->FLT & I2C_FLT_STOPIE_MASK )
+            I2C0->S |= I2C_S_IICIF_MASK;
+    }
+    
+    if( bus_written && !bus_dead && ++bus_byteTicks >= BUS_BYTE_TICKS ) {
+        bus_byteTicks = 0;
+        bus_written = 0;
+        if( (int32_t)bus_logged == bus_nackAt )
+            I2C0->S |= I2C_S_RXAK_MASK;
+        else
+            I2C0->S &= ~I2C_S_RXAK_MASK;
+        I2C0->S |= I2C_S_IICIF_MASK;
+        if( bus_logged < sizeof(bus_log) )
+            bus_log[bus_logged] = I2C0->D;
+        bus_logged++;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Bus tick and I2C0 interrupt if it is pending and can be taken.
+ */
+static void bus_deliver(void) {
+    bus_tick();
+    
+    if( !bus_irqEnabled || bus_masked || !(I2C0->C1 & I2C_C1_IICIE_MASK) )
+        return;
+    if( I2C0->S & I2C_S_IICIF_MASK ) {
+        if( (I2C0->FLT & I2C_FLT_STOPF_MASK) && (I2C0->FLT & I2C_FLT_STOPIE_MASK) )
+            bus_stopIrqs++;
+        I2C0_IRQHandler();
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Transaction finished.
+ * @param[in] Errors of the transaction
+ */
+static void test_done(uint8_t errors) {
+    if( test_callbacks < TEST_TRANSFERS )
+        test_errors[test_callbacks] = errors;
+    test_callbacks++;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Queue TEST_TRANSFERS transactions of different length while the
+ *            bus runs and check the bytes on the bus.
+ * @param[in] 1 - I2C0 interrupt can not be taken, queue is served by polling
+ */
+static void test_run(uint8_t polled) {
+    static uint8_t expected[sizeof(bus_log)];
+    uint32_t count = 0;
+    uint32_t first = bus_logged;
+    uint8_t data[80];
+    
+    test_callbacks = 0;
+    bus_masked = polled;
+    for( uint8_t t=0; t<TEST_TRANSFERS; t++ ) {
+        uint8_t size = (uint8_t)(10 + t*7 % 60);
+        
+        for( uint8_t i=0; i<size; i++ )
+            data[i] = (uint8_t)(t*31 + i);
+        expected[count++] = TEST_ADDRESS << 1;
+        memcpy(&expected[count], data, size);
+        count += size;
+        
+        I2C_WriteBlockAsync(TEST_ADDRESS, size, data, test_done);
+        /* some transactions are queued while others are on the bus */
+        for( uint8_t k=0; k<37; k++ )
+            bus_deliver();
+        if( polled && t % 4 == 3 )
+            I2C_Wait();
+    }
+    if( polled )
+        I2C_Wait();
+    while( I2C_IsBusy() )
+        bus_deliver();
+    for( uint8_t k=0; k<BUS_STOP_TICKS; k++ )
+        bus_tick();
+    bus_masked = 0;
+    
+    TEST_CHECK(bus_logged - first == count);
+    TEST_CHECK(memcmp(&bus_log[first], expected, count) == 0);
+    TEST_CHECK(test_callbacks == TEST_TRANSFERS);
+    for( uint8_t t=0; t<TEST_TRANSFERS; t++ )
+        TEST_CHECK(test_errors[t] == 0);
+    TEST_CHECK(I2C_GetAsyncErrors() == 0);
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_level.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the integer magnitude to bar level mapping: every 
+ *         magnitude below 2^22 is compared with the original log10 formula 
+ *         of FFT_PrintColumns, levels may differ by one (rounding of the
+ *         table) but never more.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "level.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* magnitudes checked: 1 to TEST_RANGE-1 */
+#define TEST_RANGE               (1u << 22)
+/* largest error of LEVEL_Log2 (Q8) allowed against log2 */
+#define TEST_LOG2_ERROR          (2)
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static int32_t test_oldFormula(uint32_t mag);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    uint32_t offByOne = 0;
+    uint32_t failed = 0;
+    int32_t maxLog2Error = 0;
+    
+    for( uint32_t mag=1; mag<TEST_RANGE; mag++ ) {
+        int32_t expected = test_oldFormula(mag);
+        int32_t level = LEVEL_FromMagnitude(mag);
+        int32_t error = LEVEL_Log2(mag) - (int32_t)lround(log2((double)mag) * 256);
+        
+        if( abs(error) > maxLog2Error )
+            maxLog2Error = abs(error);
+        
+        if( level == expected )
+            continue;
+        if( abs(level - expected) == 1 ) {
+            offByOne++;
+            continue;
+        }
+        if( failed++ < 10 )
+            printf("magnitude %lu: level %ld, log10 formula %ld\n", 
+                   (unsigned long)mag, (long)level, (long)expected);
+    }
+    
+    printf("test_level: %lu magnitudes, %lu one level off, %lu worse, "
+           "log2 error %ld/256\n", (unsigned long)(TEST_RANGE-1), 
+           (unsigned long)offByOne, (unsigned long)failed, (long)maxLog2Error);
+    
+    return (failed == 0 && maxLog2Error <= TEST_LOG2_ERROR) ? 0 : 1;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Bar level calculated like in the original FFT_PrintColumns.
+ * @param[in] Magnitude
+ * @return    Bar level: 0-16
+ */
+static int32_t test_oldFormula(uint32_t mag) {
+    int32_t lvl = (int32_t)floor(log10((double)mag) * 16 / 3.5) - 9;
+    
+    return lvl < 0 ? 0 : lvl > LEVEL_MAX ? LEVEL_MAX : lvl;
+}
@@ -0,0 +1,231 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_modes.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of bin placement per mode: a tone stepped over the 
+ *         frequencies of all 16 columns of every mode goes through ADC0 interrupt (DC
+ *         removal, CIC decimation of modes 2-3, queue) and FFT_ProcessBuffer
+ *         as in the main loop. The strongest bin must be the bin of the tone
+ *         at the sample rate of the mode and the column of the tone must be
+ *         the highest one. After a mode change in the middle of a buffer the
+ *         first frame may come only when FFT_SIZE samples of the new mode
+ *         have been collected.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "ADC.h"
+#include "fft.h"
+#include "queue.h"
+#include "level.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of every tone, the last one is checked */
+#define TEST_FRAMES              (4)
+/* tone amplitude in ADC units, about -20 dB of the ADC range */
+#define TEST_AMPLITUDE           (200.0)
+/* mode 1 columns: half-octave bands from 80 Hz, same as Band_Edges in fft.c */
+#define TEST_HZ_TO_BIN(hz)       (((hz)*FFT_SIZE + FFT_SAMPLE_RATE/2)/FFT_SAMPLE_RATE)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* sample rate of every mode (after decimation), entry 0 is not used */
+static const uint32_t Test_Rates[FFT_MODES+1] = {0, 40000, 10000, 20000, 40000, 40000,
+    40000, 40000, 40000};
+static const uint32_t Band_Hz[17] = {80, 113, 160, 226, 320, 453, 640, 905, 1280,
+    1810, 2560, 3620, 5120, 7241, 10240, 14482, 20480};
+
+/* phase of the tone, it goes on across tones */
+static double test_phase = 0;
+static uint32_t test_failed = 0;
+static uint32_t test_tones = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+void ADC0_IRQHandler(void);
+static double test_columnHz(uint8_t mode, uint8_t column);
+static uint32_t test_run(double hz, uint32_t frames, uint32_t samples);
+static void test_restart(void);
+static void test_tone(uint8_t mode, uint8_t column);
+static void test_modeChange(void);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+/**-----------------------------------------------------------------------------
+ * @brief     Interrupt duration reported by ADC.c, not checked here.
+ * @param[in] Cycles
+ */
+void DIAG_IsrCycles(uint32_t cycles) {
+}
+
+int main(void) {
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    ADC_Start();
+    
+    for( uint8_t mode=1; mode<=FFT_MODES; mode++ ) {
+        FFTstatus.mode = mode;
+        for( uint8_t i=0; i<16; i++ )
+            test_tone(mode, i);
+    }
+    test_modeChange();
+    
+    printf("test_modes: %lu tones in %d modes, %lu failed\n", (unsigned long)test_tones,
+           FFT_MODES, (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Frequency of a column: the label of modes 2-8, 
+ *            ((Mode-2)*16+N+1)*156 Hz, or the middle of a half-octave band of
+ *            mode 1 (bands narrower than a bin get one bin).
+ * @param[in] Mode
+ * @param[in] Column: 0-15
+ * @return    Frequency in Hz
+ */
+static double test_columnHz(uint8_t mode, uint8_t column) {
+    uint16_t edge[2];
+    
+    if( mode != 1 )
+        return ((mode-2)*16 + column + 1)*(double)FFT_SAMPLE_RATE/FFT_SIZE;
+    
+    for( uint8_t k=0; k<2; k++ ) {
+        uint16_t bin = (uint16_t)TEST_HZ_TO_BIN(Band_Hz[column+k]);
+        
+        if( bin <= column+k+1 )
+            bin = column+k+1;
+        if( bin >= FFT_SIZE/2 )
+            bin = FFT_SIZE/2;
+        edge[k] = bin;
+    }
+    return (edge[0] + edge[1] - 1)/2.0*FFT_SAMPLE_RATE/FFT_SIZE;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Give a tone to ADC0 interrupt and process published buffers as
+ *            the main loop does, until the given number of frames or samples.
+ * @param[in] Frequency in Hz
+ * @param[in] Frames
+ * @param[in] Samples
+ * @return    Samples given
+ */
+static uint32_t test_run(double hz, uint32_t frames, uint32_t samples) {
+    uint32_t valid = 0;
+    uint32_t given = 0;
+    int8_t slot;
+    
+    while( valid < frames && given < samples ) {
+        test_phase += 2*M_PI*hz/FFT_SAMPLE_RATE;
+        ADC0->R[0] = (uint32_t)lround(FFT_AVG_VALUE + TEST_AMPLITUDE*sin(test_phase));
+        ADC0_IRQHandler();
+        given++;
+        
+        while( (slot = QUEUE_ReadSlot()) != QUEUE_NONE ) {
+            if( !QUEUE_IsContinuous() )
+                FFT_ResetHistory();
+            if( FFT_ProcessBuffer((uint8_t)slot) )
+                valid++;
+            QUEUE_Release();
+        }
+    }
+    return given;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Start again as the main loop does after a key (MODE_Restart): drop
+ *        the queued frames and forget the sample history.
+ */
+static void test_restart(void) {
+    while( QUEUE_ReadSlot() != QUEUE_NONE )
+        QUEUE_Release();
+    FFT_ResetHistory();
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Play a tone in the centre of a column and check the strongest bin
+ *            and the highest column of the last frame.
+ * @param[in] Mode
+ * @param[in] Column: 0-15
+ */
+static void test_tone(uint8_t mode, uint8_t column) {
+    double hz = test_columnHz(mode, column);
+    double centre = hz*FFT_SIZE/Test_Rates[mode];
+    int32_t peakPower = -1;
+    uint16_t peakBin = 0;
+    uint8_t peakLevel = 0;
+    
+    test_restart();
+    test_run(hz, TEST_FRAMES, UINT32_MAX);
+    test_tones++;
+    
+    for( uint16_t k=1; k<FFT_SIZE/2; k++ ) {
+        int32_t re = (int32_t)FFT_Output[2*k];
+        int32_t im = (int32_t)FFT_Output[2*k+1];
+        
+        if( re*re + im*im > peakPower ) {
+            peakPower = re*re + im*im;
+            peakBin = k;
+        }
+    }
+    for( uint8_t i=0; i<16; i++ ) {
+        if( FrequencyBins[i] > peakLevel )
+            peakLevel = FrequencyBins[i];
+    }
+    
+    /* strongest bin is the tone at the sample rate of the mode (one of the 
+       two middle bins of a band) */
+    TEST_CHECK(fabs(peakBin - centre) <= 0.5);
+    /* the column of the tone is the highest one, leakage reaches only the
+       neighbours */
+    TEST_CHECK(peakLevel > 0 && FrequencyBins[column] == peakLevel);
+    for( uint8_t i=0; i<16; i++ ) {
+        if( i+1 < column || i > column+1 )
+            TEST_CHECK(FrequencyBins[i] < peakLevel);
+    }
+    if( fabs(peakBin - centre) > 0.5 || FrequencyBins[column] != peakLevel )
+        printf("mode %d column %d: strongest bin %d (tone %.1f), level %d of %d\n",
+               mode, column, peakBin, centre, FrequencyBins[column], peakLevel);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Change the mode in the middle of a buffer from full rate (mode 4) to
+ *        the most decimated one (mode 2): the buffer in progress is started
+ *        again, so the first frame needs FFT_SIZE samples of the new mode.
+ */
+static void test_modeChange(void) {
+    double hz = test_columnHz(4, 3);
+    uint32_t given;
+    
+    /* frames end with a full buffer, half of the next one is filled */
+    FFTstatus.mode = 4;
+    test_restart();
+    test_run(hz, TEST_FRAMES, UINT32_MAX);
+    test_run(hz, UINT32_MAX, FFT_HOP_SIZE/2);
+    
+    FFTstatus.mode = 2;
+    test_restart();
+    hz = test_columnHz(2, 9);
+    given = test_run(hz, 1, UINT32_MAX);
+    test_tones++;
+    
+    TEST_CHECK(given >= (FFT_SIZE << 2));
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_overlap.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of overlapped frames (FFT_HOP_SIZE): a continuous ramp
+ *         and a tone are given to FFT_ProcessBuffer in buffers of
+ *         FFT_HOP_SIZE samples, and the FFT of every frame must be equal to
+ *         the FFT of the contiguous window of the last FFT_SIZE samples. The
+ *         first frame may come only with the FFT_SIZE/FFT_HOP_SIZE-th buffer,
+ *         also after FFT_ResetHistory. Built once per tested FFT_HOP_SIZE.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "fft.h"
+#include "window.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* buffers of every test signal, history is reset after TEST_RESET_AT */
+#define TEST_BUFFERS             (64)
+#define TEST_RESET_AT            (37)
+/* buffers needed for a full frame */
+#define TEST_FILL                (FFT_SIZE/FFT_HOP_SIZE)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* all captured samples of a signal */
+static fft_capture_t test_stream[TEST_BUFFERS*FFT_HOP_SIZE];
+static uint32_t test_failed = 0;
+static uint32_t test_frames = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void test_signal(uint8_t tone);
+static uint8_t test_frame(uint32_t end);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    FFTstatus.mode = 1;
+    
+    test_signal(0);
+    test_signal(1);
+    
+    printf("test_overlap (hop %d): %lu frames equal to contiguous windows, "
+           "%lu failed\n", FFT_HOP_SIZE, (unsigned long)test_frames,
+           (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Give a signal to FFT_ProcessBuffer buffer by buffer and check
+ *            when frames come and what is in them.
+ * @param[in] 0 - ramp, 1 - tone
+ */
+static void test_signal(uint8_t tone) {
+    uint32_t since = 0;
+    
+    for( uint32_t n=0; n<TEST_BUFFERS*FFT_HOP_SIZE; n++ ) {
+        int32_t x = tone ? (int32_t)lround(1500*sin(2*M_PI*n*0.0371))
+                         : (int32_t)(n*7 % 4000) - 2000;
+        
+        test_stream[n] = FFT_TO_SAMPLE(x);
+    }
+    
+    FFT_ResetHistory();
+    for( uint32_t b=0; b<TEST_BUFFERS; b++ ) {
+        uint8_t buffer = (uint8_t)(b % FFT_BUFFERS);
+        uint8_t valid;
+        
+        if( b == TEST_RESET_AT ) {
+            FFT_ResetHistory();
+            since = 0;
+        }
+        memcpy(FFT_Buffer[buffer], &test_stream[b*FFT_HOP_SIZE], sizeof(FFT_Buffer[0]));
+        valid = FFT_ProcessBuffer(buffer);
+        since++;
+        
+        /* frames come from the TEST_FILL-th buffer after a reset */
+        TEST_CHECK(valid == (since >= TEST_FILL));
+        if( valid )
+            TEST_CHECK(test_frame((b+1)*FFT_HOP_SIZE));
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Compare FFT_Output with the FFT of the contiguous window which
+ *            ends at given sample.
+ * @param[in] Number of the sample after the window
+ * @return    1 if equal
+ */
+static uint8_t test_frame(uint32_t end) {
+    static arm_rfft_instance_q15 fft;
+    q15_t frame[FFT_SIZE];
+    q15_t output[2*FFT_SIZE];
+    
+    arm_rfft_init_q15(&fft, FFT_SIZE, 0, 1);
+    for( uint16_t i=0; i<FFT_SIZE; i++ )
+        frame[i] = FFT_WINDOW_SAMPLE(test_stream[end - FFT_SIZE + i], WINDOW_Coeff(i));
+    arm_rfft_q15(&fft, frame, output);
+    
+    test_frames++;
+    return memcmp(output, FFT_Output, (FFT_SIZE+2)*sizeof(q15_t)) == 0;
+}
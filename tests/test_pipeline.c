@@ -0,0 +1,161 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_pipeline.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the fixed-point pipeline against the float16_t one:
+ *         the same synthetic frames (tones of different level and frequency
+ *         with noise) go through FFT_ProcessBuffer in every mode, column
+ *         levels may differ by one but never more. The file is built once
+ *         per FFT_FIXED_POINT; the float16_t build prints its levels ("-p")
+ *         and the Q15 build reads them from TEST_REFERENCE. Levels use the
+ *         fixed range (LEVEL_AGC 0), so every frame is compared on its own.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "fft.h"
+#include "level.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of every mode */
+#define TEST_FRAMES              (96)
+/* command printing levels of the other pipeline */
+#ifndef TEST_REFERENCE
+#define TEST_REFERENCE           "./test_pipeline_f16 -p"
+#endif
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+/* levels of all frames of all modes */
+static uint8_t test_levels[FFT_MODES][TEST_FRAMES][16];
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void test_fillBuffer(uint8_t buffer, uint8_t mode, uint32_t frame, uint16_t hop);
+static uint8_t test_compare(FILE *reference);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    FILE *reference;
+    uint8_t failed;
+    
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    
+    /* frames of a mode are continuous, history starts with the mode */
+    for( uint8_t mode=1; mode<=FFT_MODES; mode++ ) {
+        FFTstatus.mode = mode;
+        FFT_ResetHistory();
+        
+        for( uint32_t frame=0, hop=0; frame<TEST_FRAMES; hop++ ) {
+            uint8_t buffer = (uint8_t)(hop % FFT_BUFFERS);
+            
+            test_fillBuffer(buffer, mode, frame, (uint16_t)(hop % (FFT_SIZE/FFT_HOP_SIZE)));
+            if( FFT_ProcessBuffer(buffer) )
+                memcpy(test_levels[mode-1][frame++], FrequencyBins, 16);
+        }
+    }
+    
+    if( argc > 1 && strcmp(argv[1], "-p") == 0 ) {
+        for( uint8_t m=0; m<FFT_MODES; m++ ) {
+            for( uint32_t f=0; f<TEST_FRAMES; f++ ) {
+                for( uint8_t i=0; i<16; i++ )
+                    printf("%d ", test_levels[m][f][i]);
+                printf("\n");
+            }
+        }
+        return 0;
+    }
+    
+    if( (reference = popen(TEST_REFERENCE, "r")) == NULL ) {
+        printf("test_pipeline: cannot run %s\n", TEST_REFERENCE);
+        return 1;
+    }
+    failed = test_compare(reference);
+    pclose(reference);
+    
+    return failed;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Fill a buffer with the next FFT_HOP_SIZE samples of a frame: a
+ *            tone which changes every frame (frequency over the whole range
+ *            of the mode, level from -6 to -66 dB of the ADC range), a
+ *            weaker second tone and noise.
+ * @param[in] Buffer number
+ * @param[in] Mode
+ * @param[in] Frame number
+ * @param[in] Part of the frame: 0 to FFT_SIZE/FFT_HOP_SIZE-1
+ */
+static void test_fillBuffer(uint8_t buffer, uint8_t mode, uint32_t frame, uint16_t hop) {
+    static uint32_t seed = 1;
+    double rate = FFT_SAMPLE_RATE >> FFT_Modes[mode].decimationShift;
+    double f1 = rate/2 * (frame*37 % TEST_FRAMES + 0.5)/TEST_FRAMES;
+    double f2 = rate/2 * (frame*11 % TEST_FRAMES + 0.3)/TEST_FRAMES;
+    double a1 = 2048*pow(10, -(6 + 60.0*(frame*53 % TEST_FRAMES)/TEST_FRAMES)/20);
+    
+    for( uint16_t i=0; i<FFT_HOP_SIZE; i++ ) {
+        double t = (hop*FFT_HOP_SIZE + i)/rate;
+        double x = a1*sin(2*M_PI*f1*t) + a1/8*sin(2*M_PI*f2*t + 1);
+        
+        seed = seed*1103515245u + 12345u;
+        x += (double)((seed >> 16) & 0xF) - 7.5;
+        FFT_Buffer[buffer][i] = FFT_TO_SAMPLE(lround(x));
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Compare levels with the other pipeline.
+ * @param[in] Levels printed by the other pipeline
+ * @return    1 if a column differs by more than one level
+ */
+static uint8_t test_compare(FILE *reference) {
+    uint32_t same = 0, offByOne = 0, worse = 0, lit = 0;
+    
+    for( uint8_t m=0; m<FFT_MODES; m++ ) {
+        for( uint32_t f=0; f<TEST_FRAMES; f++ ) {
+            for( uint8_t i=0; i<16; i++ ) {
+                int level;
+                int diff;
+                
+                if( fscanf(reference, "%d", &level) != 1 ) {
+                    printf("test_pipeline: reference levels missing\n");
+                    return 1;
+                }
+                diff = abs(level - test_levels[m][f][i]);
+                if( level != 0 )
+                    lit++;
+                if( diff == 0 )
+                    same++;
+                else if( diff == 1 )
+                    offByOne++;
+                else if( worse++ < 10 )
+                    printf("mode %d frame %lu column %d: level %d, float16_t %d\n",
+                           m+1, (unsigned long)f, i, test_levels[m][f][i], level);
+            }
+        }
+    }
+    
+    printf("test_pipeline: %lu columns (%lu lit), %lu same, %lu one level off, "
+           "%lu worse\n", (unsigned long)(same+offByOne+worse), (unsigned long)lit,
+           (unsigned long)same, (unsigned long)offByOne, (unsigned long)worse);
+    
+    return (worse == 0 && lit != 0) ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_power.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of the power-domain columns (FFT_BinPower): levels of
+ *         FFT_CalculateColumns_256 are compared with levels of the old path
+ *         on the same FFT output, where magnitudes of the whole spectrum are
+ *         calculated with a square root (arm_cmplx_mag) and a column is the
+ *         magnitude of its bins, mapped by LEVEL_FromLog2 with an exact
+ *         log2. Folding the square root into the mapping is exact 
+ *         (LEVEL_FromLog2Power of 2*x is LEVEL_FromLog2 of x), so 
+ *         columns can differ only where rounding of log2 (1/256 octave) 
+ *         falls across a level boundary, by one level. Operations per frame of both
+ *         paths are counted for every mode.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "fft.h"
+#include "level.h"
+#include "window.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of every mode */
+#define TEST_FRAMES              (200)
+/* bins of the old magnitude pass (arm_cmplx_mag_f16 on FFT_SIZE values) */
+#define TEST_OLD_BINS            (FFT_SIZE)
+
+/* mode 1 columns: half-octave bands from 80 Hz, same as Band_Edges in fft.c */
+#define TEST_HZ_TO_BIN(hz)       (((hz)*FFT_SIZE + FFT_SAMPLE_RATE/2)/FFT_SAMPLE_RATE)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const uint32_t Band_Hz[17] = {80, 113, 160, 226, 320, 453, 640, 905, 1280,
+    1810, 2560, 3620, 5120, 7241, 10240, 14482, 20480};
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static uint32_t test_fold(void);
+static void test_columnBins(uint8_t mode, uint8_t column, uint16_t *first, uint16_t *count);
+static uint8_t test_oldLevel(uint16_t first, uint16_t count);
+static void test_fillBuffer(uint8_t mode, uint32_t frame, uint16_t hop);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    uint32_t same = 0, offByOne = 0, worse = 0, lit = 0;
+    uint32_t folded;
+    
+    if( FFT_Init() != ARM_MATH_SUCCESS )
+        return 1;
+    folded = test_fold();
+    
+    printf("mode  old: mul  add  sqrt   new: mul  add  sqrt   (per frame)\n");
+    for( uint8_t mode=1; mode<=FFT_MODES; mode++ ) {
+        uint32_t bins = 0;
+        
+        FFTstatus.mode = mode;
+        FFT_ResetHistory();
+        
+        for( uint32_t frame=0, hop=0; frame<TEST_FRAMES; hop++ ) {
+            test_fillBuffer(mode, frame, (uint16_t)(hop % (FFT_SIZE/FFT_HOP_SIZE)));
+            if( !FFT_ProcessBuffer(0) )
+                continue;
+            
+            for( uint8_t i=0; i<16; i++ ) {
+                uint16_t first, count;
+                uint8_t old;
+                
+                test_columnBins(mode, i, &first, &count);
+                old = test_oldLevel(first, count);
+                if( old != 0 )
+                    lit++;
+                if( old == FrequencyBins[i] )
+                    same++;
+                else if( abs(old - FrequencyBins[i]) == 1 )
+                    offByOne++;
+                else if( worse++ < 10 )
+                    printf("mode %d frame %lu column %d: level %d, sqrt path %d\n",
+                           mode, (unsigned long)frame, i, FrequencyBins[i], old);
+            }
+            frame++;
+        }
+        
+        /* old: re^2, im^2, sum and sqrt of every bin; new: the same without
+           sqrt, only for bins of the columns (summed into columns) */
+        for( uint8_t i=0; i<16; i++ ) {
+            uint16_t first, count;
+            
+            test_columnBins(mode, i, &first, &count);
+            bins += count;
+        }
+        printf("%4d  %9d %4d %5d  %9lu %4lu %5d\n", mode, 2*TEST_OLD_BINS,
+               TEST_OLD_BINS, TEST_OLD_BINS, (unsigned long)(2*bins),
+               (unsigned long)(2*bins - 16), 0);
+    }
+    
+    printf("test_power: %lu columns (%lu lit), %lu same, %lu one level off, "
+           "%lu worse; %lu log2 values mapped differently\n", 
+           (unsigned long)(same+offByOne+worse), (unsigned long)lit, (unsigned long)same,
+           (unsigned long)offByOne, (unsigned long)worse, (unsigned long)folded);
+    
+    return (worse == 0 && folded == 0 && lit != 0) ? 0 : 1;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief  Compare the power mapping with the magnitude one for every log2 of a
+ *         magnitude from -8 to 64 (Q8).
+ * @return Number of values where they differ
+ */
+static uint32_t test_fold(void) {
+    uint32_t failed = 0;
+    
+    for( int32_t x=-8*256; x<64*256; x++ ) {
+        if( LEVEL_FromLog2Power(2*x) != LEVEL_FromLog2(x) )
+            failed++;
+    }
+    return failed;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Bins of a column, as in FFT_CalculateColumns_256.
+ * @param[in]  Mode
+ * @param[in]  Column: 0-15
+ * @param[out] First bin
+ * @param[out] Number of bins
+ */
+static void test_columnBins(uint8_t mode, uint8_t column, uint16_t *first, uint16_t *count) {
+    if( mode == 1 ) {
+        uint16_t edge[2];
+        
+        for( uint8_t k=0; k<2; k++ ) {
+            uint16_t bin = (uint16_t)TEST_HZ_TO_BIN(Band_Hz[column+k]);
+            
+            if( bin <= column+k+1 )
+                bin = column+k+1;
+            if( bin >= FFT_SIZE/2 )
+                bin = FFT_SIZE/2;
+            edge[k] = bin;
+        }
+        *first = edge[0];
+        *count = edge[1] - edge[0];
+    }
+    else {
+        *first = FFT_Modes[mode].firstBin + column*FFT_Modes[mode].binsPerColumn;
+        *count = FFT_Modes[mode].binsPerColumn;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Level of a column calculated from magnitudes (square root of
+ *            every bin, float16_t pipeline scale) and exact log2.
+ * @param[in] First bin
+ * @param[in] Number of bins
+ * @return    Bar level: 0-16
+ */
+static uint8_t test_oldLevel(uint16_t first, uint16_t count) {
+    double sum = 0;
+    
+    for( uint16_t k=first; k<first+count; k++ ) {
+        double re = (double)FFT_Output[2*k]*FFT_Q15_BIN_SCALE;
+        double im = (double)FFT_Output[2*k+1]*FFT_Q15_BIN_SCALE;
+        double mag = sqrt(re*re + im*im);
+        
+        sum += mag*mag;
+    }
+    
+    /* magnitude of the column, window correction is given for power */
+    return LEVEL_FromLog2((int32_t)floor(log2(sqrt(sum))*256
+                                         + WINDOW_PowerCorrection()/2.0));
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Fill buffer 0 with the next FFT_HOP_SIZE samples of a frame: a
+ *            tone of a level and frequency which change every frame and
+ *            noise.
+ * @param[in] Mode
+ * @param[in] Frame number
+ * @param[in] Part of the frame: 0 to FFT_SIZE/FFT_HOP_SIZE-1
+ */
+static void test_fillBuffer(uint8_t mode, uint32_t frame, uint16_t hop) {
+    static uint32_t seed = 1;
+    double rate = FFT_SAMPLE_RATE >> FFT_Modes[mode].decimationShift;
+    double f = rate/2 * (frame*37 % TEST_FRAMES + 0.5)/TEST_FRAMES;
+    double a = 2048*pow(10, -(3 + 70.0*(frame*53 % TEST_FRAMES)/TEST_FRAMES)/20);
+    
+    for( uint16_t i=0; i<FFT_HOP_SIZE; i++ ) {
+        double x = a*sin(2*M_PI*f*(hop*FFT_HOP_SIZE + i)/rate);
+        
+        seed = seed*1103515245u + 12345u;
+        x += (double)((seed >> 16) & 0x7) - 3.5;
+        FFT_Buffer[0][i] = FFT_TO_SAMPLE(lround(x));
+    }
+}
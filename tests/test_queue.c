@@ -0,0 +1,182 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_queue.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host stress test of the sample buffer queue: producer and consumer
+ *         run in two threads like the sampling interrupt and the main loop.
+ *         Each frame carries its number and a pattern derived from it, the
+ *         consumer checks that frames come in order, are never torn 
+ *         (overwritten while taken) and that gaps are reported. Built once per QUEUE_POLICY.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "queue.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames offered by the producer */
+#define TEST_FRAMES              (1000000u)
+/* maximum busy wait after a frame and while the consumer holds a slot */
+#define PRODUCER_DELAY           (64)
+#define CONSUMER_DELAY           (256)
+
+/* sample i of frame n, samples 0 and 1 hold the frame number */
+#define TEST_SAMPLE(n, i)        ((fft_capture_t)(((n)*7u + (i)*13u) & 0x7FFF))
+
+/******************************************************************************
+ * Global variable definitions (normally in fft.c)
+ ******************************************************************************/
+
+fft_capture_t FFT_Buffer[FFT_BUFFERS][FFT_HOP_SIZE];
+FFT_Flags FFTstatus;
+const FFT_ModeInfo FFT_Modes[FFT_MODES+1];
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static volatile uint8_t test_done = 0;
+/* producer: published frames and frames refused by a full queue */
+static uint32_t test_published = 0;
+static uint32_t test_refused = 0;
+/* consumer */
+static uint32_t test_consumed = 0;
+static uint32_t test_last = 0;
+static uint32_t test_skipped = 0;
+static uint32_t test_disorder = 0;
+static uint32_t test_torn = 0;
+/* QUEUE_IsContinuous did not match the frame numbers */
+static uint32_t test_gaps = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void *test_producer(void *arg);
+static void test_consume(void);
+static void test_delay(uint32_t *seed, uint32_t max);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    pthread_t producer;
+    uint32_t failed;
+    
+    /* consumer spins on the queue, so the scheduler preempts it at any point,
+       also inside the queue functions */
+    pthread_create(&producer, NULL, test_producer, NULL);
+    while( !test_done )
+        test_consume();
+    pthread_join(producer, NULL);
+    /* frames left in the queue */
+    test_consume();
+    
+    /* every frame is consumed, overwritten (DROP_OLDEST) or refused (DROP_NEWEST),
+       frames missing between consumed ones are only these two */
+    failed = test_disorder + test_torn + test_gaps 
+             + (test_consumed + QUEUE_GetDroppedFrames() != test_published)
+             + (test_skipped + TEST_FRAMES - test_last != QUEUE_GetDroppedFrames() + test_refused)
+             + (test_published + test_refused != TEST_FRAMES);
+#if QUEUE_POLICY == QUEUE_DROP_NEWEST
+    failed += (QUEUE_GetDroppedFrames() != 0);
+#endif
+    
+    printf("test_queue (%s): %lu consumed, %lu skipped, %lu dropped, %lu refused, "
+           "%lu out of order, %lu torn, %lu gaps missed\n",
+           QUEUE_POLICY == QUEUE_DROP_OLDEST ? "drop oldest" : "drop newest",
+           (unsigned long)test_consumed, (unsigned long)test_skipped,
+           (unsigned long)QUEUE_GetDroppedFrames(), (unsigned long)test_refused, 
+           (unsigned long)test_disorder, (unsigned long)test_torn,
+           (unsigned long)test_gaps);
+    
+    return failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Producer thread: fills and publishes TEST_FRAMES frames. A frame
+ *            which gets no slot is refused as a whole (the interrupt would 
+ *            drop its samples one by one).
+ * @param[in] Not used
+ * @return    NULL
+ */
+static void *test_producer(void *arg) {
+    uint32_t seed = 1;
+    
+    for( uint32_t n=1; n<=TEST_FRAMES; n++ ) {
+        int8_t slot = QUEUE_WriteSlot();
+        
+        if( slot == QUEUE_NONE ) {
+            test_refused++;
+            test_delay(&seed, PRODUCER_DELAY);
+            continue;
+        }
+        FFT_Buffer[slot][0] = (fft_capture_t)(n & 0xFFFF);
+        FFT_Buffer[slot][1] = (fft_capture_t)(n >> 16);
+        for( uint16_t i=2; i<FFT_HOP_SIZE; i++ )
+            FFT_Buffer[slot][i] = TEST_SAMPLE(n, i);
+        QUEUE_Publish();
+        test_published++;
+        test_delay(&seed, PRODUCER_DELAY);
+    }
+    
+    __DMB();
+    test_done = 1;
+    return NULL;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Consumer: takes all waiting frames, checks their order and that 
+ *        samples were not changed before the slot was released.
+ */
+static void test_consume(void) {
+    static uint32_t seed = 2;
+    int8_t slot;
+    
+    while( (slot = QUEUE_ReadSlot()) != QUEUE_NONE ) {
+        uint32_t n = (uint16_t)FFT_Buffer[slot][0] | ((uint32_t)(uint16_t)FFT_Buffer[slot][1] << 16);
+        
+        test_gaps += QUEUE_IsContinuous() != (n == test_last + 1);
+        if( n <= test_last )
+            test_disorder++;
+        else
+            test_skipped += n - test_last - 1;
+        test_last = n;
+        
+        /* producer runs meanwhile, then samples are checked again */
+        for( uint16_t i=2; i<FFT_HOP_SIZE; i++ )
+            test_torn += FFT_Buffer[slot][i] != TEST_SAMPLE(n, i);
+        test_delay(&seed, CONSUMER_DELAY);
+        for( uint16_t i=2; i<FFT_HOP_SIZE; i++ )
+            test_torn += FFT_Buffer[slot][i] != TEST_SAMPLE(n, i);
+        
+        QUEUE_Release();
+        test_consumed++;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Random busy wait, sometimes gives up the CPU.
+ * @param[in] State of the generator
+ * @param[in] Maximum number of iterations
+ */
+static void test_delay(uint32_t *seed, uint32_t max) {
+    volatile uint32_t i;
+    
+    *seed = *seed*1103515245u + 12345u;
+    if( ((*seed >> 16) & 0xFF) == 0 )
+        sched_yield();
+    for( i=(*seed >> 16) % max; i>0; i-- )
+        ;
+}
@@ -0,0 +1,247 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_timing.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of LCD timing: the LCD model (lcd_model.c) knows HD44780
+ *         execution times (15 ms after power-on, 4.1 ms and 100 us after the
+ *         reset nibbles, 1.52 ms for clear and return home, 37 us for the
+ *         rest) and counts writes latched before the previous instruction
+ *         was executed. The model must catch a character sent right after
+ *         clear display; the boot sequence, clear display with text after
+ *         it and typical spectra drawn by display.c, glyph.c and lcd1602.c
+ *         (LCD1602_SendWait, LCD1602_WaitReady) must have no early write.
+ *         Boot time and bus time per frame are printed.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "lcd1602.h"
+#include "glyph.h"
+#include "display.h"
+#include "timer.h"
+#include "level.h"
+#include "lcd_model.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* frames of every spectrum and frame rate of mode 1 */
+#define TEST_FRAMES              (2000)
+#define TEST_FRAME_RATE          (312)
+/* model time in ms */
+#define TEST_MS(cycles)          (1000.0*(double)(cycles)/TIMER_CLOCK_HZ)
+/* PCF8574 connections to LCD, the same as in lcd1602.c */
+#define TEST_BL                  (0x08)
+#define TEST_EN                  (0x04)
+#define TEST_RS                  (0x01)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const char *Test_Spectra[] = {
+    "steady",          /* the same levels every frame */
+    "music",           /* falling slope which moves slowly */
+    "sweep",           /* one strong column moving over the others */
+    "noise"            /* random levels every frame */
+};
+
+static uint32_t test_failed = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static void test_model(void);
+static void test_clear(void);
+static void test_spectrum(uint8_t spectrum);
+static void test_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels);
+static uint8_t test_byte(uint8_t *bytes, uint8_t data, uint8_t rs);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    LcdModelCounters counters;
+    uint64_t start;
+    
+    /* boot sequence of main.c from power-on */
+    TIMER_Init();
+    start = LCD_MODEL_Now();
+    LCD_MODEL_Reset();
+    LCD1602_Init();
+    LCD1602_LVL_CH();
+    GLYPH_Reset();
+    LCD1602_ClearAll();
+    I2C_Wait();
+    LCD_MODEL_Get(&counters);
+    TEST_CHECK(counters.earlyWrites == 0);
+    printf("boot: %.2f ms, bus %.2f ms, %lu early writes\n", TEST_MS(LCD_MODEL_Now() - start),
+           TEST_MS(counters.busCycles), (unsigned long)counters.earlyWrites);
+    
+    test_model();
+    test_clear();
+    
+    DISPLAY_SetFrameRate(TEST_FRAME_RATE);
+    printf("%-8s %12s %12s %12s %8s\n", "spectrum", "bus ms/frm", "max ms", "frame share",
+           "early");
+    for( uint8_t s=0; s<sizeof(Test_Spectra)/sizeof(Test_Spectra[0]); s++ )
+        test_spectrum(s);
+    
+    printf("test_timing: %lu failed\n", (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Clear display and a character in one transaction, without waiting:
+ *        the model must count one early write, and none if the character
+ *        is sent 1.52 ms later.
+ */
+static void test_model(void) {
+    LcdModelCounters counters;
+    uint8_t bytes[8];
+    uint8_t size;
+    
+    I2C_Wait();
+    LCD_MODEL_Tick(TIMER_US(2000));
+    LCD_MODEL_Reset();
+    size = test_byte(bytes, 0x01, 0);
+    size += test_byte(&bytes[size], 'A', 1);
+    I2C_WriteBlockAsync(LCD_MODEL_ADDRESS, size, bytes, 0);
+    I2C_Wait();
+    LCD_MODEL_Get(&counters);
+    TEST_CHECK(counters.earlyWrites == 1);
+    
+    LCD_MODEL_Reset();
+    size = test_byte(bytes, 0x01, 0);
+    I2C_WriteBlockAsync(LCD_MODEL_ADDRESS, size, bytes, 0);
+    I2C_Wait();
+    LCD_MODEL_Tick(TIMER_US(1520));
+    size = test_byte(bytes, 'A', 1);
+    I2C_WriteBlockAsync(LCD_MODEL_ADDRESS, size, bytes, 0);
+    I2C_Wait();
+    LCD_MODEL_Get(&counters);
+    TEST_CHECK(counters.earlyWrites == 0);
+    TEST_CHECK(LCD_MODEL_Char(0, 0) == 'A');
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief Clear display, return home and text right after them through
+ *        lcd1602.c: the text waits for the execution of the instruction.
+ */
+static void test_clear(void) {
+    LcdModelCounters counters;
+    uint64_t start = LCD_MODEL_Now();
+    
+    LCD_MODEL_Reset();
+    LCD1602_ClearAll();
+    LCD1602_Print("Mode 1");
+    LCD1602_SetCursor(0, 1);
+    LCD1602_Print("80 Hz-20 kHz");
+    LCD1602_ClearAll();
+    LCD1602_Print("x");
+    I2C_Wait();
+    LCD_MODEL_Get(&counters);
+    TEST_CHECK(counters.earlyWrites == 0);
+    TEST_CHECK(LCD_MODEL_Char(0, 0) == 'x' && LCD_MODEL_Char(0, 1) == ' ');
+    printf("clear and text: %.2f ms, bus %.2f ms, %lu early writes\n",
+           TEST_MS(LCD_MODEL_Now() - start), TEST_MS(counters.busCycles),
+           (unsigned long)counters.earlyWrites);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Draw the frames of a spectrum from an empty display and print
+ *            bus time per frame.
+ * @param[in] Spectrum (Test_Spectra)
+ */
+static void test_spectrum(uint8_t spectrum) {
+    LcdModelCounters counters;
+    uint64_t bus = 0, most = 0;
+    uint32_t early = 0;
+    
+    LCD1602_ClearAll();
+    DISPLAY_Reset();
+    I2C_Wait();
+    
+    for( uint32_t frame=0; frame<TEST_FRAMES; frame++ ) {
+        uint8_t levels[DISPLAY_COLUMNS];
+        
+        test_levels(spectrum, frame, levels);
+        LCD_MODEL_Reset();
+        DISPLAY_Submit(levels);
+        DISPLAY_Service();
+        I2C_Wait();
+        LCD_MODEL_Get(&counters);
+        
+        bus += counters.busCycles;
+        early += counters.earlyWrites;
+        if( counters.busCycles > most )
+            most = counters.busCycles;
+    }
+    TEST_CHECK(early == 0);
+    
+    printf("%-8s %12.3f %12.3f %11.1f%% %8lu\n", Test_Spectra[spectrum],
+           TEST_MS(bus)/TEST_FRAMES, TEST_MS(most),
+           100.0*TEST_MS(bus)/TEST_FRAMES*TEST_FRAME_RATE/1000, (unsigned long)early);
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Levels of a frame of a test spectrum.
+ * @param[in]  Spectrum (Test_Spectra)
+ * @param[in]  Frame number
+ * @param[out] Column levels: 0-16
+ */
+static void test_levels(uint8_t spectrum, uint32_t frame, uint8_t *levels) {
+    for( uint8_t i=0; i<DISPLAY_COLUMNS; i++ ) {
+        int32_t level;
+        
+        switch( spectrum ) {
+            case 0:
+                level = 14 - i*3/4;
+                break;
+            case 1:
+                level = 15 - i*3/4 + (int32_t)((frame/40 + i*7) % 5) - 2;
+                break;
+            case 2:
+                level = (i == (frame/25) % DISPLAY_COLUMNS) ? 15 : 3 + (i & 1);
+                break;
+            default:
+                level = rand() % (LEVEL_MAX + 1);
+                break;
+        }
+        levels[i] = (uint8_t)(level < 0 ? 0 : level > LEVEL_MAX ? LEVEL_MAX : level);
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief      Expander bytes of an LCD byte in 4-bit mode: EN high and EN low
+ *             for each nibble, backlight on.
+ * @param[out] Four expander bytes
+ * @param[in]  Data
+ * @param[in]  Register select
+ * @return     Number of bytes: 4
+ */
+static uint8_t test_byte(uint8_t *bytes, uint8_t data, uint8_t rs) {
+    uint8_t size = 0;
+    
+    for( uint8_t half=0; half<2; half++ ) {
+        uint8_t out = (uint8_t)((half ? data << 4 : data) & 0xF0) | TEST_BL |
+                      (rs ? TEST_RS : 0x00);
+        
+        bytes[size++] = out | TEST_EN;
+        bytes[size++] = out;
+    }
+    return size;
+}
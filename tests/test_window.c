@@ -0,0 +1,121 @@
+/******************************************************************************
+ * This file is a part of the Sysytem Microprocessor Project                  *
+ ******************************************************************************/
+
+/**
+ * @file   test_window.c
+ * @author Maj & Zimnol
+ * @date   Dec 2021
+ * @brief  Host test of window tables: every coefficient of the tables made by
+ *         the compiler from the WIN_ macros (Taylor series of cos) must be
+ *         within 1 LSB of the closed form calculated with cos() of the C
+ *         library, for both halves of the window. Runtime selection (key 
+ *         SW11) must go over all windows and come back to the first one.
+ * @ver    0.1
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "window.h"
+
+/******************************************************************************
+ * Private definitions
+ ******************************************************************************/
+
+/* largest allowed difference from the closed form */
+#define TEST_MAX_LSB             (1)
+/* reports a failed check and counts it */
+#define TEST_CHECK(x)            do { if( !(x) ) { test_failed++;               \
+                                      printf("failed: %s (line %d)\n", #x,     \
+                                             __LINE__); } } while(0)
+
+/******************************************************************************
+ * Private memory declarations
+ ******************************************************************************/
+
+static const char *Test_Names[WINDOW_COUNT] = {"Hann", "Blackman-Harris", "Flat top",
+    "Rectangular"};
+
+static uint32_t test_failed = 0;
+
+/******************************************************************************
+ * Private prototypes
+ ******************************************************************************/
+
+static double test_window(WindowType type, uint16_t n);
+static int32_t test_q15(double x);
+
+/******************************************************************************
+ * Function definitions
+ ******************************************************************************/
+
+int main(void) {
+    WindowType first = WINDOW_Get();
+    
+    printf("%-16s %10s %10s\n", "window", "max LSB", "coeffs");
+    for( uint8_t type=0; type<WINDOW_COUNT; type++ ) {
+        int32_t most = 0;
+        
+        WINDOW_Select((WindowType)type);
+        TEST_CHECK(WINDOW_Get() == type);
+        for( uint16_t n=0; n<FFT_SIZE; n++ ) {
+            int32_t diff = abs(WINDOW_Coeff(n) - test_q15(test_window((WindowType)type, n)));
+            
+            if( diff > most )
+                most = diff;
+            if( diff > TEST_MAX_LSB )
+                printf("%s n %d: %d instead of %ld\n", Test_Names[type], n, WINDOW_Coeff(n),
+                       (long)test_q15(test_window((WindowType)type, n)));
+        }
+        TEST_CHECK(most <= TEST_MAX_LSB);
+        printf("%-16s %10ld %10d\n", Test_Names[type], (long)most, FFT_SIZE);
+    }
+    
+    /* the key selects the next window, after the last one the first again */
+    WINDOW_Select(first);
+    for( uint8_t i=0; i<WINDOW_COUNT; i++ )
+        WINDOW_Select((WindowType)((WINDOW_Get() + 1) % WINDOW_COUNT));
+    TEST_CHECK(WINDOW_Get() == first);
+    /* unknown types are ignored */
+    WINDOW_Select(WINDOW_COUNT);
+    TEST_CHECK(WINDOW_Get() == first);
+    
+    printf("test_window (size %d): %lu failed\n", FFT_SIZE, (unsigned long)test_failed);
+    
+    return test_failed ? 1 : 0;
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Closed form of a symmetric window, the same coefficients as in
+ *            window.c.
+ * @param[in] Window type
+ * @param[in] Sample number: 0 to FFT_SIZE-1
+ * @return    Window value
+ */
+static double test_window(WindowType type, uint16_t n) {
+    double x = 2*M_PI*n/(FFT_SIZE-1);
+    
+    switch( type ) {
+        case WINDOW_HANN:
+            return 0.5 - 0.5*cos(x);
+        case WINDOW_BLACKMAN_HARRIS:
+            return 0.35875 - 0.48829*cos(x) + 0.14128*cos(2*x) - 0.01168*cos(3*x);
+        case WINDOW_FLAT_TOP:
+            return 0.21557895 - 0.41663158*cos(x) + 0.277263158*cos(2*x)
+                   - 0.083578947*cos(3*x) + 0.006947368*cos(4*x);
+        default:
+            return 1.0;
+    }
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief     Real value to Q15 with rounding and saturation.
+ * @param[in] Value
+ * @return    Value in Q15 format
+ */
+static int32_t test_q15(double x) {
+    int32_t q = (int32_t)lround(x*32768);
+    
+    return q > 32767 ? 32767 : q < -32768 ? -32768 : q;
+}